@@ -0,0 +1,264 @@
+#include <cstring>
+
+#include "AffineTransform.h"
+#include "gcf.h"
+#include "Ray.h"
+#include "Transform.h"
+
+const AffineTransform AffineTransform::Identity;
+
+// r = a*b for affine 3x4 blocks, summation order matches multiply(Matrix4x4, Matrix4x4)
+inline void multiplyAffine(const double a[3][4], const double b[3][4], double r[3][4])
+{
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j)
+            r[i][j] = a[i][0]*b[0][j] + a[i][1]*b[1][j] + a[i][2]*b[2][j];
+        r[i][3] = a[i][0]*b[0][3] + a[i][1]*b[1][3] + a[i][2]*b[2][3] + a[i][3];
+    }
+}
+
+AffineTransform::AffineTransform()
+{
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 4; ++j)
+            m_mdir[i][j] = m_minv[i][j] = i == j ? 1. : 0.;
+}
+
+AffineTransform::AffineTransform(const double mdir[3][4], const double minv[3][4])
+{
+    memcpy(m_mdir, mdir, 12*sizeof(double));
+    memcpy(m_minv, minv, 12*sizeof(double));
+}
+
+AffineTransform::AffineTransform(const double mdir[3][4])
+{
+    memcpy(m_mdir, mdir, 12*sizeof(double));
+
+    // inverse of the linear part from the cofactors, then of the translation
+    const double (&m)[3][4] = m_mdir;
+    double c00 = m[1][1]*m[2][2] - m[1][2]*m[2][1];
+    double c01 = m[1][2]*m[2][0] - m[1][0]*m[2][2];
+    double c02 = m[1][0]*m[2][1] - m[1][1]*m[2][0];
+    double detInv = 1./(m[0][0]*c00 + m[0][1]*c01 + m[0][2]*c02);
+
+    m_minv[0][0] = c00*detInv;
+    m_minv[0][1] = (m[0][2]*m[2][1] - m[0][1]*m[2][2])*detInv;
+    m_minv[0][2] = (m[0][1]*m[1][2] - m[0][2]*m[1][1])*detInv;
+    m_minv[1][0] = c01*detInv;
+    m_minv[1][1] = (m[0][0]*m[2][2] - m[0][2]*m[2][0])*detInv;
+    m_minv[1][2] = (m[0][2]*m[1][0] - m[0][0]*m[1][2])*detInv;
+    m_minv[2][0] = c02*detInv;
+    m_minv[2][1] = (m[0][1]*m[2][0] - m[0][0]*m[2][1])*detInv;
+    m_minv[2][2] = (m[0][0]*m[1][1] - m[0][1]*m[1][0])*detInv;
+    for (int i = 0; i < 3; ++i)
+        m_minv[i][3] = -(m_minv[i][0]*m[0][3] + m_minv[i][1]*m[1][3] + m_minv[i][2]*m[2][3]);
+}
+
+AffineTransform::AffineTransform(const Transform& t):
+    AffineTransform()
+{
+    if (!t.m_mdir) return;
+    memcpy(m_mdir, t.m_mdir->m, 12*sizeof(double));
+    memcpy(m_minv, t.m_minv->m, 12*sizeof(double));
+}
+
+Transform AffineTransform::toTransform() const
+{
+    auto mdir = std::make_shared<Matrix4x4>();
+    auto minv = std::make_shared<Matrix4x4>();
+    memcpy(mdir->m, m_mdir, 12*sizeof(double));
+    memcpy(minv->m, m_minv, 12*sizeof(double));
+    return Transform(mdir, minv);
+}
+
+vec3d AffineTransform::getScales() const
+{
+    return vec3d(
+        vec3d(m_mdir[0][0], m_mdir[1][0], m_mdir[2][0]).norm(),
+        vec3d(m_mdir[0][1], m_mdir[1][1], m_mdir[2][1]).norm(),
+        vec3d(m_mdir[0][2], m_mdir[1][2], m_mdir[2][2]).norm()
+    );
+}
+
+bool AffineTransform::SwapsHandedness() const
+{
+    double det =
+        m_mdir[0][0]*(m_mdir[1][1]*m_mdir[2][2] - m_mdir[1][2]*m_mdir[2][1]) -
+        m_mdir[0][1]*(m_mdir[1][0]*m_mdir[2][2] - m_mdir[1][2]*m_mdir[2][0]) +
+        m_mdir[0][2]*(m_mdir[1][0]*m_mdir[2][1] - m_mdir[1][1]*m_mdir[2][0]);
+    return det < 0.;
+}
+
+AffineTransform AffineTransform::operator*(const AffineTransform& t) const
+{
+    AffineTransform ans;
+    multiplyAffine(m_mdir, t.m_mdir, ans.m_mdir);
+    multiplyAffine(t.m_minv, m_minv, ans.m_minv);
+    return ans;
+}
+
+vec3d AffineTransform::transformNormal(const vec3d& n) const
+{
+    return vec3d(
+        m_minv[0][0]*n.x + m_minv[1][0]*n.y + m_minv[2][0]*n.z,
+        m_minv[0][1]*n.x + m_minv[1][1]*n.y + m_minv[2][1]*n.z,
+        m_minv[0][2]*n.x + m_minv[1][2]*n.y + m_minv[2][2]*n.z
+    );
+}
+
+vec3d AffineTransform::transformInverseNormal(const vec3d& n) const
+{
+    return vec3d(
+        m_mdir[0][0]*n.x + m_mdir[1][0]*n.y + m_mdir[2][0]*n.z,
+        m_mdir[0][1]*n.x + m_mdir[1][1]*n.y + m_mdir[2][1]*n.z,
+        m_mdir[0][2]*n.x + m_mdir[1][2]*n.y + m_mdir[2][2]*n.z
+    );
+}
+
+Ray AffineTransform::transformDirect(const Ray& r) const
+{
+    return Ray(transformPoint(r.origin), transformVector(r.direction()), r.tMin, r.tMax);
+}
+
+Ray AffineTransform::transformInverse(const Ray& r) const
+{
+    return inversed().transformDirect(r);
+}
+
+Ray AffineTransform::operator()(const Ray& r) const
+{
+    return transformDirect(r);
+}
+
+bool AffineTransform::operator==(const AffineTransform& t) const
+{
+    if (this == &t) return true;
+
+    for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 4; ++j)
+            if (!gcf::equals(m_mdir[i][j], t.m_mdir[i][j]))
+                return false;
+
+    return true;
+}
+
+AffineTransform AffineTransform::translate(double x, double y, double z)
+{
+    double mdir[3][4] = {
+        {1., 0., 0., x},
+        {0., 1., 0., y},
+        {0., 0., 1., z}
+    };
+
+    double minv[3][4] = {
+        {1., 0., 0., -x},
+        {0., 1., 0., -y},
+        {0., 0., 1., -z}
+    };
+
+    return AffineTransform(mdir, minv);
+}
+
+AffineTransform AffineTransform::scale(double sx, double sy, double sz)
+{
+    double mdir[3][4] = {
+        {sx, 0., 0., 0.},
+        {0., sy, 0., 0.},
+        {0., 0., sz, 0.}
+    };
+
+    double minv[3][4] = {
+        {1./sx, 0., 0., 0.},
+        {0., 1./sy, 0., 0.},
+        {0., 0., 1./sz, 0.}
+    };
+
+    return AffineTransform(mdir, minv);
+}
+
+// rotation matrix r, its inverse is the transpose
+AffineTransform AffineTransform::fromRotation(const double r[3][3])
+{
+    AffineTransform ans;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            ans.m_mdir[i][j] = r[i][j];
+            ans.m_minv[i][j] = r[j][i];
+        }
+        ans.m_mdir[i][3] = 0.;
+        ans.m_minv[i][3] = 0.;
+    }
+    return ans;
+}
+
+// angle in radians
+AffineTransform AffineTransform::rotateX(double angle)
+{
+    double c = cos(angle);
+    double s = sin(angle);
+
+    double r[3][3] = {
+        {1., 0., 0.},
+        {0., c, -s},
+        {0., s, c}
+    };
+
+    return fromRotation(r);
+}
+
+AffineTransform AffineTransform::rotateY(double angle)
+{
+    double c = cos(angle);
+    double s = sin(angle);
+
+    double r[3][3] = {
+        {c, 0., s},
+        {0., 1., 0.},
+        {-s, 0., c}
+    };
+
+    return fromRotation(r);
+}
+
+AffineTransform AffineTransform::rotateZ(double angle)
+{
+    double c = cos(angle);
+    double s = sin(angle);
+
+    double r[3][3] = {
+        {c, -s, 0.},
+        {s,  c, 0.},
+        {0., 0., 1.}
+    };
+
+    return fromRotation(r);
+}
+
+AffineTransform AffineTransform::rotate(double angle, const vec3d& axis)
+{
+    vec3d a = axis.normalized();
+    double s = sin(angle);
+    double c = cos(angle);
+    double d = 1. - c;
+    double r[3][3];
+
+    r[0][0] = a.x*a.x*d + c;
+    r[0][1] = a.x*a.y*d - a.z*s;
+    r[0][2] = a.x*a.z*d + a.y*s;
+
+    r[1][0] = a.y*a.x*d + a.z*s;
+    r[1][1] = a.y*a.y*d + c;
+    r[1][2] = a.y*a.z*d - a.x*s;
+
+    r[2][0] = a.z*a.x*d - a.y*s;
+    r[2][1] = a.z*a.y*d + a.x*s;
+    r[2][2] = a.z*a.z*d + c;
+
+    return fromRotation(r);
+}
+
+std::ostream& operator<<(std::ostream& os, const AffineTransform& t)
+{
+    os << t.toTransform();
+    return os;
+}
@@ -0,0 +1,288 @@
+#include "AnnualSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "gcf.h"
+
+namespace {
+
+// queue between two pipeline stages, pop returns false once the queue is closed and empty
+template<class T>
+class StageQueue
+{
+public:
+    void push(T value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.push_back(value);
+        m_ready.notify_one();
+    }
+
+    bool pop(T& value)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_ready.wait(lock, [this] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) return false;
+        value = m_items.front();
+        m_items.pop_front();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+        m_ready.notify_all();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::deque<T> m_items;
+    bool m_closed = false;
+};
+
+// converts angles to lengths with one batch per run of heliostats with the same model, NaN without a model
+template<class Model, class Convert>
+void convertRuns(const std::vector<const Model*>& models, const double* angles, double* lengths, Convert convert)
+{
+    for (std::size_t a = 0; a < models.size();) {
+        std::size_t b = a + 1;
+        while (b < models.size() && models[b] == models[a])
+            ++b;
+        if (models[a])
+            convert(models[a], b - a, angles + a, lengths + a);
+        else
+            std::fill(lengths + a, lengths + b, std::numeric_limits<double>::quiet_NaN());
+        a = b;
+    }
+}
+
+struct Chunk
+{
+    std::uint64_t index;
+    std::size_t steps;
+    std::vector<double> times;
+    std::vector<double> sunVectors;
+    std::vector<float> values; // column c of step j and heliostat i at (c*steps + j)*heliostats + i
+};
+
+}
+
+AnnualSimulation::AnnualSimulation(HeliostatField* field, const SunPositionEngine& engine):
+    m_field(field),
+    m_engine(engine),
+    m_timeStart(0.),
+    m_timeEnd(0.),
+    m_step(3600.),
+    m_modelsShared(true),
+    m_chunkSteps(64)
+{
+
+}
+
+void AnnualSimulation::set_timeRange(double timeStart, double timeEnd, double step)
+{
+    if (!(step > 0.) || !(timeStart <= timeEnd))
+        throw std::invalid_argument("AnnualSimulation: invalid time range");
+    m_timeStart = timeStart;
+    m_timeEnd = timeEnd;
+    m_step = step;
+}
+
+std::size_t AnnualSimulation::get_steps() const
+{
+    // the small margin keeps timeEnd when the range is a multiple of the step
+    return std::size_t(std::floor((m_timeEnd - m_timeStart)/m_step + 1e-9)) + 1;
+}
+
+void AnnualSimulation::set_actuatorModels(const ElevationAngleKM* elevation, const HourAngleKM* hour)
+{
+    if (!elevation != !hour)
+        throw std::invalid_argument("AnnualSimulation: set both actuator models or none");
+    m_elevations.clear();
+    m_hours.clear();
+    if (elevation) {
+        m_elevations.push_back(elevation);
+        m_hours.push_back(hour);
+    }
+    m_modelsShared = true;
+}
+
+void AnnualSimulation::set_actuatorModels(const std::vector<const ElevationAngleKM*>& elevations,
+                                          const std::vector<const HourAngleKM*>& hours)
+{
+    if (elevations.size() != hours.size())
+        throw std::invalid_argument("AnnualSimulation: one elevation and one hour model per heliostat");
+    for (std::size_t i = 0; i < elevations.size(); ++i)
+        if (!elevations[i] != !hours[i])
+            throw std::invalid_argument("AnnualSimulation: set both actuator models or none");
+    m_elevations = elevations;
+    m_hours = hours;
+    m_modelsShared = false;
+}
+
+void AnnualSimulation::set_chunkSteps(std::size_t chunkSteps)
+{
+    if (chunkSteps == 0)
+        throw std::invalid_argument("AnnualSimulation: chunkSteps must be positive");
+    m_chunkSteps = chunkSteps;
+}
+
+void AnnualSimulation::run(const std::string& fileName)
+{
+    // models per heliostat
+    std::vector<const ElevationAngleKM*> elevations = m_elevations;
+    std::vector<const HourAngleKM*> hours = m_hours;
+    if (m_modelsShared && !m_elevations.empty()) {
+        elevations.assign(m_field->size(), m_elevations[0]);
+        hours.assign(m_field->size(), m_hours[0]);
+    } else if (!m_modelsShared && m_elevations.size() != m_field->size())
+        throw std::invalid_argument("AnnualSimulation: the actuator models do not match the heliostats of the field");
+    const bool lengths = !elevations.empty();
+
+    SimulationFileHeader header;
+    std::memcpy(header.magic, SimulationFileHeader::Magic, sizeof(header.magic));
+    header.version = SimulationFileHeader::Version;
+    header.columns = lengths ? 4 : 2;
+    header.heliostats = m_field->size();
+    header.steps = get_steps();
+    header.chunkSteps = m_chunkSteps;
+    header.timeStart = m_timeStart;
+    header.step = m_step;
+    header.longitude = m_engine.get_longitude();
+    header.latitude = m_engine.get_latitude();
+
+    ResultStore store;
+    store.create(fileName, header);
+
+    const std::size_t heliostats = m_field->size();
+    const std::size_t columns = header.columns;
+    const std::uint64_t chunks = header.chunks();
+
+    // three buffers: one filled with sun vectors, one solved and one written at a time
+    std::vector<Chunk> buffers(3);
+    StageQueue<Chunk*> freeQueue, solveQueue, writeQueue;
+    for (Chunk& chunk : buffers) {
+        chunk.times.resize(m_chunkSteps);
+        chunk.sunVectors.resize(3*m_chunkSteps);
+        chunk.values.resize(columns*m_chunkSteps*heliostats);
+        freeQueue.push(&chunk);
+    }
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = e;
+        }
+        freeQueue.close();
+        solveQueue.close();
+        writeQueue.close();
+    };
+
+    std::thread sunStage([&] {
+        try {
+            for (std::uint64_t k = 0; k < chunks; ++k) {
+                Chunk* chunk;
+                if (!freeQueue.pop(chunk)) return;
+                chunk->index = k;
+                chunk->steps = std::size_t(std::min<std::uint64_t>(m_chunkSteps, header.steps - k*m_chunkSteps));
+                for (std::size_t j = 0; j < chunk->steps; ++j)
+                    chunk->times[j] = m_timeStart + double(k*m_chunkSteps + j)*m_step;
+                m_engine.findSunVectors(chunk->steps, chunk->times.data(), chunk->sunVectors.data());
+                solveQueue.push(chunk);
+            }
+            solveQueue.close();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    std::thread writeStage([&] {
+        try {
+            Chunk* chunk;
+            while (writeQueue.pop(chunk)) {
+                std::uint64_t k = chunk->index;
+                std::size_t n = chunk->steps;
+                std::copy(chunk->times.begin(), chunk->times.begin() + n, store.times(k));
+                std::copy(chunk->sunVectors.begin(), chunk->sunVectors.begin() + 3*n, store.sunVectors(k));
+                for (std::size_t c = 0; c < columns; ++c) {
+                    const float* values = chunk->values.data() + c*n*heliostats;
+                    std::copy(values, values + n*heliostats, store.column(k, SimulationFileHeader::Column(c)));
+                }
+                freeQueue.push(chunk);
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    });
+
+    // the field updates run on this thread and the thread pool of the field
+    try {
+        std::vector<double> angles(heliostats), lengthValues(heliostats);
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        Chunk* chunk;
+        while (solveQueue.pop(chunk)) {
+            std::size_t n = chunk->steps;
+            for (std::size_t j = 0; j < n; ++j) {
+                float* values = chunk->values.data() + j*heliostats;
+                const double* s = &chunk->sunVectors[3*j];
+                if (!(s[2] > 0.)) {
+                    // the first step after sunrise starts cold
+                    for (std::size_t i = 0; i < heliostats; ++i)
+                        m_field->get_target(i).resetTracking();
+                    for (std::size_t c = 0; c < columns; ++c)
+                        std::fill(values + c*n*heliostats, values + c*n*heliostats + heliostats, nan);
+                    continue;
+                }
+                m_field->update(vec3d(s[0], s[1], s[2]));
+                const std::vector<double>& fieldAngles = m_field->get_angles();
+                for (std::size_t i = 0; i < heliostats; ++i) {
+                    values[i] = float(fieldAngles[2*i]);
+                    values[n*heliostats + i] = float(fieldAngles[2*i + 1]);
+                }
+                if (!lengths) continue;
+
+                for (std::size_t i = 0; i < heliostats; ++i)
+                    angles[i] = fieldAngles[2*i]*gcf::degree;
+                convertRuns(elevations, angles.data(), lengthValues.data(),
+                            [](const ElevationAngleKM* model, std::size_t count, const double* a, double* l) {
+                                model->getActuatorLengthsFromElevationAngles(count, a, l);
+                            });
+                for (std::size_t i = 0; i < heliostats; ++i)
+                    values[2*n*heliostats + i] = float(lengthValues[i]);
+
+                for (std::size_t i = 0; i < heliostats; ++i)
+                    angles[i] = fieldAngles[2*i + 1]*gcf::degree;
+                convertRuns(hours, angles.data(), lengthValues.data(),
+                            [](const HourAngleKM* model, std::size_t count, const double* a, double* l) {
+                                model->getActuatorLengthsFromHourAngles(count, a, l);
+                            });
+                for (std::size_t i = 0; i < heliostats; ++i)
+                    values[3*n*heliostats + i] = float(lengthValues[i]);
+            }
+            writeQueue.push(chunk);
+        }
+        writeQueue.close();
+    } catch (...) {
+        fail(std::current_exception());
+    }
+
+    sunStage.join();
+    writeStage.join();
+    if (error)
+        std::rethrow_exception(error);
+    store.flush();
+}
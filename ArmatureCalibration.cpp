@@ -0,0 +1,416 @@
+#include "ArmatureCalibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "gcf.h"
+
+namespace {
+
+const int parametersMax = 17;
+
+// kinematic model of an actuator with the parameters being fitted,
+// alpha2 is zero for the hour model
+struct Actuator
+{
+    bool elevation;
+    double gamma;
+    double rab;
+    double rbc;
+    double rad;
+    double alpha2;
+    double offset;
+
+    // angle for the actuator length and its derivatives over rbc, rad and offset,
+    // false out of range (and at the limits, where the derivatives are infinite)
+    bool angle(double length, double& ans, double* derivatives) const
+    {
+        double c0 = rab*rab + rad*rad - rbc*rbc;
+        double c1 = 2.*rab*rad;
+        double x = length + offset;
+        double u = (x*x - c0)/c1;
+        if (!(std::abs(u) < 1.)) return false;
+        double g = 1./std::sqrt(1. - u*u);
+        if (elevation) {
+            ans = alpha2 - gamma + std::acos(u);
+            g = -g;
+        } else
+            ans = gamma + std::asin(u);
+        derivatives[0] = g*2.*rbc/c1;
+        derivatives[1] = g*(-2.*rad - 2.*rab*u)/c1;
+        derivatives[2] = g*2.*x/c1;
+        return true;
+    }
+};
+
+// parameters of one heliostat, the axes are unit vectors and the angle offsets are in radians
+struct State
+{
+    vec3d primaryShift;
+    vec3d secondaryShift;
+    vec3d a;
+    vec3d b;
+    vec3d facetShift;
+    vec3d facetNormal;
+    double primaryOffset;
+    double secondaryOffset;
+    Actuator primary;
+    Actuator secondary;
+};
+
+// positions of the parameter groups in the parameter vector, -1 if not fitted
+struct Layout
+{
+    int shifts = -1; // primary shift (3), secondary shift across a (2)
+    int axes = -1; // tilts of a (2) and b (2)
+    int offsets = -1; // primary and secondary angle offsets
+    int models = -1; // rbc, rad and offset of the primary and secondary actuators
+    int size = 0;
+};
+
+// normal equations of the linearized problem, lower triangle of jtj
+struct Normal
+{
+    double jtj[parametersMax][parametersMax];
+    double jtr[parametersMax];
+};
+
+// unit vectors across the unit vector a
+void tangents(const vec3d& a, vec3d& u, vec3d& v)
+{
+    vec3d t = std::abs(a.x) < 0.9 ? vec3d::UnitX : vec3d::UnitY;
+    u = cross(a, t).normalized();
+    v = cross(a, u);
+}
+
+// rotation of v around the unit axis a, with c and s the cosine and sine of the angle
+vec3d rotate(const vec3d& a, double c, double s, const vec3d& v)
+{
+    return v*c + cross(a, v)*s + a*(dot(a, v)*(1. - c));
+}
+
+// derivative of rotate for a tilt of the axis a towards the unit vector u across a
+vec3d rotateTilt(const vec3d& a, const vec3d& u, double c, double s, const vec3d& v)
+{
+    return cross(u, v)*s + u*(dot(a, v)*(1. - c)) + a*(dot(u, v)*(1. - c));
+}
+
+// primary and secondary angles of an observation in radians, with the derivatives over the actuator models
+bool observedAngles(const State& s, bool models, const CalibrationObservation& o,
+                    double& alpha, double& beta, double* dAlpha, double* dBeta)
+{
+    if (models) {
+        if (!s.primary.angle(o.input.x, alpha, dAlpha) || !s.secondary.angle(o.input.y, beta, dBeta))
+            return false;
+    } else {
+        alpha = o.input.x*gcf::degree;
+        beta = o.input.y*gcf::degree;
+    }
+    alpha += s.primaryOffset;
+    beta += s.secondaryOffset;
+    return std::isfinite(alpha) && std::isfinite(beta);
+}
+
+// Sum of the squared residuals over the used observations, NaN if one of them gets out of range.
+// The normal equations are accumulated if normal is given.
+double evaluate(const State& s, const CalibrationProblem& problem, const std::vector<char>& used,
+                const Layout& layout, Normal* normal)
+{
+    bool models = problem.elevation != nullptr;
+    vec3d ua, va, ub, vb;
+    tangents(s.a, ua, va);
+    tangents(s.b, ub, vb);
+    if (normal) {
+        for (int i = 0; i < layout.size; ++i) {
+            normal->jtr[i] = 0.;
+            for (int j = 0; j <= i; ++j)
+                normal->jtj[i][j] = 0.;
+        }
+    }
+
+    double cost = 0.;
+    vec3d J[parametersMax];
+    for (std::size_t k = 0; k < problem.count; ++k) {
+        if (!used[k]) continue;
+        const CalibrationObservation& o = problem.observations[k];
+        double alpha, beta, dAlpha[3], dBeta[3];
+        if (!observedAngles(s, models, o, alpha, beta, dAlpha, dBeta))
+            return std::numeric_limits<double>::quiet_NaN();
+
+        // p = primaryShift + Ra(secondaryShift + Rb facetShift), n = Ra Rb facetNormal
+        double ca = std::cos(alpha), sa = std::sin(alpha);
+        double cb = std::cos(beta), sb = std::sin(beta);
+        vec3d f = rotate(s.b, cb, sb, s.facetShift);
+        vec3d m = rotate(s.b, cb, sb, s.facetNormal);
+        vec3d w = s.secondaryShift + f;
+        vec3d pw = rotate(s.a, ca, sa, w);
+        vec3d n = rotate(s.a, ca, sa, m);
+        vec3d p = s.primaryShift + pw;
+
+        double ns = dot(n, o.vSun);
+        vec3d d = 2.*ns*n - o.vSun;
+        vec3d e = o.beam - p;
+        vec3d r = cross(d, e);
+        cost += r.norm2();
+        if (!normal) continue;
+
+        // derivative of the residual for the derivatives dp and dn of the facet point and normal
+        auto column = [&](const vec3d& dp, const vec3d& dn) {
+            vec3d dd = 2.*(dot(dn, o.vSun)*n + ns*dn);
+            return cross(dd, e) - cross(d, dp);
+        };
+        vec3d jAlpha = column(cross(s.a, pw), cross(s.a, n));
+        vec3d bRotated = rotate(s.a, ca, sa, s.b);
+        vec3d jBeta = column(cross(bRotated, rotate(s.a, ca, sa, f)), cross(bRotated, n));
+
+        if (layout.shifts >= 0) {
+            int i = layout.shifts;
+            J[i] = -cross(d, vec3d::UnitX);
+            J[i + 1] = -cross(d, vec3d::UnitY);
+            J[i + 2] = -cross(d, vec3d::UnitZ);
+            J[i + 3] = -cross(d, rotate(s.a, ca, sa, ua));
+            J[i + 4] = -cross(d, rotate(s.a, ca, sa, va));
+        }
+        if (layout.axes >= 0) {
+            int i = layout.axes;
+            J[i] = column(rotateTilt(s.a, ua, ca, sa, w), rotateTilt(s.a, ua, ca, sa, m));
+            J[i + 1] = column(rotateTilt(s.a, va, ca, sa, w), rotateTilt(s.a, va, ca, sa, m));
+            J[i + 2] = column(rotate(s.a, ca, sa, rotateTilt(s.b, ub, cb, sb, s.facetShift)),
+                              rotate(s.a, ca, sa, rotateTilt(s.b, ub, cb, sb, s.facetNormal)));
+            J[i + 3] = column(rotate(s.a, ca, sa, rotateTilt(s.b, vb, cb, sb, s.facetShift)),
+                              rotate(s.a, ca, sa, rotateTilt(s.b, vb, cb, sb, s.facetNormal)));
+        }
+        if (layout.offsets >= 0) {
+            J[layout.offsets] = jAlpha;
+            J[layout.offsets + 1] = jBeta;
+        }
+        if (layout.models >= 0) {
+            for (int i = 0; i < 3; ++i) {
+                J[layout.models + i] = jAlpha*dAlpha[i];
+                J[layout.models + 3 + i] = jBeta*dBeta[i];
+            }
+        }
+
+        for (int i = 0; i < layout.size; ++i) {
+            normal->jtr[i] += dot(J[i], r);
+            for (int j = 0; j <= i; ++j)
+                normal->jtj[i][j] += dot(J[i], J[j]);
+        }
+    }
+    return cost;
+}
+
+State applyStep(const State& s, const Layout& layout, const double* delta)
+{
+    State ans = s;
+    if (layout.shifts >= 0) {
+        const double* x = delta + layout.shifts;
+        vec3d u, v;
+        tangents(s.a, u, v);
+        ans.primaryShift += vec3d(x[0], x[1], x[2]);
+        ans.secondaryShift += u*x[3] + v*x[4];
+    }
+    if (layout.axes >= 0) {
+        const double* x = delta + layout.axes;
+        vec3d u, v;
+        tangents(s.a, u, v);
+        ans.a = (s.a + u*x[0] + v*x[1]).normalized();
+        tangents(s.b, u, v);
+        ans.b = (s.b + u*x[2] + v*x[3]).normalized();
+    }
+    if (layout.offsets >= 0) {
+        ans.primaryOffset += delta[layout.offsets];
+        ans.secondaryOffset += delta[layout.offsets + 1];
+    }
+    if (layout.models >= 0) {
+        const double* x = delta + layout.models;
+        ans.primary.rbc += x[0];
+        ans.primary.rad += x[1];
+        ans.primary.offset += x[2];
+        ans.secondary.rbc += x[3];
+        ans.secondary.rad += x[4];
+        ans.secondary.offset += x[5];
+    }
+    return ans;
+}
+
+// Solves (jtj + lambda*diag(jtj)) x = -jtr by Cholesky decomposition, false if not positive definite.
+// Small diagonal entries are raised to a fraction of the largest one.
+bool solveDamped(const Normal& normal, int size, double lambda, double* x)
+{
+    double a[parametersMax][parametersMax];
+    double diagonalMax = 0.;
+    for (int i = 0; i < size; ++i)
+        diagonalMax = std::max(diagonalMax, normal.jtj[i][i]);
+    double diagonalMin = 1e-9*diagonalMax;
+    for (int i = 0; i < size; ++i) {
+        for (int j = 0; j < i; ++j)
+            a[i][j] = normal.jtj[i][j];
+        a[i][i] = normal.jtj[i][i] + lambda*std::max(normal.jtj[i][i], diagonalMin);
+    }
+
+    // a = L L^T in the lower triangle
+    for (int j = 0; j < size; ++j) {
+        double s = a[j][j];
+        for (int k = 0; k < j; ++k)
+            s -= a[j][k]*a[j][k];
+        if (!(s > 0.)) return false;
+        a[j][j] = std::sqrt(s);
+        for (int i = j + 1; i < size; ++i) {
+            double t = a[i][j];
+            for (int k = 0; k < j; ++k)
+                t -= a[i][k]*a[j][k];
+            a[i][j] = t/a[j][j];
+        }
+    }
+
+    for (int i = 0; i < size; ++i) {
+        double t = -normal.jtr[i];
+        for (int k = 0; k < i; ++k)
+            t -= a[i][k]*x[k];
+        x[i] = t/a[i][i];
+    }
+    for (int i = size - 1; i >= 0; --i) {
+        double t = x[i];
+        for (int k = i + 1; k < size; ++k)
+            t -= a[k][i]*x[k];
+        x[i] = t/a[i][i];
+    }
+    return true;
+}
+
+}
+
+ArmatureCalibration::ArmatureCalibration(int threads):
+    m_parameters(all),
+    m_iterationsMax(50),
+    m_tolerance(1e-10),
+    m_pool(new ThreadPool(threads))
+{
+
+}
+
+void ArmatureCalibration::set_threads(int threads)
+{
+    m_pool.reset(new ThreadPool(threads));
+}
+
+CalibrationResult ArmatureCalibration::calibrate(const CalibrationProblem& problem) const
+{
+    if (!problem.armature)
+        throw std::invalid_argument("ArmatureCalibration: no armature");
+    if ((problem.elevation == nullptr) != (problem.hour == nullptr))
+        throw std::invalid_argument("ArmatureCalibration: both actuator models are needed");
+    if (problem.count > 0 && !problem.observations)
+        throw std::invalid_argument("ArmatureCalibration: no observations");
+    bool models = problem.elevation != nullptr;
+
+    const CompiledArmature2A& c = problem.armature->get_compiled();
+    State state;
+    state.primaryShift = c.primaryShift;
+    state.secondaryShift = c.secondaryShift;
+    state.a = c.a;
+    state.b = c.b;
+    state.facetShift = c.facetShift;
+    state.facetNormal = c.facetNormal;
+    state.primaryOffset = 0.;
+    state.secondaryOffset = 0.;
+    state.primary = Actuator{true, 0., 1., 0., 1., 0., 0.};
+    state.secondary = Actuator{false, 0., 1., 0., 1., 0., 0.};
+    if (models) {
+        const ElevationAngleKM& e = *problem.elevation;
+        const HourAngleKM& h = *problem.hour;
+        state.primary = Actuator{true, e.get_gamma(), e.get_rab(), e.get_rbc(), e.get_rad(), e.get_alpha2(), e.get_offset()};
+        state.secondary = Actuator{false, h.get_gamma(), h.get_rab(), h.get_rbc(), h.get_rad(), 0., h.get_offset()};
+    }
+
+    Layout layout;
+    if (m_parameters & shifts) {
+        layout.shifts = layout.size;
+        layout.size += 5;
+    }
+    if (m_parameters & axes) {
+        layout.axes = layout.size;
+        layout.size += 4;
+    }
+    if (m_parameters & angleOffsets) {
+        layout.offsets = layout.size;
+        layout.size += 2;
+    }
+    if (models && (m_parameters & actuatorModels)) {
+        layout.models = layout.size;
+        layout.size += 6;
+    }
+
+    // observations out of the actuator ranges of the nominal models are skipped
+    std::vector<char> used(problem.count, 0);
+    std::size_t count = 0;
+    for (std::size_t k = 0; k < problem.count; ++k) {
+        const CalibrationObservation& o = problem.observations[k];
+        double alpha, beta, dAlpha[3], dBeta[3];
+        bool ok = observedAngles(state, models, o, alpha, beta, dAlpha, dBeta);
+        ok = ok && std::isfinite(o.vSun.norm2()) && std::isfinite(o.beam.norm2());
+        used[k] = ok ? 1 : 0;
+        if (ok) ++count;
+    }
+
+    Normal normal;
+    double cost = evaluate(state, problem, used, layout, &normal);
+    CalibrationResult ans;
+    ans.observations = count;
+    ans.rmsStart = count > 0 ? std::sqrt(cost/count) : 0.;
+    ans.iterations = 0;
+    ans.converged = count == 0 || layout.size == 0 || cost == 0.;
+
+    double lambda = 1e-3;
+    double delta[parametersMax];
+    while (!ans.converged && ans.iterations < m_iterationsMax) {
+        ++ans.iterations;
+        // damping is raised until the step lowers the cost
+        bool accepted = false;
+        for (; lambda < 1e10; lambda *= 10.) {
+            if (!solveDamped(normal, layout.size, lambda, delta)) continue;
+            State trial = applyStep(state, layout, delta);
+            double costTrial = evaluate(trial, problem, used, layout, nullptr);
+            if (!(costTrial < cost)) continue;
+
+            ans.converged = cost - costTrial <= m_tolerance*cost;
+            state = trial;
+            cost = evaluate(state, problem, used, layout, &normal);
+            lambda = std::max(lambda/10., 1e-12);
+            accepted = true;
+            break;
+        }
+        // no step lowers the cost, the minimum is reached at the precision of the residuals
+        if (!accepted) ans.converged = true;
+    }
+    ans.rms = count > 0 ? std::sqrt(cost/count) : 0.;
+
+    ans.geometry = problem.armature->get_geometry();
+    ans.geometry.primaryShift = state.primaryShift;
+    ans.geometry.primaryAxis = state.a;
+    ans.geometry.secondaryShift = state.secondaryShift;
+    ans.geometry.secondaryAxis = state.b;
+    if (models) {
+        const Actuator& e = state.primary;
+        const Actuator& h = state.secondary;
+        ans.elevation = ElevationAngleKM(e.gamma, e.rab, e.rbc, e.rad, e.alpha2 + state.primaryOffset, e.offset);
+        ans.hour = HourAngleKM(h.gamma + state.secondaryOffset, h.rab, h.rbc, h.rad, h.offset);
+        ans.angleOffsets = vec2d(0., 0.);
+    } else
+        ans.angleOffsets = vec2d(state.primaryOffset, state.secondaryOffset)/gcf::degree;
+    return ans;
+}
+
+std::vector<CalibrationResult> ArmatureCalibration::calibrate(const std::vector<CalibrationProblem>& problems) const
+{
+    std::vector<CalibrationResult> ans(problems.size());
+    // each heliostat writes only its own result
+    m_pool->parallelFor(problems.size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            ans[i] = calibrate(problems[i]);
+    });
+    return ans;
+}
@@ -13,6 +13,11 @@ Transform ArmatureJoint::getTransform(double angle) const
     return Transform::translate(shift)*Transform::rotate(angle, axis);
 }
 
+AffineTransform ArmatureJoint::getAffineTransform(double angle) const
+{
+    return AffineTransform::translate(shift)*AffineTransform::rotate(angle, axis);
+}
+
 ArmatureVertex::ArmatureVertex(const vec3d& point, const vec3d& normal):
     shift(point),
     normal(normal.normalized())
@@ -1,15 +1,47 @@
 #include <cmath>  // For std::cos, std::sqrt, std::asin, and std::acos
 #include <limits> // For std::numeric_limits
 #include "ElevationAngleKM.h"
+#include "SimdMath.h"
+
+
+void ElevationAngleKM::onModified()
+{
+    m_c0 = m_rab * m_rab + m_rad * m_rad - m_rbc * m_rbc;
+    m_c1 = 2.0 * m_rab * m_rad;
+    m_approximation.refit([this](double angle) { return findActuatorLength(angle); },
+                          [this](double length) { return findElevationAngle(length); });
+}
+
+void ElevationAngleKM::setApproximation(const Interval& angles, double lengthTolerance, double angleTolerance)
+{
+    m_approximation.fit([this](double angle) { return findActuatorLength(angle); },
+                        [this](double length) { return findElevationAngle(length); },
+                        angles, lengthTolerance, angleTolerance);
+}
+
+void ElevationAngleKM::clearApproximation()
+{
+    m_approximation.clear();
+}
 
-// Implementation of the function that calculates actuator length from elevation angle
 double ElevationAngleKM::getActuatorLengthFromElevationAngle(double elevation_angle) const
 {
-    double rab2 = m_rab * m_rab;
-    double rad2 = m_rad * m_rad;
-    double rbc2 = m_rbc * m_rbc;
+    if (get_lengthApproximation().isInside(elevation_angle))
+        return get_lengthApproximation()(elevation_angle);
+    return findActuatorLength(elevation_angle);
+}
 
-    double xSquare = rab2 + rad2 - rbc2 + 2.0 * m_rab * m_rad * std::cos(elevation_angle - m_alpha2 + m_gamma);
+double ElevationAngleKM::getElevationAngleFromActuatorLength(double actuator_length) const
+{
+    if (get_angleApproximation().isInside(actuator_length))
+        return get_angleApproximation()(actuator_length);
+    return findElevationAngle(actuator_length);
+}
+
+// Implementation of the function that calculates actuator length from elevation angle
+double ElevationAngleKM::findActuatorLength(double elevation_angle) const
+{
+    double xSquare = m_c0 + m_c1 * std::cos(elevation_angle - m_alpha2 + m_gamma);
 
     // Check if xSquare is negative
     if (xSquare < 0.0) {
@@ -20,15 +52,12 @@ double ElevationAngleKM::getActuatorLengthFromElevationAngle(double elevation_an
 }
 
 // Implementation of the function that calculates elevation angle from actuator length
-double ElevationAngleKM::getElevationAngleFromActuatorLength(double actuator_length) const 
+double ElevationAngleKM::findElevationAngle(double actuator_length) const 
 {
-    double rab2 = m_rab * m_rab;
-    double rad2 = m_rad * m_rad;
-    double rbc2 = m_rbc * m_rbc;
     double x = actuator_length + m_offset;
     double x2 = x * x;
 
-    double cos_arg = (rbc2 + x2 - rab2 - rad2) / (2.0 * m_rab * m_rad );
+    double cos_arg = (x2 - m_c0) / m_c1;
 
     // Check if the argument of acos is within the valid range [-1, 1]
     if (cos_arg < -1.0 || cos_arg > 1.0) {
@@ -37,3 +66,58 @@ double ElevationAngleKM::getElevationAngleFromActuatorLength(double actuator_len
 
     return  m_alpha2 - m_gamma + std::acos(cos_arg);
 }
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+// 4 values per iteration, returns the number of values done
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t lengthsFromAngles4(std::size_t count, const double* angles, double* lengths,
+                                      double c0, double c1, double phase, double offset)
+{
+    const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d a = _mm256_add_pd(_mm256_loadu_pd(angles + i), _mm256_set1_pd(phase));
+        __m256d xSquare = _mm256_add_pd(_mm256_set1_pd(c0), _mm256_mul_pd(_mm256_set1_pd(c1), simd::cos(a)));
+        __m256d ans = _mm256_sub_pd(_mm256_sqrt_pd(xSquare), _mm256_set1_pd(offset));
+        ans = _mm256_blendv_pd(ans, nan, _mm256_cmp_pd(xSquare, _mm256_setzero_pd(), _CMP_LT_OQ));
+        _mm256_storeu_pd(lengths + i, ans);
+    }
+    return i;
+}
+
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t anglesFromLengths4(std::size_t count, const double* lengths, double* angles,
+                                      double c0, double c1, double phase, double offset)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d x = _mm256_add_pd(_mm256_loadu_pd(lengths + i), _mm256_set1_pd(offset));
+        __m256d cosArg = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(x, x), _mm256_set1_pd(c0)), _mm256_set1_pd(c1));
+        __m256d ans = _mm256_add_pd(_mm256_set1_pd(phase), simd::acos(cosArg)); // NaN outside [-1, 1]
+        _mm256_storeu_pd(angles + i, ans);
+    }
+    return i;
+}
+#endif
+
+void ElevationAngleKM::getActuatorLengthsFromElevationAngles(std::size_t count, const double* angles, double* lengths) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (!hasApproximation() && simd::hasAVX2())
+        i = lengthsFromAngles4(count, angles, lengths, m_c0, m_c1, m_gamma - m_alpha2, m_offset);
+#endif
+    for (; i < count; ++i)
+        lengths[i] = getActuatorLengthFromElevationAngle(angles[i]);
+}
+
+void ElevationAngleKM::getElevationAnglesFromActuatorLengths(std::size_t count, const double* lengths, double* angles) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (!hasApproximation() && simd::hasAVX2())
+        i = anglesFromLengths4(count, lengths, angles, m_c0, m_c1, m_alpha2 - m_gamma, m_offset);
+#endif
+    for (; i < count; ++i)
+        angles[i] = getElevationAngleFromActuatorLength(lengths[i]);
+}
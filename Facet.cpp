@@ -0,0 +1,49 @@
+#include "Facet.h"
+
+#include <cmath>
+
+#include "AffineTransform.h"
+#include "HeliostatField.h"
+#include "Ray.h"
+#include "TrackerArmature2A.h"
+
+Facet Facet::fromField(const HeliostatField& field, std::size_t i, const vec2d& size)
+{
+    const TrackerArmature2A* armature = field.get_armature(i);
+    vec2d angles = field.get_angles(i)*gcf::degree;
+    AffineTransform toField = field.get_location(i)*
+        armature->get_primary().getAffineTransform(angles.x)*
+        armature->get_secondary().getAffineTransform(angles.y);
+
+    // the width runs along the secondary axis when it lies in the facet
+    vec3d n0 = armature->get_facet().normal;
+    vec3d u0 = armature->get_secondary().axis - dot(armature->get_secondary().axis, n0)*n0;
+    u0 = u0.norm2() > 1e-12 ? u0.normalized() : n0.findOrthogonal().normalized();
+
+    Facet facet;
+    facet.center = toField.transformPoint(armature->get_facet().shift);
+    facet.normal = toField.transformVector(n0).normalized();
+    vec3d uDir = toField.transformVector(u0).normalized();
+    facet.u = 0.5*size.x*uDir;
+    facet.v = 0.5*size.y*cross(facet.normal, uDir);
+    return facet;
+}
+
+void Facet::getBounds(vec3d& lo, vec3d& hi) const
+{
+    vec3d e(std::abs(u.x) + std::abs(v.x), std::abs(u.y) + std::abs(v.y), std::abs(u.z) + std::abs(v.z));
+    lo = center - e;
+    hi = center + e;
+}
+
+bool Facet::intersect(const Ray& ray, double& t) const
+{
+    double dn = dot(ray.direction(), normal);
+    if (dn == 0.) return false;
+    double tHit = dot(center - ray.origin, normal)/dn;
+    if (!(tHit > ray.tMin && tHit < ray.tMax)) return false;
+    vec3d p = ray.point(tHit) - center;
+    if (std::abs(dot(p, u)) > u.norm2() || std::abs(dot(p, v)) > v.norm2()) return false;
+    t = tHit;
+    return true;
+}
@@ -0,0 +1,344 @@
+#include "FacetBVH.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "HeliostatField.h"
+#include "Ray.h"
+#include "SimdMath.h"
+
+namespace {
+
+const std::uint32_t LeafSize = 4;
+
+// slab test with the reciprocal direction, NaN from 0*inf is dropped by min/max
+inline bool hitsBox(const vec3d& lo, const vec3d& hi, const vec3d& origin, const vec3d& inv, double tMin, double tMax)
+{
+    double t0 = (lo.x - origin.x)*inv.x;
+    double t1 = (hi.x - origin.x)*inv.x;
+    tMin = std::max(tMin, std::min(t0, t1));
+    tMax = std::min(tMax, std::max(t0, t1));
+
+    t0 = (lo.y - origin.y)*inv.y;
+    t1 = (hi.y - origin.y)*inv.y;
+    tMin = std::max(tMin, std::min(t0, t1));
+    tMax = std::min(tMax, std::max(t0, t1));
+
+    t0 = (lo.z - origin.z)*inv.z;
+    t1 = (hi.z - origin.z)*inv.z;
+    tMin = std::max(tMin, std::min(t0, t1));
+    tMax = std::min(tMax, std::max(t0, t1));
+    return tMin <= tMax;
+}
+
+inline void expand(vec3d& lo, vec3d& hi, const vec3d& loB, const vec3d& hiB)
+{
+    lo = vec3d(std::min(lo.x, loB.x), std::min(lo.y, loB.y), std::min(lo.z, loB.z));
+    hi = vec3d(std::max(hi.x, hiB.x), std::max(hi.y, hiB.y), std::max(hi.z, hiB.z));
+}
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+
+// Traversal of four rays at a time, the facet test repeats Facet::intersect lane by lane.
+// Lanes are dropped by setting their tMax to -infinity.
+template<bool any, class Node>
+HELIOSTAT_TRACKING_TARGET_AVX2
+int traversePacket4(const Node* nodes, const Facet* facets, const std::uint32_t* ids,
+                    RayPacket& packet, std::size_t* hits, const std::size_t* ignore)
+{
+    const __m256d ox = _mm256_load_pd(packet.ox);
+    const __m256d oy = _mm256_load_pd(packet.oy);
+    const __m256d oz = _mm256_load_pd(packet.oz);
+    const __m256d dx = _mm256_load_pd(packet.dx);
+    const __m256d dy = _mm256_load_pd(packet.dy);
+    const __m256d dz = _mm256_load_pd(packet.dz);
+    const __m256d ix = _mm256_load_pd(packet.ix);
+    const __m256d iy = _mm256_load_pd(packet.iy);
+    const __m256d iz = _mm256_load_pd(packet.iz);
+    const __m256d tMin = _mm256_load_pd(packet.tMin);
+    const __m256d signMask = _mm256_set1_pd(-0.);
+    const __m256d dropped = _mm256_set1_pd(-gcf::infinity);
+
+    const __m256d active = _mm256_cmp_pd(_mm256_set_pd(3., 2., 1., 0.), _mm256_set1_pd(packet.count), _CMP_LT_OQ);
+    const int activeMask = _mm256_movemask_pd(active);
+    __m256d tMax = _mm256_blendv_pd(dropped, _mm256_load_pd(packet.tMax), active);
+    int occludedMask = 0;
+    const vec3d d0(packet.dx[0], packet.dy[0], packet.dz[0]);
+
+    std::uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        std::uint32_t n = stack[--top];
+        const Node& node = nodes[n];
+
+        // slab test, the operand order of min and max matches std::min and std::max for NaN
+        __m256d t0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.lo.x), ox), ix);
+        __m256d t1 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.hi.x), ox), ix);
+        __m256d tNear = _mm256_max_pd(_mm256_min_pd(t1, t0), tMin);
+        __m256d tFar = _mm256_min_pd(_mm256_max_pd(t1, t0), tMax);
+        t0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.lo.y), oy), iy);
+        t1 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.hi.y), oy), iy);
+        tNear = _mm256_max_pd(_mm256_min_pd(t1, t0), tNear);
+        tFar = _mm256_min_pd(_mm256_max_pd(t1, t0), tFar);
+        t0 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.lo.z), oz), iz);
+        t1 = _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(node.hi.z), oz), iz);
+        tNear = _mm256_max_pd(_mm256_min_pd(t1, t0), tNear);
+        tFar = _mm256_min_pd(_mm256_max_pd(t1, t0), tFar);
+        int boxMask = _mm256_movemask_pd(_mm256_cmp_pd(tNear, tFar, _CMP_LE_OQ));
+        if (boxMask == 0) continue;
+
+        if (node.count == 0) {
+            std::uint32_t left = n + 1;
+            std::uint32_t right = node.index;
+            vec3d centerLeft = nodes[left].lo + nodes[left].hi;
+            vec3d centerRight = nodes[right].lo + nodes[right].hi;
+            if (dot(centerLeft - centerRight, d0) > 0.)
+                std::swap(left, right);
+            stack[top++] = right;
+            stack[top++] = left;
+            continue;
+        }
+
+        for (std::uint32_t k = node.index; k < node.index + node.count; ++k) {
+            int laneMask = boxMask;
+            if (ignore) {
+                for (int lane = 0; lane < RayPacket::Width; ++lane)
+                    if (ignore[lane] == ids[k]) laneMask &= ~(1 << lane);
+                if (laneMask == 0) continue;
+            }
+            const Facet& f = facets[k];
+            const __m256d nx = _mm256_set1_pd(f.normal.x);
+            const __m256d ny = _mm256_set1_pd(f.normal.y);
+            const __m256d nz = _mm256_set1_pd(f.normal.z);
+            const __m256d cx = _mm256_set1_pd(f.center.x);
+            const __m256d cy = _mm256_set1_pd(f.center.y);
+            const __m256d cz = _mm256_set1_pd(f.center.z);
+
+            __m256d dn = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, nx), _mm256_mul_pd(dy, ny)), _mm256_mul_pd(dz, nz));
+            __m256d t = _mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(_mm256_sub_pd(cx, ox), nx),
+                _mm256_mul_pd(_mm256_sub_pd(cy, oy), ny)),
+                _mm256_mul_pd(_mm256_sub_pd(cz, oz), nz));
+            t = _mm256_div_pd(t, dn);
+            __m256d hit = _mm256_and_pd(_mm256_cmp_pd(t, tMin, _CMP_GT_OQ), _mm256_cmp_pd(t, tMax, _CMP_LT_OQ));
+            if ((_mm256_movemask_pd(hit) & laneMask) == 0) continue;
+
+            __m256d px = _mm256_sub_pd(_mm256_add_pd(ox, _mm256_mul_pd(dx, t)), cx);
+            __m256d py = _mm256_sub_pd(_mm256_add_pd(oy, _mm256_mul_pd(dy, t)), cy);
+            __m256d pz = _mm256_sub_pd(_mm256_add_pd(oz, _mm256_mul_pd(dz, t)), cz);
+            __m256d pu = _mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(px, _mm256_set1_pd(f.u.x)),
+                _mm256_mul_pd(py, _mm256_set1_pd(f.u.y))),
+                _mm256_mul_pd(pz, _mm256_set1_pd(f.u.z)));
+            __m256d pv = _mm256_add_pd(_mm256_add_pd(
+                _mm256_mul_pd(px, _mm256_set1_pd(f.v.x)),
+                _mm256_mul_pd(py, _mm256_set1_pd(f.v.y))),
+                _mm256_mul_pd(pz, _mm256_set1_pd(f.v.z)));
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(_mm256_andnot_pd(signMask, pu), _mm256_set1_pd(f.u.norm2()), _CMP_NGT_UQ));
+            hit = _mm256_and_pd(hit, _mm256_cmp_pd(_mm256_andnot_pd(signMask, pv), _mm256_set1_pd(f.v.norm2()), _CMP_NGT_UQ));
+            int hitMask = _mm256_movemask_pd(hit) & laneMask;
+            if (hitMask == 0) continue;
+
+            hit = _mm256_castsi256_pd(_mm256_cmpgt_epi64(
+                _mm256_and_si256(_mm256_set1_epi64x(hitMask), _mm256_set_epi64x(8, 4, 2, 1)), _mm256_setzero_si256()));
+            if (any) {
+                occludedMask |= hitMask;
+                if (occludedMask == activeMask) return occludedMask;
+                tMax = _mm256_blendv_pd(tMax, dropped, hit);
+            } else {
+                tMax = _mm256_blendv_pd(tMax, t, hit);
+                for (int lane = 0; lane < RayPacket::Width; ++lane)
+                    if (hitMask & (1 << lane)) hits[lane] = ids[k];
+            }
+        }
+    }
+
+    if (!any)
+        _mm256_store_pd(packet.tMax, _mm256_blendv_pd(_mm256_load_pd(packet.tMax), tMax, active));
+    return occludedMask;
+}
+
+#endif
+
+}
+
+void FacetBVH::build(const HeliostatField& field, const vec2d& size)
+{
+    if (field.size() >= std::size_t(UINT32_MAX))
+        throw std::invalid_argument("FacetBVH::build: too many heliostats");
+    m_size = size;
+    m_facets.resize(field.size());
+    m_ids.resize(field.size());
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        m_facets[i] = Facet::fromField(field, i, size);
+        m_ids[i] = std::uint32_t(i);
+    }
+    m_nodes.clear();
+    if (!m_facets.empty())
+        buildNode(0, std::uint32_t(m_facets.size()));
+
+    m_slots.resize(m_ids.size());
+    for (std::size_t k = 0; k < m_ids.size(); ++k)
+        m_slots[m_ids[k]] = std::uint32_t(k);
+}
+
+std::uint32_t FacetBVH::buildNode(std::uint32_t begin, std::uint32_t end)
+{
+    std::uint32_t n = std::uint32_t(m_nodes.size());
+    m_nodes.push_back(Node());
+
+    vec3d lo(gcf::infinity, gcf::infinity, gcf::infinity);
+    vec3d hi = -lo;
+    vec3d cLo = lo;
+    vec3d cHi = hi;
+    for (std::uint32_t k = begin; k < end; ++k) {
+        vec3d fLo, fHi;
+        m_facets[k].getBounds(fLo, fHi);
+        expand(lo, hi, fLo, fHi);
+        expand(cLo, cHi, m_facets[k].center, m_facets[k].center);
+    }
+    m_nodes[n].lo = lo;
+    m_nodes[n].hi = hi;
+
+    if (end - begin <= LeafSize) {
+        m_nodes[n].index = begin;
+        m_nodes[n].count = end - begin;
+        return n;
+    }
+
+    // median split along the widest axis of the centers
+    vec3d extent = cHi - cLo;
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    std::uint32_t mid = begin + (end - begin)/2;
+    std::vector<std::uint32_t> order(end - begin);
+    for (std::uint32_t k = begin; k < end; ++k)
+        order[k - begin] = k;
+    std::nth_element(order.begin(), order.begin() + (mid - begin), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return m_facets[a].center[axis] < m_facets[b].center[axis];
+    });
+    std::vector<Facet> facets(end - begin);
+    std::vector<std::uint32_t> ids(end - begin);
+    for (std::uint32_t k = 0; k < end - begin; ++k) {
+        facets[k] = m_facets[order[k]];
+        ids[k] = m_ids[order[k]];
+    }
+    std::copy(facets.begin(), facets.end(), m_facets.begin() + begin);
+    std::copy(ids.begin(), ids.end(), m_ids.begin() + begin);
+
+    buildNode(begin, mid);
+    std::uint32_t right = buildNode(mid, end);
+    m_nodes[n].index = right;
+    m_nodes[n].count = 0;
+    return n;
+}
+
+void FacetBVH::refit(const HeliostatField& field)
+{
+    if (field.size() != m_facets.size())
+        throw std::invalid_argument("FacetBVH::refit: the field does not match the tree");
+    for (std::size_t k = 0; k < m_facets.size(); ++k)
+        m_facets[k] = Facet::fromField(field, m_ids[k], m_size);
+
+    // children come after their parent
+    for (std::size_t n = m_nodes.size(); n-- > 0;) {
+        Node& node = m_nodes[n];
+        vec3d lo(gcf::infinity, gcf::infinity, gcf::infinity);
+        vec3d hi = -lo;
+        if (node.count > 0) {
+            for (std::uint32_t k = node.index; k < node.index + node.count; ++k) {
+                vec3d fLo, fHi;
+                m_facets[k].getBounds(fLo, fHi);
+                expand(lo, hi, fLo, fHi);
+            }
+        } else {
+            const Node& left = m_nodes[n + 1];
+            const Node& right = m_nodes[node.index];
+            expand(lo, hi, left.lo, left.hi);
+            expand(lo, hi, right.lo, right.hi);
+        }
+        node.lo = lo;
+        node.hi = hi;
+    }
+}
+
+template<bool any>
+std::size_t FacetBVH::traverse(const Ray& ray, std::size_t ignore) const
+{
+    if (m_nodes.empty()) return npos;
+    const vec3d& origin = ray.origin;
+    const vec3d& inv = ray.invDirection();
+    std::size_t ans = npos;
+
+    std::uint32_t stack[64];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = m_nodes[stack[--top]];
+        if (!hitsBox(node.lo, node.hi, origin, inv, ray.tMin, ray.tMax)) continue;
+        if (node.count > 0) {
+            for (std::uint32_t k = node.index; k < node.index + node.count; ++k) {
+                double t;
+                if (m_ids[k] == ignore || !m_facets[k].intersect(ray, t)) continue;
+                ans = m_ids[k];
+                if (any) return ans;
+                ray.tMax = t;
+            }
+        } else {
+            // visit the near child first
+            std::uint32_t left = std::uint32_t(&node - m_nodes.data()) + 1;
+            std::uint32_t right = node.index;
+            vec3d centerLeft = m_nodes[left].lo + m_nodes[left].hi;
+            vec3d centerRight = m_nodes[right].lo + m_nodes[right].hi;
+            if (dot(centerLeft - centerRight, ray.direction()) > 0.)
+                std::swap(left, right);
+            stack[top++] = right;
+            stack[top++] = left;
+        }
+    }
+    return ans;
+}
+
+std::size_t FacetBVH::intersect(const Ray& ray, std::size_t ignore) const
+{
+    return traverse<false>(ray, ignore);
+}
+
+bool FacetBVH::occluded(const Ray& ray, std::size_t ignore) const
+{
+    return traverse<true>(ray, ignore) != npos;
+}
+
+void FacetBVH::intersect(RayPacket& packet, std::size_t* hits, const std::size_t* ignore) const
+{
+    for (int lane = 0; lane < RayPacket::Width; ++lane)
+        hits[lane] = npos;
+    if (m_nodes.empty() || packet.count == 0) return;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (simd::hasAVX2()) {
+        traversePacket4<false>(m_nodes.data(), m_facets.data(), m_ids.data(), packet, hits, ignore);
+        return;
+    }
+#endif
+    for (int lane = 0; lane < packet.count; ++lane) {
+        Ray ray = packet.ray(lane);
+        hits[lane] = traverse<false>(ray, ignore ? ignore[lane] : npos);
+        packet.tMax[lane] = ray.tMax;
+    }
+}
+
+int FacetBVH::occluded(const RayPacket& packet, const std::size_t* ignore) const
+{
+    if (m_nodes.empty() || packet.count == 0) return 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (simd::hasAVX2()) {
+        RayPacket p = packet;
+        return traversePacket4<true>(m_nodes.data(), m_facets.data(), m_ids.data(), p, nullptr, ignore);
+    }
+#endif
+    int mask = 0;
+    for (int lane = 0; lane < packet.count; ++lane)
+        if (traverse<true>(packet.ray(lane), ignore ? ignore[lane] : npos) != npos)
+            mask |= 1 << lane;
+    return mask;
+}
@@ -0,0 +1,280 @@
+#include "FieldDefinition.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "HeliostatField.h"
+
+namespace {
+
+const char fileMagic[8] = {'H', 'T', 'F', 'I', 'E', 'L', 'D', 0};
+const std::uint32_t fileVersion = 1;
+const std::uint32_t noIndex = std::uint32_t(-1);
+
+// records of the file, angles in degrees as in the setters
+struct ArmatureRecord
+{
+    double primaryShift[3];
+    double primaryAxis[3];
+    double primaryAngles[2];
+    double secondaryShift[3];
+    double secondaryAxis[3];
+    double secondaryAngles[2];
+    double facetShift[3];
+    double facetNormal[3];
+    double anglesDefault[2];
+};
+
+struct ModelRecord
+{
+    double elevation[6]; // gamma, rab, rbc, rad, alpha2, offset
+    double hour[5]; // gamma, rab, rbc, rad, offset
+};
+
+struct HeliostatRecord
+{
+    double location[4][4];
+    double locationInverse[4][4];
+    double aimingPoint[3];
+    double angles[2];
+    std::uint32_t armature;
+    std::uint32_t models; // noIndex without actuator models
+    std::uint32_t aimingType;
+    std::uint32_t warmStart;
+};
+
+void put(double* d, const vec3d& v)
+{
+    d[0] = v.x; d[1] = v.y; d[2] = v.z;
+}
+
+void put(double* d, const vec2d& v)
+{
+    d[0] = v.x; d[1] = v.y;
+}
+
+// homogeneous matrix of the 3x4 block of an affine transform
+void putAffine(double d[4][4], const double (&m)[3][4])
+{
+    std::memcpy(d, m, sizeof(m));
+    d[3][0] = 0.; d[3][1] = 0.; d[3][2] = 0.; d[3][3] = 1.;
+}
+
+vec3d get3(const double* d)
+{
+    return vec3d(d[0], d[1], d[2]);
+}
+
+vec2d get2(const double* d)
+{
+    return vec2d(d[0], d[1]);
+}
+
+template<class Record>
+void writeRecords(std::ofstream& file, const std::vector<Record>& records)
+{
+    std::uint64_t count = records.size();
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(records.data()), count*sizeof(Record));
+}
+
+// reads a table with one read, the count is checked against the bytes left in the file
+template<class Record>
+bool readRecords(std::ifstream& file, std::uint64_t bytesLeft, std::vector<Record>& records)
+{
+    std::uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || count > (bytesLeft - sizeof(count))/sizeof(Record)) return false;
+    records.resize(std::size_t(count));
+    file.read(reinterpret_cast<char*>(records.data()), count*sizeof(Record));
+    return bool(file);
+}
+
+}
+
+std::size_t FieldDefinition::addArmature(const TrackerArmature2A& armature)
+{
+    m_armatures.emplace_back(new TrackerArmature2A(armature.get_geometry()));
+    return m_armatures.size() - 1;
+}
+
+std::size_t FieldDefinition::addModels(const ElevationAngleKM& elevation, const HourAngleKM& hour)
+{
+    m_elevationModels.push_back(elevation);
+    m_hourModels.push_back(hour);
+    return m_elevationModels.size() - 1;
+}
+
+std::size_t FieldDefinition::addHeliostat(const AffineTransform& location, std::size_t armature,
+                                          const TrackerTarget& target, std::size_t models)
+{
+    if (armature >= m_armatures.size() || (models != npos && models >= m_elevationModels.size()))
+        throw std::out_of_range("FieldDefinition: no such armature or models");
+    m_locations.push_back(location);
+    m_armatureIndices.push_back(armature);
+    m_modelIndices.push_back(models);
+    m_targets.push_back(target);
+    return m_locations.size() - 1;
+}
+
+void FieldDefinition::clear()
+{
+    m_armatures.clear();
+    m_elevationModels.clear();
+    m_hourModels.clear();
+    m_locations.clear();
+    m_armatureIndices.clear();
+    m_modelIndices.clear();
+    m_targets.clear();
+}
+
+FieldDefinition FieldDefinition::fromField(const HeliostatField& field)
+{
+    FieldDefinition ans;
+    std::unordered_map<const TrackerArmature2A*, std::size_t> indices;
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        const TrackerArmature2A* armature = field.get_armature(i);
+        auto it = indices.find(armature);
+        if (it == indices.end())
+            it = indices.emplace(armature, ans.addArmature(*armature)).first;
+        ans.addHeliostat(field.get_location(i), it->second, field.get_target(i));
+    }
+    return ans;
+}
+
+void FieldDefinition::addToField(HeliostatField& field) const
+{
+    field.reserve(field.size() + size());
+    for (std::size_t i = 0; i < size(); ++i)
+        field.addHeliostat(m_locations[i], m_armatures[m_armatureIndices[i]].get(), m_targets[i]);
+}
+
+void FieldDefinition::addToModels(std::vector<const ElevationAngleKM*>& elevations, std::vector<const HourAngleKM*>& hours) const
+{
+    elevations.reserve(elevations.size() + size());
+    hours.reserve(hours.size() + size());
+    for (std::size_t k : m_modelIndices) {
+        elevations.push_back(k == npos ? nullptr : &m_elevationModels[k]);
+        hours.push_back(k == npos ? nullptr : &m_hourModels[k]);
+    }
+}
+
+void FieldDefinition::save(const std::string& fileName) const
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("FieldDefinition: cannot open " + fileName);
+
+    std::vector<ArmatureRecord> armatures(m_armatures.size());
+    for (std::size_t k = 0; k < armatures.size(); ++k) {
+        const TrackerArmature2A& a = *m_armatures[k];
+        ArmatureRecord& r = armatures[k];
+        put(r.primaryShift, a.get_primaryShift());
+        put(r.primaryAxis, a.get_primaryAxis());
+        put(r.primaryAngles, a.get_primaryAngles());
+        put(r.secondaryShift, a.get_secondaryShift());
+        put(r.secondaryAxis, a.get_secondaryAxis());
+        put(r.secondaryAngles, a.get_secondaryAngles());
+        put(r.facetShift, a.get_facetShift());
+        put(r.facetNormal, a.get_facetNormal());
+        put(r.anglesDefault, a.get_anglesDefault());
+    }
+
+    std::vector<ModelRecord> models(m_elevationModels.size());
+    for (std::size_t k = 0; k < models.size(); ++k) {
+        const ElevationAngleKM& e = m_elevationModels[k];
+        const HourAngleKM& h = m_hourModels[k];
+        ModelRecord& r = models[k];
+        double elevation[6] = {e.get_gamma(), e.get_rab(), e.get_rbc(), e.get_rad(), e.get_alpha2(), e.get_offset()};
+        double hour[5] = {h.get_gamma(), h.get_rab(), h.get_rbc(), h.get_rad(), h.get_offset()};
+        std::memcpy(r.elevation, elevation, sizeof(elevation));
+        std::memcpy(r.hour, hour, sizeof(hour));
+    }
+
+    std::vector<HeliostatRecord> heliostats(size());
+    for (std::size_t i = 0; i < heliostats.size(); ++i) {
+        const TrackerTarget& t = m_targets[i];
+        HeliostatRecord& r = heliostats[i];
+        putAffine(r.location, m_locations[i].getMatrix());
+        putAffine(r.locationInverse, m_locations[i].getInverseMatrix());
+        put(r.aimingPoint, t.aimingPoint);
+        put(r.angles, t.angles);
+        r.armature = std::uint32_t(m_armatureIndices[i]);
+        r.models = m_modelIndices[i] == npos ? noIndex : std::uint32_t(m_modelIndices[i]);
+        r.aimingType = std::uint32_t(t.aimingType);
+        r.warmStart = t.warmStart ? 1 : 0;
+    }
+
+    file.write(fileMagic, sizeof(fileMagic));
+    file.write(reinterpret_cast<const char*>(&fileVersion), sizeof(fileVersion));
+    writeRecords(file, armatures);
+    writeRecords(file, models);
+    writeRecords(file, heliostats);
+    if (!file)
+        throw std::runtime_error("FieldDefinition: cannot write " + fileName);
+}
+
+FieldDefinition FieldDefinition::load(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error("FieldDefinition: cannot open " + fileName);
+    std::uint64_t bytes = std::uint64_t(file.tellg());
+    file.seekg(0);
+
+    char magic[sizeof(fileMagic)];
+    std::uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, fileMagic, sizeof(magic)) != 0 || version != fileVersion)
+        throw std::runtime_error("FieldDefinition: " + fileName + " is not a field file");
+
+    std::vector<ArmatureRecord> armatures;
+    std::vector<ModelRecord> models;
+    std::vector<HeliostatRecord> heliostats;
+    bool ok = readRecords(file, bytes - std::uint64_t(file.tellg()), armatures);
+    ok = ok && readRecords(file, bytes - std::uint64_t(file.tellg()), models);
+    ok = ok && readRecords(file, bytes - std::uint64_t(file.tellg()), heliostats);
+    if (!ok)
+        throw std::runtime_error("FieldDefinition: truncated data in " + fileName);
+
+    FieldDefinition ans;
+    ans.m_armatures.reserve(armatures.size());
+    for (ArmatureRecord& r : armatures)
+        ans.m_armatures.emplace_back(new TrackerArmature2A(
+            get3(r.primaryShift), get3(r.primaryAxis), get2(r.primaryAngles),
+            get3(r.secondaryShift), get3(r.secondaryAxis), get2(r.secondaryAngles),
+            get3(r.facetShift), get3(r.facetNormal), get2(r.anglesDefault)));
+
+    ans.m_elevationModels.reserve(models.size());
+    ans.m_hourModels.reserve(models.size());
+    for (ModelRecord& r : models) {
+        const double* e = r.elevation;
+        const double* h = r.hour;
+        ans.m_elevationModels.emplace_back(e[0], e[1], e[2], e[3], e[4], e[5]);
+        ans.m_hourModels.emplace_back(h[0], h[1], h[2], h[3], h[4]);
+    }
+
+    std::size_t count = heliostats.size();
+    ans.m_locations.reserve(count);
+    ans.m_armatureIndices.reserve(count);
+    ans.m_modelIndices.reserve(count);
+    ans.m_targets.reserve(count);
+    TrackerTarget target;
+    for (HeliostatRecord& r : heliostats) {
+        if (r.armature >= armatures.size() || (r.models != noIndex && r.models >= models.size()) ||
+            r.aimingType > TrackerTarget::global)
+            throw std::runtime_error("FieldDefinition: corrupted data in " + fileName);
+        ans.m_locations.emplace_back(r.location, r.locationInverse);
+        ans.m_armatureIndices.push_back(r.armature);
+        ans.m_modelIndices.push_back(r.models == noIndex ? npos : r.models);
+        target.aimingType = TrackerTarget::AimingType(r.aimingType);
+        target.aimingPoint = get3(r.aimingPoint);
+        target.angles = get2(r.angles);
+        target.warmStart = r.warmStart != 0;
+        ans.m_targets.push_back(target);
+    }
+    return ans;
+}
@@ -0,0 +1,213 @@
+#include "FluxTracer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+
+#include "AffineTransform.h"
+#include "Facet.h"
+#include "FacetBVH.h"
+#include "Ray.h"
+#include "RayPacket.h"
+
+namespace {
+
+// xoshiro256+ with the state filled by splitmix64
+class RandomStream
+{
+public:
+    explicit RandomStream(std::uint64_t seed)
+    {
+        for (std::uint64_t& s : m_s) {
+            seed += 0x9e3779b97f4a7c15ull;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30))*0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27))*0x94d049bb133111ebull;
+            s = z ^ (z >> 31);
+        }
+    }
+
+    // uniform in [0, 1)
+    double uniform()
+    {
+        std::uint64_t r = m_s[0] + m_s[3];
+        std::uint64_t t = m_s[1] << 17;
+        m_s[2] ^= m_s[0];
+        m_s[3] ^= m_s[1];
+        m_s[1] ^= m_s[2];
+        m_s[0] ^= m_s[3];
+        m_s[2] ^= t;
+        m_s[3] = (m_s[3] << 45) | (m_s[3] >> 19);
+        return (r >> 11)*0x1.0p-53;
+    }
+
+    // two standard normal values (Box-Muller)
+    void normal(double& a, double& b)
+    {
+        double r = std::sqrt(-2.*std::log(1. - uniform()));
+        double phi = 2.*gcf::Pi*uniform();
+        a = r*std::cos(phi);
+        b = r*std::sin(phi);
+    }
+
+private:
+    std::uint64_t m_s[4];
+};
+
+// partial maps are limited to 2^23 bins (64 MB) in total
+const std::size_t partialBinsMax = std::size_t(1) << 23;
+
+}
+
+FluxTracer::FluxTracer(int threads):
+    m_facetSize(1., 1.),
+    m_reflectivity(1.),
+    m_dni(1000.),
+    m_sunRadius(4.65e-3),
+    m_slopeError(0.),
+    m_seed(0),
+    m_pool(new ThreadPool(threads))
+{
+
+}
+
+void FluxTracer::set_threads(int threads)
+{
+    m_pool.reset(new ThreadPool(threads));
+}
+
+FluxMap FluxTracer::trace(const HeliostatField& field, const vec3d& vSun, const FluxReceiver& receiver, std::size_t raysPerHeliostat, const FacetBVH* bvh) const
+{
+    if (receiver.nx <= 0 || receiver.ny <= 0)
+        throw std::invalid_argument("FluxTracer::trace: the receiver has no bins");
+    if (!(receiver.width > 0.) || !(receiver.height > 0.))
+        throw std::invalid_argument("FluxTracer::trace: the receiver has no area");
+    if (bvh && bvh->size() != field.size())
+        throw std::invalid_argument("FluxTracer::trace: the facet tree does not match the field");
+
+    const std::size_t bins = std::size_t(receiver.nx)*receiver.ny;
+    FluxMap map;
+    map.nx = receiver.nx;
+    map.ny = receiver.ny;
+    map.flux.assign(bins, 0.);
+    if (field.size() == 0 || raysPerHeliostat == 0) return map;
+
+    const AffineTransform toReceiver = AffineTransform(receiver.location).inversed();
+    const double xScale = receiver.nx/receiver.width;
+    const double yScale = receiver.ny/receiver.height;
+
+    // sun disk around s0
+    const vec3d s0 = vSun.normalized();
+    const vec3d e1 = s0.findOrthogonal().normalized();
+    const vec3d e2 = cross(s0, e1);
+    const double rayPower = m_dni*m_reflectivity*m_facetSize.x*m_facetSize.y/raysPerHeliostat;
+
+    // heliostats are split into groups with a partial map each,
+    // the number of groups depends only on the field and the receiver bins
+    const std::size_t groups = std::min<std::size_t>({field.size(), 64, std::max<std::size_t>(partialBinsMax/bins, 1)});
+    std::vector<std::vector<double>> partials(groups);
+    std::vector<std::size_t> hits(groups, 0);
+    std::vector<std::size_t> shaded(groups, 0);
+    std::vector<std::size_t> blocked(groups, 0);
+
+    m_pool->parallelFor(groups, [&](std::size_t gBegin, std::size_t gEnd) {
+        for (std::size_t g = gBegin; g < gEnd; ++g) {
+            std::vector<double>& partial = partials[g];
+            partial.assign(bins, 0.);
+            std::size_t hitsGroup = 0;
+            std::size_t shadedGroup = 0;
+            std::size_t blockedGroup = 0;
+
+            for (std::size_t h = g*field.size()/groups; h < (g + 1)*field.size()/groups; ++h) {
+                Facet facet = Facet::fromField(field, h, m_facetSize);
+                const vec3d& n = facet.normal;
+                vec3d u = 2.*facet.u;
+                vec3d v = 2.*facet.v;
+                vec3d uDir = u.normalized();
+                vec3d vDir = v.normalized();
+
+                RandomStream random(m_seed ^ (0xd1b54a32d192ed03ull*(h + 1)));
+                std::size_t ignore[RayPacket::Width];
+                std::fill_n(ignore, RayPacket::Width, h);
+                for (std::size_t k0 = 0; k0 < raysPerHeliostat; k0 += RayPacket::Width) {
+                    // sun rays arriving on the facet, in packets for the shading and blocking queries
+                    RayPacket incoming;
+                    vec3d normals[RayPacket::Width];
+                    double cosIncidence[RayPacket::Width];
+                    int lanes = int(std::min<std::size_t>(RayPacket::Width, raysPerHeliostat - k0));
+                    int live = 0;
+                    for (int lane = 0; lane < lanes; ++lane) {
+                        vec3d origin = facet.center + (random.uniform() - 0.5)*u + (random.uniform() - 0.5)*v;
+
+                        // uniform in the sun disk, small angle approximation
+                        double r = m_sunRadius*std::sqrt(random.uniform());
+                        double phi = 2.*gcf::Pi*random.uniform();
+                        vec3d s = (s0 + r*std::cos(phi)*e1 + r*std::sin(phi)*e2).normalized();
+
+                        normals[lane] = n;
+                        if (m_slopeError > 0.) {
+                            double a, b;
+                            random.normal(a, b);
+                            normals[lane] = (n + m_slopeError*(a*uDir + b*vDir)).normalized();
+                        }
+                        cosIncidence[lane] = dot(s, normals[lane]);
+                        if (cosIncidence[lane] > 0.) live |= 1 << lane; // otherwise the sun is behind the facet
+                        incoming.add(Ray(origin, s));
+                    }
+                    if (bvh) {
+                        int shadedMask = bvh->occluded(incoming, ignore) & live;
+                        shadedGroup += std::popcount(unsigned(shadedMask));
+                        live &= ~shadedMask;
+                    }
+
+                    // reflected rays reaching the receiver
+                    RayPacket reflected;
+                    std::size_t binsHit[RayPacket::Width];
+                    double powers[RayPacket::Width];
+                    for (int lane = 0; lane < lanes; ++lane) {
+                        if (!(live & (1 << lane))) continue;
+                        Ray ray(vec3d(incoming.ox[lane], incoming.oy[lane], incoming.oz[lane]),
+                                2.*cosIncidence[lane]*normals[lane] - vec3d(incoming.dx[lane], incoming.dy[lane], incoming.dz[lane]));
+                        Ray rayR = toReceiver.transformDirect(ray);
+                        double t = -rayR.origin.z*rayR.invDirection().z;
+                        if (!(t > rayR.tMin && t < rayR.tMax)) continue;
+                        vec3d p = rayR.point(t);
+                        double x = (p.x + 0.5*receiver.width)*xScale;
+                        double y = (p.y + 0.5*receiver.height)*yScale;
+                        if (!(x >= 0. && x < receiver.nx && y >= 0. && y < receiver.ny)) continue;
+                        ray.tMax = t;
+                        binsHit[reflected.count] = std::size_t(y)*receiver.nx + std::size_t(x);
+                        powers[reflected.count] = rayPower*cosIncidence[lane];
+                        reflected.add(ray);
+                    }
+                    int blockedMask = bvh && reflected.count > 0 ? bvh->occluded(reflected, ignore) : 0;
+                    blockedGroup += std::popcount(unsigned(blockedMask));
+                    for (int lane = 0; lane < reflected.count; ++lane) {
+                        if (blockedMask & (1 << lane)) continue;
+                        partial[binsHit[lane]] += powers[lane];
+                        ++hitsGroup;
+                    }
+                }
+            }
+            hits[g] = hitsGroup;
+            shaded[g] = shadedGroup;
+            blocked[g] = blockedGroup;
+        }
+    });
+
+    for (std::size_t g = 0; g < groups; ++g) {
+        for (std::size_t b = 0; b < bins; ++b)
+            map.flux[b] += partials[g][b];
+        map.hits += hits[g];
+        map.shaded += shaded[g];
+        map.blocked += blocked[g];
+    }
+    for (double f : map.flux)
+        map.power += f;
+    const double binArea = (receiver.width/receiver.nx)*(receiver.height/receiver.ny);
+    for (double& f : map.flux)
+        f /= binArea;
+    map.rays = field.size()*raysPerHeliostat;
+    return map;
+}
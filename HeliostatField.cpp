@@ -0,0 +1,125 @@
+#include "HeliostatField.h"
+
+#include <atomic>
+#include <cmath>
+
+#include "TrackerSolver2A.h"
+
+HeliostatField::HeliostatField(int threads):
+    m_skipped(0),
+    m_pool(new ThreadPool(threads))
+{
+
+}
+
+std::size_t HeliostatField::addHeliostat(const AffineTransform& location, TrackerArmature2A* armature, const TrackerTarget& target)
+{
+    m_locations.push_back(location);
+    m_armatures.push_back(armature);
+    m_targets.push_back(target);
+    m_angles.push_back(target.angles.x);
+    m_angles.push_back(target.angles.y);
+    SolveState state;
+    state.valid = false;
+    m_states.push_back(state);
+    return m_locations.size() - 1;
+}
+
+void HeliostatField::clear()
+{
+    m_locations.clear();
+    m_armatures.clear();
+    m_targets.clear();
+    m_angles.clear();
+    m_states.clear();
+    m_skipped = 0;
+}
+
+void HeliostatField::reserve(std::size_t count)
+{
+    m_locations.reserve(count);
+    m_armatures.reserve(count);
+    m_targets.reserve(count);
+    m_angles.reserve(2*count);
+    m_states.reserve(count);
+}
+
+void HeliostatField::set_location(std::size_t i, const AffineTransform& location)
+{
+    m_locations[i] = location;
+    m_states[i].valid = false;
+}
+
+void HeliostatField::set_threads(int threads)
+{
+    m_pool.reset(new ThreadPool(threads));
+}
+
+void HeliostatField::update(const vec3d& vSun)
+{
+    // each heliostat writes only its own target, angles and state
+    m_pool->parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            solve(i, vSun);
+    }, 16);
+    m_skipped = 0;
+}
+
+std::size_t HeliostatField::update(const vec3d& vSun, double tolerance)
+{
+    vec3d vSunN = vSun.normalized();
+    std::atomic<std::size_t> skipped(0);
+    m_pool->parallelFor(size(), [&](std::size_t begin, std::size_t end) {
+        std::size_t n = 0;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (isSolved(i, vSunN, tolerance))
+                ++n;
+            else
+                solve(i, vSun);
+        }
+        skipped += n;
+    }, 16);
+    m_skipped = skipped;
+    return m_skipped;
+}
+
+void HeliostatField::solve(std::size_t i, const vec3d& vSun)
+{
+    TrackerTarget& target = m_targets[i];
+    TrackerArmature2A* armature = m_armatures[i];
+    armature->update(m_locations[i], vSun, &target);
+    m_angles[2*i] = target.angles.x;
+    m_angles[2*i + 1] = target.angles.y;
+
+    SolveState& state = m_states[i];
+    state.valid = target.tracking;
+    if (!state.valid) return;
+    state.generation = armature->get_generation();
+    state.vSun = vSun.normalized();
+    state.aimingType = target.aimingType;
+    state.aimingPoint = target.aimingPoint;
+
+    if (target.aimingType == TrackerTarget::local) {
+        // the aiming point moves with the facet, the rotation follows the sun direction one to one
+        state.distanceInv = 1./(target.aimingPoint - armature->get_facet().shift).norm();
+        state.sensitivity = 1.;
+        return;
+    }
+    vec3d rFacet = m_locations[i].transformPoint(armature->get_solver()->findFacetPoint(target.angles*gcf::degree));
+    vec3d rTarget = target.aimingPoint - rFacet;
+    double distance = rTarget.norm();
+    double cosIncidence = std::sqrt(std::max(0., 0.5*(1. + dot(state.vSun, rTarget/distance))));
+    state.distanceInv = 1./distance;
+    state.sensitivity = 0.5/cosIncidence;
+}
+
+bool HeliostatField::isSolved(std::size_t i, const vec3d& vSun, double tolerance) const
+{
+    const SolveState& state = m_states[i];
+    const TrackerTarget& target = m_targets[i];
+    if (!state.valid || !target.tracking || target.aimingType != state.aimingType) return false;
+    if (m_armatures[i]->get_generation() != state.generation) return false;
+    double dSun = std::atan2(cross(state.vSun, vSun).norm(), dot(state.vSun, vSun));
+    double dTarget = (target.aimingPoint - state.aimingPoint).norm()*state.distanceInv;
+    return (dSun + dTarget)*state.sensitivity <= tolerance;
+}
@@ -1,14 +1,47 @@
 #include <cmath>  // For std::cos, std::sqrt, std::asin, and std::acos
 #include <limits> // For std::numeric_limits
 #include "HourAngleKM.h"
+#include "SimdMath.h"
+
+
+void HourAngleKM::onModified()
+{
+    m_c0 = m_rab * m_rab + m_rad * m_rad - m_rbc * m_rbc;
+    m_c1 = 2.0 * m_rab * m_rad;
+    m_approximation.refit([this](double angle) { return findActuatorLength(angle); },
+                          [this](double length) { return findHourAngle(length); });
+}
+
+void HourAngleKM::setApproximation(const Interval& angles, double lengthTolerance, double angleTolerance)
+{
+    m_approximation.fit([this](double angle) { return findActuatorLength(angle); },
+                        [this](double length) { return findHourAngle(length); },
+                        angles, lengthTolerance, angleTolerance);
+}
+
+void HourAngleKM::clearApproximation()
+{
+    m_approximation.clear();
+}
 
-// Implementation of the function that calculates actuator length from elevation angle
 double HourAngleKM::getActuatorLengthFromHourAngle(double hour_angle) const
 {
-    double rab2 = m_rab * m_rab;
-    double rad2 = m_rad * m_rad;
-    double rbc2 = m_rbc * m_rbc;
-    double ySquare = rab2 + rad2 - rbc2 + 2.0 * m_rab * m_rad * std::sin( hour_angle - m_gamma );
+    if (get_lengthApproximation().isInside(hour_angle))
+        return get_lengthApproximation()(hour_angle);
+    return findActuatorLength(hour_angle);
+}
+
+double HourAngleKM::getHourAngleFromActuatorLength(double actuator_length) const
+{
+    if (get_angleApproximation().isInside(actuator_length))
+        return get_angleApproximation()(actuator_length);
+    return findHourAngle(actuator_length);
+}
+
+// Implementation of the function that calculates actuator length from elevation angle
+double HourAngleKM::findActuatorLength(double hour_angle) const
+{
+    double ySquare = m_c0 + m_c1 * std::sin( hour_angle - m_gamma );
 
     // Check if ySquare is negative
     if (ySquare < 0.0) {
@@ -19,15 +52,12 @@ double HourAngleKM::getActuatorLengthFromHourAngle(double hour_angle) const
 }
 
 // Implementation of the function that calculates elevation angle from actuator length
-double HourAngleKM::getHourAngleFromActuatorLength(double actuator_length) const 
+double HourAngleKM::findHourAngle(double actuator_length) const 
 {
-    double rab2 = m_rab * m_rab;
-    double rad2 = m_rad * m_rad;
-    double rbc2 = m_rbc * m_rbc;
     double y = actuator_length + m_offset;
     double y2 = y * y;
 
-    double sin_arg = (rbc2 + y2 - rab2 - rad2) / (2.0 * m_rab * m_rad );
+    double sin_arg = (y2 - m_c0) / m_c1;
 
     // Check if the argument of asin is within the valid range [-1, 1]
     if (sin_arg < -1.0 || sin_arg > 1.0) {
@@ -35,4 +65,59 @@ double HourAngleKM::getHourAngleFromActuatorLength(double actuator_length) const
     }
 
     return m_gamma + std::asin(sin_arg);
-}
\ No newline at end of file
+}
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+// 4 values per iteration, returns the number of values done
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t lengthsFromAngles4(std::size_t count, const double* angles, double* lengths,
+                                      double c0, double c1, double gamma, double offset)
+{
+    const __m256d nan = _mm256_set1_pd(std::numeric_limits<double>::quiet_NaN());
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d a = _mm256_sub_pd(_mm256_loadu_pd(angles + i), _mm256_set1_pd(gamma));
+        __m256d ySquare = _mm256_add_pd(_mm256_set1_pd(c0), _mm256_mul_pd(_mm256_set1_pd(c1), simd::sin(a)));
+        __m256d ans = _mm256_sub_pd(_mm256_sqrt_pd(ySquare), _mm256_set1_pd(offset));
+        ans = _mm256_blendv_pd(ans, nan, _mm256_cmp_pd(ySquare, _mm256_setzero_pd(), _CMP_LT_OQ));
+        _mm256_storeu_pd(lengths + i, ans);
+    }
+    return i;
+}
+
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t anglesFromLengths4(std::size_t count, const double* lengths, double* angles,
+                                      double c0, double c1, double gamma, double offset)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d y = _mm256_add_pd(_mm256_loadu_pd(lengths + i), _mm256_set1_pd(offset));
+        __m256d sinArg = _mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(y, y), _mm256_set1_pd(c0)), _mm256_set1_pd(c1));
+        __m256d ans = _mm256_add_pd(_mm256_set1_pd(gamma), simd::asin(sinArg)); // NaN outside [-1, 1]
+        _mm256_storeu_pd(angles + i, ans);
+    }
+    return i;
+}
+#endif
+
+void HourAngleKM::getActuatorLengthsFromHourAngles(std::size_t count, const double* angles, double* lengths) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (!hasApproximation() && simd::hasAVX2())
+        i = lengthsFromAngles4(count, angles, lengths, m_c0, m_c1, m_gamma, m_offset);
+#endif
+    for (; i < count; ++i)
+        lengths[i] = getActuatorLengthFromHourAngle(angles[i]);
+}
+
+void HourAngleKM::getHourAnglesFromActuatorLengths(std::size_t count, const double* lengths, double* angles) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (!hasApproximation() && simd::hasAVX2())
+        i = anglesFromLengths4(count, lengths, angles, m_c0, m_c1, m_gamma, m_offset);
+#endif
+    for (; i < count; ++i)
+        angles[i] = getHourAngleFromActuatorLength(lengths[i]);
+}
@@ -3,18 +3,20 @@
 #include "gcf.h"
 #include <cstring>
 
-Matrix4x4::Matrix4x4()
+template<class T>
+Matrix4x4T<T>::Matrix4x4T()
 {
     for (int i = 0; i < 4; ++i)
         for (int j = 0; j < 4; ++j)
-            m[i][j] = i == j ? 1. : 0.;
+            m[i][j] = i == j ? 1 : 0;
 }
 
-Matrix4x4::Matrix4x4(
-    double t00, double t01, double t02, double t03,
-    double t10, double t11, double t12, double t13,
-    double t20, double t21, double t22, double t23,
-    double t30, double t31, double t32, double t33
+template<class T>
+Matrix4x4T<T>::Matrix4x4T(
+    T t00, T t01, T t02, T t03,
+    T t10, T t11, T t12, T t13,
+    T t20, T t21, T t22, T t23,
+    T t30, T t31, T t32, T t33
 )
 {
     m[0][0] = t00; m[0][1] = t01; m[0][2] = t02; m[0][3] = t03;
@@ -23,19 +25,22 @@ Matrix4x4::Matrix4x4(
     m[3][0] = t30; m[3][1] = t31; m[3][2] = t32; m[3][3] = t33;
 }
 
-Matrix4x4::Matrix4x4(double array[4][4])
+template<class T>
+Matrix4x4T<T>::Matrix4x4T(T array[4][4])
 {
-    memcpy(m, array, 16*sizeof(double));
+    memcpy(m, array, 16*sizeof(T));
 }
 
-Matrix4x4::Matrix4x4(const Matrix4x4& rhs)
+template<class T>
+Matrix4x4T<T>::Matrix4x4T(const Matrix4x4T& rhs)
 {
     for (int i = 0; i < 4; ++i)
         for (int j = 0; j < 4; ++j)
             m[i][j] = rhs.m[i][j];
 }
 
-bool Matrix4x4::operator==(const Matrix4x4& matrix) const
+template<class T>
+bool Matrix4x4T<T>::operator==(const Matrix4x4T& matrix) const
 {
     if (this == &matrix) return true;
 
@@ -47,9 +52,10 @@ bool Matrix4x4::operator==(const Matrix4x4& matrix) const
     return true;
 }
 
-std::shared_ptr<Matrix4x4> Matrix4x4::transposed() const
+template<class T>
+std::shared_ptr<Matrix4x4T<T>> Matrix4x4T<T>::transposed() const
 {
-    return std::make_shared<Matrix4x4>(
+    return std::make_shared<Matrix4x4T<T>>(
         m[0][0], m[1][0], m[2][0], m[3][0],
         m[0][1], m[1][1], m[2][1], m[3][1],
         m[0][2], m[1][2], m[2][2], m[3][2],
@@ -57,38 +63,40 @@ std::shared_ptr<Matrix4x4> Matrix4x4::transposed() const
     );
 }
 
-std::shared_ptr<Matrix4x4> Matrix4x4::inversed() const
+template<class T>
+std::shared_ptr<Matrix4x4T<T>> Matrix4x4T<T>::inversed() const
 {
-    double det = m[0][1] * m[1][3] * m[2][2] * m[3][0] - m[0][1] * m[1][2] * m[2][3] * m[3][0] - m[0][0] * m[1][3] * m[2][2] * m[3][1] + m[0][0] * m[1][2] * m[2][3] * m[3][1]
+    T det = m[0][1] * m[1][3] * m[2][2] * m[3][0] - m[0][1] * m[1][2] * m[2][3] * m[3][0] - m[0][0] * m[1][3] * m[2][2] * m[3][1] + m[0][0] * m[1][2] * m[2][3] * m[3][1]
                  - m[0][1] * m[1][3] * m[2][0] * m[3][2] + m[0][0] * m[1][3] * m[2][1] * m[3][2] + m[0][1] * m[1][0] * m[2][3] * m[3][2] - m[0][0] * m[1][1] * m[2][3] * m[3][2]
                  + m[0][3] * (m[1][2] * m[2][1] * m[3][0] - m[1][1] * m[2][2] * m[3][0] - m[1][2] * m[2][0] * m[3][1] + m[1][0] * m[2][2] * m[3][1] + m[1][1] * m[2][0] * m[3][2] - m[1][0] * m[2][1] * m[3][2])
                  + m[3][3] * (m[0][1] * m[1][2] * m[2][0] - m[0][0] * m[1][2] * m[2][1] - m[0][1] * m[1][0] * m[2][2] + m[0][0] * m[1][1] * m[2][2])
                  + m[0][2] * (-m[1][3] * m[2][1] * m[3][0] + m[1][1] * m[2][3] * m[3][0] + m[1][3] * m[2][0] * m[3][1] - m[1][0] * m[2][3] * m[3][1] - m[1][1] * m[2][0] * m[3][3] + m[1][0] * m[2][1] * m[3][3]);
 
     if (fabs(det) < gcf::Epsilon) gcf::SevereError("Singular matrix in Matrix4x4::Inverse()");
-    double alpha = 1./det;
-
-    double inv00 = (-m[1][3] * m[2][2] * m[3][1] + m[1][2] * m[2][3] * m[3][1] + m[1][3] * m[2][1] * m[3][2] - m[1][1] * m[2][3] * m[3][2] - m[1][2] * m[2][1] * m[3][3] + m[1][1] * m[2][2] * m[3][3]) * alpha;
-    double inv01 = (m[0][3] * m[2][2] * m[3][1] - m[0][2] * m[2][3] * m[3][1] - m[0][3] * m[2][1] * m[3][2] + m[0][1] * m[2][3] * m[3][2] + m[0][2] * m[2][1] * m[3][3] - m[0][1] * m[2][2] * m[3][3]) * alpha;
-    double inv02 = (-m[0][3] * m[1][2] * m[3][1] + m[0][2] * m[1][3] * m[3][1] + m[0][3] * m[1][1] * m[3][2] - m[0][1] * m[1][3] * m[3][2] - m[0][2] * m[1][1] * m[3][3] + m[0][1] * m[1][2] * m[3][3]) * alpha;
-    double inv03 = (m[0][3] * m[1][2] * m[2][1] - m[0][2] * m[1][3] * m[2][1] - m[0][3] * m[1][1] * m[2][2] + m[0][1] * m[1][3] * m[2][2] + m[0][2] * m[1][1] * m[2][3] - m[0][1] * m[1][2] * m[2][3]) * alpha;
-    double inv10 = (m[1][3] * m[2][2] * m[3][0] - m[1][2] * m[2][3] * m[3][0] - m[1][3] * m[2][0] * m[3][2] + m[1][0] * m[2][3] * m[3][2] + m[1][2] * m[2][0] * m[3][3] - m[1][0] * m[2][2] * m[3][3]) * alpha;
-    double inv11 = (-m[0][3] * m[2][2] * m[3][0] + m[0][2] * m[2][3] * m[3][0] + m[0][3] * m[2][0] * m[3][2] - m[0][0] * m[2][3] * m[3][2] - m[0][2] * m[2][0] * m[3][3] + m[0][0] * m[2][2] * m[3][3]) * alpha;
-    double inv12 = (m[0][3] * m[1][2] * m[3][0] - m[0][2] * m[1][3] * m[3][0] - m[0][3] * m[1][0] * m[3][2] + m[0][0] * m[1][3] * m[3][2] + m[0][2] * m[1][0] * m[3][3] - m[0][0] * m[1][2] * m[3][3]) * alpha;
-    double inv13 = (-m[0][3] * m[1][2] * m[2][0] + m[0][2] * m[1][3] * m[2][0] + m[0][3] * m[1][0] * m[2][2] - m[0][0] * m[1][3] * m[2][2] - m[0][2] * m[1][0] * m[2][3] + m[0][0] * m[1][2] * m[2][3]) * alpha;
-    double inv20 = (-m[1][3] * m[2][1] * m[3][0] + m[1][1] * m[2][3] * m[3][0] + m[1][3] * m[2][0] * m[3][1] - m[1][0] * m[2][3] * m[3][1] - m[1][1] * m[2][0] * m[3][3] + m[1][0] * m[2][1] * m[3][3]) * alpha;
-    double inv21 = (m[0][3] * m[2][1] * m[3][0] - m[0][1] * m[2][3] * m[3][0] - m[0][3] * m[2][0] * m[3][1] + m[0][0] * m[2][3] * m[3][1] + m[0][1] * m[2][0] * m[3][3] - m[0][0] * m[2][1] * m[3][3]) * alpha;
-    double inv22 = (-m[0][3] * m[1][1] * m[3][0] + m[0][1] * m[1][3] * m[3][0] + m[0][3] * m[1][0] * m[3][1] - m[0][0] * m[1][3] * m[3][1] - m[0][1] * m[1][0] * m[3][3] + m[0][0] * m[1][1] * m[3][3]) * alpha;
-    double inv23 = (m[0][3] * m[1][1] * m[2][0] - m[0][1] * m[1][3] * m[2][0] - m[0][3] * m[1][0] * m[2][1] + m[0][0] * m[1][3] * m[2][1] + m[0][1] * m[1][0] * m[2][3] - m[0][0] * m[1][1] * m[2][3]) * alpha;
-    double inv30 = (m[1][2] * m[2][1] * m[3][0] - m[1][1] * m[2][2] * m[3][0] - m[1][2] * m[2][0] * m[3][1] + m[1][0] * m[2][2] * m[3][1] + m[1][1] * m[2][0] * m[3][2] - m[1][0] * m[2][1] * m[3][2]) * alpha;
-    double inv31 = (-m[0][2] * m[2][1] * m[3][0] + m[0][1] * m[2][2] * m[3][0] + m[0][2] * m[2][0] * m[3][1] - m[0][0] * m[2][2] * m[3][1] - m[0][1] * m[2][0] * m[3][2] + m[0][0] * m[2][1] * m[3][2]) * alpha;
-    double inv32 = (m[0][2] * m[1][1] * m[3][0] - m[0][1] * m[1][2] * m[3][0] - m[0][2] * m[1][0] * m[3][1] + m[0][0] * m[1][2] * m[3][1] + m[0][1] * m[1][0] * m[3][2] - m[0][0] * m[1][1] * m[3][2]) * alpha;
-    double inv33 = (-m[0][2] * m[1][1] * m[2][0] + m[0][1] * m[1][2] * m[2][0] + m[0][2] * m[1][0] * m[2][1] - m[0][0] * m[1][2] * m[2][1] - m[0][1] * m[1][0] * m[2][2] + m[0][0] * m[1][1] * m[2][2]) * alpha;
-
-    return std::make_shared<Matrix4x4>(inv00, inv01, inv02, inv03, inv10, inv11, inv12, inv13, inv20, inv21, inv22, inv23, inv30, inv31, inv32, inv33);
+    T alpha = T(1)/det;
+
+    T inv00 = (-m[1][3] * m[2][2] * m[3][1] + m[1][2] * m[2][3] * m[3][1] + m[1][3] * m[2][1] * m[3][2] - m[1][1] * m[2][3] * m[3][2] - m[1][2] * m[2][1] * m[3][3] + m[1][1] * m[2][2] * m[3][3]) * alpha;
+    T inv01 = (m[0][3] * m[2][2] * m[3][1] - m[0][2] * m[2][3] * m[3][1] - m[0][3] * m[2][1] * m[3][2] + m[0][1] * m[2][3] * m[3][2] + m[0][2] * m[2][1] * m[3][3] - m[0][1] * m[2][2] * m[3][3]) * alpha;
+    T inv02 = (-m[0][3] * m[1][2] * m[3][1] + m[0][2] * m[1][3] * m[3][1] + m[0][3] * m[1][1] * m[3][2] - m[0][1] * m[1][3] * m[3][2] - m[0][2] * m[1][1] * m[3][3] + m[0][1] * m[1][2] * m[3][3]) * alpha;
+    T inv03 = (m[0][3] * m[1][2] * m[2][1] - m[0][2] * m[1][3] * m[2][1] - m[0][3] * m[1][1] * m[2][2] + m[0][1] * m[1][3] * m[2][2] + m[0][2] * m[1][1] * m[2][3] - m[0][1] * m[1][2] * m[2][3]) * alpha;
+    T inv10 = (m[1][3] * m[2][2] * m[3][0] - m[1][2] * m[2][3] * m[3][0] - m[1][3] * m[2][0] * m[3][2] + m[1][0] * m[2][3] * m[3][2] + m[1][2] * m[2][0] * m[3][3] - m[1][0] * m[2][2] * m[3][3]) * alpha;
+    T inv11 = (-m[0][3] * m[2][2] * m[3][0] + m[0][2] * m[2][3] * m[3][0] + m[0][3] * m[2][0] * m[3][2] - m[0][0] * m[2][3] * m[3][2] - m[0][2] * m[2][0] * m[3][3] + m[0][0] * m[2][2] * m[3][3]) * alpha;
+    T inv12 = (m[0][3] * m[1][2] * m[3][0] - m[0][2] * m[1][3] * m[3][0] - m[0][3] * m[1][0] * m[3][2] + m[0][0] * m[1][3] * m[3][2] + m[0][2] * m[1][0] * m[3][3] - m[0][0] * m[1][2] * m[3][3]) * alpha;
+    T inv13 = (-m[0][3] * m[1][2] * m[2][0] + m[0][2] * m[1][3] * m[2][0] + m[0][3] * m[1][0] * m[2][2] - m[0][0] * m[1][3] * m[2][2] - m[0][2] * m[1][0] * m[2][3] + m[0][0] * m[1][2] * m[2][3]) * alpha;
+    T inv20 = (-m[1][3] * m[2][1] * m[3][0] + m[1][1] * m[2][3] * m[3][0] + m[1][3] * m[2][0] * m[3][1] - m[1][0] * m[2][3] * m[3][1] - m[1][1] * m[2][0] * m[3][3] + m[1][0] * m[2][1] * m[3][3]) * alpha;
+    T inv21 = (m[0][3] * m[2][1] * m[3][0] - m[0][1] * m[2][3] * m[3][0] - m[0][3] * m[2][0] * m[3][1] + m[0][0] * m[2][3] * m[3][1] + m[0][1] * m[2][0] * m[3][3] - m[0][0] * m[2][1] * m[3][3]) * alpha;
+    T inv22 = (-m[0][3] * m[1][1] * m[3][0] + m[0][1] * m[1][3] * m[3][0] + m[0][3] * m[1][0] * m[3][1] - m[0][0] * m[1][3] * m[3][1] - m[0][1] * m[1][0] * m[3][3] + m[0][0] * m[1][1] * m[3][3]) * alpha;
+    T inv23 = (m[0][3] * m[1][1] * m[2][0] - m[0][1] * m[1][3] * m[2][0] - m[0][3] * m[1][0] * m[2][1] + m[0][0] * m[1][3] * m[2][1] + m[0][1] * m[1][0] * m[2][3] - m[0][0] * m[1][1] * m[2][3]) * alpha;
+    T inv30 = (m[1][2] * m[2][1] * m[3][0] - m[1][1] * m[2][2] * m[3][0] - m[1][2] * m[2][0] * m[3][1] + m[1][0] * m[2][2] * m[3][1] + m[1][1] * m[2][0] * m[3][2] - m[1][0] * m[2][1] * m[3][2]) * alpha;
+    T inv31 = (-m[0][2] * m[2][1] * m[3][0] + m[0][1] * m[2][2] * m[3][0] + m[0][2] * m[2][0] * m[3][1] - m[0][0] * m[2][2] * m[3][1] - m[0][1] * m[2][0] * m[3][2] + m[0][0] * m[2][1] * m[3][2]) * alpha;
+    T inv32 = (m[0][2] * m[1][1] * m[3][0] - m[0][1] * m[1][2] * m[3][0] - m[0][2] * m[1][0] * m[3][1] + m[0][0] * m[1][2] * m[3][1] + m[0][1] * m[1][0] * m[3][2] - m[0][0] * m[1][1] * m[3][2]) * alpha;
+    T inv33 = (-m[0][2] * m[1][1] * m[2][0] + m[0][1] * m[1][2] * m[2][0] + m[0][2] * m[1][0] * m[2][1] - m[0][0] * m[1][2] * m[2][1] - m[0][1] * m[1][0] * m[2][2] + m[0][0] * m[1][1] * m[2][2]) * alpha;
+
+    return std::make_shared<Matrix4x4T<T>>(inv00, inv01, inv02, inv03, inv10, inv11, inv12, inv13, inv20, inv21, inv22, inv23, inv30, inv31, inv32, inv33);
 }
 
-double Matrix4x4::determinant() const
+template<class T>
+T Matrix4x4T<T>::determinant() const
 {
 //    01 02 03
 //    11 12 13
@@ -105,7 +113,7 @@ double Matrix4x4::determinant() const
 //    00 01 02
 //    10 11 12
 //    20 21 22
-    double det =
+    T det =
         - m[3][0]*(
             + m[0][1]*m[1][2]*m[2][3]
             + m[0][2]*m[1][3]*m[2][1]
@@ -142,19 +150,21 @@ double Matrix4x4::determinant() const
     return det;
 }
 
-std::shared_ptr<Matrix4x4> multiply(const Matrix4x4& m1, const Matrix4x4& m2)
+template<class T>
+std::shared_ptr<Matrix4x4T<T>> multiply(const Matrix4x4T<T>& m1, const Matrix4x4T<T>& m2)
 {
-    double r[4][4];
+    T r[4][4];
     for (int i = 0; i < 4; ++i)
         for (int j = 0; j < 4; ++j)
             r[i][j] = m1.m[i][0] * m2.m[0][j] +
                       m1.m[i][1] * m2.m[1][j] +
                       m1.m[i][2] * m2.m[2][j] +
                       m1.m[i][3] * m2.m[3][j];
-    return std::make_shared<Matrix4x4>(r);
+    return std::make_shared<Matrix4x4T<T>>(r);
 }
 
-std::ostream& operator<<(std::ostream& os, const Matrix4x4& matrix)
+template<class T>
+std::ostream& operator<<(std::ostream& os, const Matrix4x4T<T>& matrix)
 {
     for (int i = 0; i < 4; ++i)
     {
@@ -170,3 +180,10 @@ std::ostream& operator<<(std::ostream& os, const Matrix4x4& matrix)
     return os;
 }
 
+template class Matrix4x4T<double>;
+template class Matrix4x4T<float>;
+
+template std::shared_ptr<Matrix4x4T<double>> multiply(const Matrix4x4T<double>& m1, const Matrix4x4T<double>& m2);
+template std::shared_ptr<Matrix4x4T<float>> multiply(const Matrix4x4T<float>& m1, const Matrix4x4T<float>& m2);
+template std::ostream& operator<<(std::ostream& os, const Matrix4x4T<double>& matrix);
+template std::ostream& operator<<(std::ostream& os, const Matrix4x4T<float>& matrix);
@@ -0,0 +1,134 @@
+#include "PiecewiseChebyshev.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "gcf.h"
+
+PiecewiseChebyshev::PiecewiseChebyshev():
+    m_interval(),
+    m_degree(0),
+    m_segments(0),
+    m_scale(0.),
+    m_error(0.)
+{
+
+}
+
+PiecewiseChebyshev::PiecewiseChebyshev(const std::function<double(double)>& f, const Interval& interval,
+                                       double tolerance, int degree, int segmentsMax):
+    m_interval(interval),
+    m_degree(degree),
+    m_segments(1),
+    m_error(0.)
+{
+    if (!(interval.size() > 0.) || degree < 0 || !(tolerance > 0.))
+        throw std::invalid_argument("PiecewiseChebyshev: invalid interval, degree or tolerance");
+
+    for (;; m_segments *= 2) {
+        m_scale = m_segments/m_interval.size();
+        fit(f);
+        m_error = findError(f);
+        if (m_error <= tolerance/2.) return; // margin for the error between the test points
+        if (2*m_segments > segmentsMax)
+            throw std::runtime_error("PiecewiseChebyshev: tolerance not reached, the function may be singular in the interval");
+    }
+}
+
+void PiecewiseChebyshev::fit(const std::function<double(double)>& f)
+{
+    int nc = m_degree + 1;
+    m_coefficients.assign(m_segments*nc, 0.);
+
+    // monomial coefficients of the Chebyshev polynomials, lowest power first
+    std::vector<std::vector<double>> T(nc, std::vector<double>(nc, 0.));
+    T[0][0] = 1.;
+    if (nc > 1) T[1][1] = 1.;
+    for (int k = 2; k < nc; ++k)
+        for (int p = 0; p < nc; ++p)
+            T[k][p] = (p > 0 ? 2.*T[k - 1][p - 1] : 0.) - T[k - 2][p];
+
+    std::vector<double> nodes(nc), values(nc), monomials(nc);
+    for (int j = 0; j < nc; ++j)
+        nodes[j] = std::cos(gcf::Pi*(j + 0.5)/nc);
+
+    double h = 1./m_scale;
+    for (int n = 0; n < m_segments; ++n) {
+        double x0 = m_interval.min() + n*h;
+        for (int j = 0; j < nc; ++j) {
+            values[j] = f(x0 + (nodes[j] + 1.)*h/2.);
+            if (!std::isfinite(values[j]))
+                throw std::invalid_argument("PiecewiseChebyshev: function is not finite in the interval");
+        }
+
+        std::fill(monomials.begin(), monomials.end(), 0.);
+        for (int k = 0; k < nc; ++k) {
+            double c = 0.;
+            for (int j = 0; j < nc; ++j)
+                c += values[j]*std::cos(gcf::Pi*k*(j + 0.5)/nc);
+            c *= (k == 0 ? 1. : 2.)/nc;
+            for (int p = 0; p < nc; ++p)
+                monomials[p] += c*T[k][p];
+        }
+
+        double* c = &m_coefficients[n*nc];
+        for (int p = 0; p < nc; ++p)
+            c[p] = monomials[nc - 1 - p];
+    }
+}
+
+double PiecewiseChebyshev::findError(const std::function<double(double)>& f) const
+{
+    const int samples = 8*(m_degree + 1);
+    double h = 1./m_scale;
+    double ans = 0.;
+    for (int n = 0; n < m_segments; ++n) {
+        for (int s = 0; s <= samples; ++s) {
+            double x = m_interval.min() + (n + double(s)/samples)*h;
+            x = std::min(x, m_interval.max());
+            double e = std::abs((*this)(x) - f(x));
+            if (!std::isfinite(e))
+                throw std::invalid_argument("PiecewiseChebyshev: function is not finite in the interval");
+            ans = std::max(ans, e);
+        }
+    }
+    return ans;
+}
+
+PiecewiseChebyshevPair::PiecewiseChebyshevPair():
+    m_tolerance(0.),
+    m_inverseTolerance(0.)
+{
+
+}
+
+void PiecewiseChebyshevPair::fit(const std::function<double(double)>& f, const std::function<double(double)>& inverse,
+                                 const Interval& interval, double tolerance, double inverseTolerance)
+{
+    clear();
+    PiecewiseChebyshev function(f, interval, tolerance);
+
+    Interval range;
+    const int samples = 1024;
+    for (int i = 0; i <= samples; ++i)
+        range << f(interval.fromNormalized(double(i)/samples));
+
+    m_inverse = PiecewiseChebyshev(inverse, range, inverseTolerance);
+    m_function = function;
+    m_tolerance = tolerance;
+    m_inverseTolerance = inverseTolerance;
+}
+
+void PiecewiseChebyshevPair::refit(const std::function<double(double)>& f, const std::function<double(double)>& inverse)
+{
+    if (isEmpty()) return;
+    Interval interval = m_function.get_interval();
+    fit(f, inverse, interval, m_tolerance, m_inverseTolerance);
+}
+
+void PiecewiseChebyshevPair::clear()
+{
+    m_function = PiecewiseChebyshev();
+    m_inverse = PiecewiseChebyshev();
+}
@@ -1,10 +1,20 @@
 // PythonWrapper.cpp
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include "AffineTransform.h"
+#include "ArrayView.h"
+#include "ThreadPool.h"
 #include "TrackerTarget.h"
 #include "TrackerArmature2A.h"
 #include "ElevationAngleKM.h"
 #include "HourAngleKM.h"
+#include "ResultStore.h"
 #include "Transform.h"
 #include "vec3d.h"
 #include "vec2d.h"
@@ -25,7 +35,142 @@ convertMatrix(const std::vector<std::vector<double>>& matrix) {
     );
 }
 
+// Thread pool of the batch functions, replaced by set_thread_count.
+// Batch calls take a reference while holding the GIL, so a pool being replaced stays alive until they finish.
+std::shared_ptr<ThreadPool> threadPool;
+
+std::shared_ptr<ThreadPool> getThreadPool() {
+    if (!threadPool) threadPool = std::make_shared<ThreadPool>();
+    return threadPool;
+}
+
+typedef py::array_t<double, py::array::forcecast> DoubleArray;
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> ContiguousDoubleArray;
+
+TrackerTarget::AimingType convertAimingType(const std::string& aimingType) {
+    if (aimingType == "global") return TrackerTarget::global;
+    if (aimingType == "local") return TrackerTarget::local;
+    throw std::invalid_argument("aiming_type must be 'global' or 'local'.");
+}
+
+// Zero-copy view of an (N, 3) array of doubles, a (3,) array is repeated for every heliostat.
+// Arrays with other dtypes are converted by pybind11, arrays with negative or unaligned strides are copied.
+// count is set by the first (N, 3) array and checked against the following ones.
+vec3dArrayView makeVec3dView(DoubleArray& array, py::ssize_t& count, const char* name) {
+    const py::ssize_t itemsize = sizeof(double);
+    bool single = array.ndim() == 1 && array.shape(0) == 3;
+    if (!single && (array.ndim() != 2 || array.shape(1) != 3))
+        throw std::invalid_argument(std::string(name) + " must have shape (N, 3) or (3,).");
+    for (py::ssize_t k = 0; k < array.ndim(); ++k) {
+        if (array.strides(k) < 0 || array.strides(k) % itemsize != 0) {
+            array = py::reinterpret_borrow<DoubleArray>(ContiguousDoubleArray::ensure(array));
+            break;
+        }
+    }
+
+    const double* data = array.data();
+    if (single) {
+        py::ssize_t s = array.strides(0)/itemsize;
+        return vec3dArrayView(data, data + s, data + 2*s, 0);
+    }
+    if (count < 0)
+        count = array.shape(0);
+    else if (array.shape(0) != count)
+        throw std::invalid_argument(std::string(name) + " must have one row per heliostat.");
+    py::ssize_t s = array.strides(1)/itemsize;
+    return vec3dArrayView(data, data + s, data + 2*s, std::size_t(array.strides(0)/itemsize));
+}
+
+// Angles in degrees, shape (N, 2), for N heliostats sharing the armature.
+// sun_vectors and aiming_points have shape (N, 3) or (3,), in the global frame when transforms
+// (heliostat to global, shape (N, 4, 4)) are given and in the heliostat frame otherwise.
+// For local aiming the aiming points are always in the heliostat frame, as in TrackerArmature2A.update.
+// The solver runs with the GIL released on the module thread pool, the armature must not be modified meanwhile.
+py::array_t<double> updateBatch(const TrackerArmature2A& armature, DoubleArray sunVectors, DoubleArray aimingPoints,
+                                std::optional<ContiguousDoubleArray> transforms, const std::string& aimingTypeName) {
+    TrackerTarget::AimingType aimingType = convertAimingType(aimingTypeName);
+    py::ssize_t count = -1;
+    if (transforms) {
+        if (transforms->ndim() != 3 || transforms->shape(1) != 4 || transforms->shape(2) != 4)
+            throw std::invalid_argument("transforms must have shape (N, 4, 4).");
+        count = transforms->shape(0);
+    }
+    vec3dArrayView vSun = makeVec3dView(sunVectors, count, "sun_vectors");
+    vec3dArrayView rAim = makeVec3dView(aimingPoints, count, "aiming_points");
+    if (count < 0) count = 1;
+
+    py::array_t<double> ans({count, py::ssize_t(2)});
+    vec2dArrayView angles = vec2dArrayView::interleaved(ans.mutable_data());
+    const double* matrices = transforms ? transforms->data() : nullptr;
+
+    std::shared_ptr<ThreadPool> pool = getThreadPool();
+    armature.compile(); // with the GIL held, so that Python setters cannot run during the rebuild
+    {
+        py::gil_scoped_release release;
+        pool->parallelFor(count, [&](std::size_t begin, std::size_t end) {
+            std::size_t n = end - begin;
+            if (!matrices) {
+                armature.updateBatch(n, vSun.from(begin), rAim.from(begin), aimingType, angles.from(begin));
+                return;
+            }
+            std::vector<double> local(6*n); // sun vectors and aiming points in the heliostat frames
+            for (std::size_t i = begin; i < end; ++i) {
+                double mdir[3][4];
+                for (int r = 0; r < 3; ++r)
+                    for (int c = 0; c < 4; ++c)
+                        mdir[r][c] = matrices[16*i + 4*r + c];
+                AffineTransform toLocal = AffineTransform(mdir).inversed();
+                vec3d v = toLocal.transformVector(vSun[i]);
+                vec3d p = aimingType == TrackerTarget::global ? toLocal.transformPoint(rAim[i]) : rAim[i];
+                double* d = local.data() + 6*(i - begin);
+                d[0] = v.x; d[1] = v.y; d[2] = v.z;
+                d[3] = p.x; d[4] = p.y; d[5] = p.z;
+            }
+            const double* d = local.data();
+            armature.updateBatch(n, vec3dArrayView(d, d + 1, d + 2, 6), vec3dArrayView(d + 3, d + 4, d + 5, 6), aimingType, angles.from(begin));
+        }, 64);
+    }
+    return ans;
+}
+
+// Applies a batch function (count, input, output) to an array of any shape, with the GIL released on the thread pool
+template<class Function>
+py::array_t<double> mapArray(ContiguousDoubleArray input, Function function) {
+    py::array_t<double> ans(std::vector<py::ssize_t>(input.shape(), input.shape() + input.ndim()));
+    const double* x = input.data();
+    double* y = ans.mutable_data();
+    std::shared_ptr<ThreadPool> pool = getThreadPool();
+    {
+        py::gil_scoped_release release;
+        pool->parallelFor(input.size(), [&](std::size_t begin, std::size_t end) {
+            function(end - begin, x + begin, y + begin);
+        }, 4096);
+    }
+    return ans;
+}
+
+// Result store of a Python object, which must be open
+ResultStore& castStore(py::handle store) {
+    ResultStore& ans = store.cast<ResultStore&>();
+    if (!ans.isOpen())
+        throw std::runtime_error("ResultStore: the store is not open.");
+    return ans;
+}
+
+// Zero-copy view of mapped values, the array keeps the store (and the mapping) alive through its base.
+// The array is read-only unless the store was opened writable.
+py::array_t<float> makeStoreArray(py::handle store, const float* data, std::vector<py::ssize_t> shape) {
+    py::array_t<float> ans(shape, data, store);
+    if (!castStore(store).isWritable())
+        ans.attr("flags").attr("writeable") = false;
+    return ans;
+}
+
 PYBIND11_MODULE(heliostat_tracking_module, m) {
+    m.def("set_thread_count", [](int threads) { threadPool = std::make_shared<ThreadPool>(threads); },
+          py::arg("threads"), "Threads used by the batch functions, 0 uses all hardware threads.");
+    m.def("get_thread_count", []() { return getThreadPool()->get_threads(); });
+
     py::class_<vec3d>(m, "vec3d")
         .def(py::init<double, double, double>())
         .def_readwrite("x", &vec3d::x)
@@ -64,7 +209,10 @@ PYBIND11_MODULE(heliostat_tracking_module, m) {
 
     py::class_<TrackerArmature2A>(m, "TrackerArmature2A")
         .def(py::init<>())
-        .def("update", &TrackerArmature2A::update)
+        .def("update", py::overload_cast<const Transform&, const vec3d&, TrackerTarget*>(&TrackerArmature2A::update))
+        .def("update_batch", &updateBatch,
+             py::arg("sun_vectors"), py::arg("aiming_points"),
+             py::arg("transforms") = py::none(), py::arg("aiming_type") = "global")
         .def("set_primary_shift", &TrackerArmature2A::set_primaryShift)
         .def("set_primary_axis", &TrackerArmature2A::set_primaryAxis)
         .def("set_primary_angles", &TrackerArmature2A::set_primaryAngles)
@@ -78,10 +226,79 @@ PYBIND11_MODULE(heliostat_tracking_module, m) {
     py::class_<ElevationAngleKM>(m, "ElevationAngleKM")
         .def(py::init<double, double, double, double, double, double>())
         .def("get_actuator_length_from_elevation_angle", &ElevationAngleKM::getActuatorLengthFromElevationAngle)
-        .def("get_elevation_angle_from_actuator_length", &ElevationAngleKM::getElevationAngleFromActuatorLength);
+        .def("get_elevation_angle_from_actuator_length", &ElevationAngleKM::getElevationAngleFromActuatorLength)
+        .def("get_actuator_lengths_from_elevation_angles", [](const ElevationAngleKM& km, ContiguousDoubleArray angles) {
+            return mapArray(angles, [&km](std::size_t n, const double* x, double* y) { km.getActuatorLengthsFromElevationAngles(n, x, y); });
+        })
+        .def("get_elevation_angles_from_actuator_lengths", [](const ElevationAngleKM& km, ContiguousDoubleArray lengths) {
+            return mapArray(lengths, [&km](std::size_t n, const double* x, double* y) { km.getElevationAnglesFromActuatorLengths(n, x, y); });
+        });
 
     py::class_<HourAngleKM>(m, "HourAngleKM")
         .def(py::init<double, double, double, double, double>())
         .def("get_actuator_length_from_hour_angle", &HourAngleKM::getActuatorLengthFromHourAngle)
-        .def("get_hour_angle_from_actuator_length", &HourAngleKM::getHourAngleFromActuatorLength);
-}
\ No newline at end of file
+        .def("get_hour_angle_from_actuator_length", &HourAngleKM::getHourAngleFromActuatorLength)
+        .def("get_actuator_lengths_from_hour_angles", [](const HourAngleKM& km, ContiguousDoubleArray angles) {
+            return mapArray(angles, [&km](std::size_t n, const double* x, double* y) { km.getActuatorLengthsFromHourAngles(n, x, y); });
+        })
+        .def("get_hour_angles_from_actuator_lengths", [](const HourAngleKM& km, ContiguousDoubleArray lengths) {
+            return mapArray(lengths, [&km](std::size_t n, const double* x, double* y) { km.getHourAnglesFromActuatorLengths(n, x, y); });
+        });
+
+    py::enum_<SimulationFileHeader::Column>(m, "Column")
+        .value("primary_angle", SimulationFileHeader::primaryAngle)
+        .value("secondary_angle", SimulationFileHeader::secondaryAngle)
+        .value("elevation_length", SimulationFileHeader::elevationLength)
+        .value("hour_length", SimulationFileHeader::hourLength);
+
+    // The file stays mapped while the store or any array of it is alive, so the store has no close method.
+    // chunk returns the values of a column for the steps of a chunk with shape (steps, heliostats),
+    // a file written with chunk_steps >= steps has a single chunk holding the whole time range.
+    py::class_<ResultStore>(m, "ResultStore")
+        .def(py::init([](const std::string& fileName, bool writable) {
+            auto store = std::make_unique<ResultStore>();
+            store->open(fileName, writable);
+            return store;
+        }), py::arg("file_name"), py::arg("writable") = false)
+        .def_property_readonly("heliostats", [](py::handle self) { return castStore(self).heliostats(); })
+        .def_property_readonly("steps", [](py::handle self) { return castStore(self).steps(); })
+        .def_property_readonly("chunks", [](py::handle self) { return castStore(self).chunks(); })
+        .def_property_readonly("chunk_steps", [](py::handle self) { return castStore(self).get_header().chunkSteps; })
+        .def_property_readonly("columns", [](py::handle self) { return castStore(self).get_header().columns; })
+        .def_property_readonly("time_start", [](py::handle self) { return castStore(self).get_header().timeStart; })
+        .def_property_readonly("step", [](py::handle self) { return castStore(self).get_header().step; })
+        .def_property_readonly("longitude", [](py::handle self) { return castStore(self).get_header().longitude; })
+        .def_property_readonly("latitude", [](py::handle self) { return castStore(self).get_header().latitude; })
+        .def("find_step", [](py::handle self, double time) -> std::optional<std::uint64_t> {
+            std::uint64_t step = castStore(self).findStep(time);
+            if (step == ResultStore::npos) return std::nullopt;
+            return step;
+        }, py::arg("time"))
+        .def("times", [](py::handle self) {
+            const ResultStore& store = castStore(self);
+            py::array_t<double> ans(py::ssize_t(store.steps()));
+            double* t = ans.mutable_data();
+            for (std::uint64_t j = 0; j < store.steps(); ++j)
+                t[j] = store.get_time(j);
+            return ans;
+        })
+        .def("sun_vectors", [](py::handle self) {
+            const ResultStore& store = castStore(self);
+            py::array_t<double> ans({py::ssize_t(store.steps()), py::ssize_t(3)});
+            double* v = ans.mutable_data();
+            for (std::uint64_t j = 0; j < store.steps(); ++j) {
+                vec3d s = store.get_sunVector(j);
+                v[3*j] = s.x; v[3*j + 1] = s.y; v[3*j + 2] = s.z;
+            }
+            return ans;
+        })
+        .def("chunk", [](py::handle self, std::uint64_t k, SimulationFileHeader::Column c) {
+            const ResultStore& store = castStore(self);
+            const float* data = store.column(k, c);
+            return makeStoreArray(self, data, {py::ssize_t(store.get_header().chunkSize(k)), py::ssize_t(store.heliostats())});
+        }, py::arg("chunk"), py::arg("column"))
+        .def("values", [](py::handle self, std::uint64_t step, SimulationFileHeader::Column c) {
+            const ResultStore& store = castStore(self);
+            return makeStoreArray(self, store.values(step, c), {py::ssize_t(store.heliostats())});
+        }, py::arg("step"), py::arg("column"));
+}
@@ -0,0 +1,326 @@
+#include "ResultStore.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const char SimulationFileHeader::Magic[8] = {'H', 'T', 'S', 'I', 'M', 0, 0, 0};
+
+namespace {
+
+std::uint64_t padded(std::uint64_t bytes)
+{
+    return (bytes + 7)/8*8;
+}
+
+}
+
+std::uint64_t SimulationFileHeader::chunkBytes(std::uint64_t n) const
+{
+    return padded(n*sizeof(double)) + padded(3*n*sizeof(double)) + columns*padded(n*heliostats*sizeof(float));
+}
+
+std::uint64_t SimulationFileHeader::fileBytes() const
+{
+    std::uint64_t k = chunks();
+    if (k == 0) return sizeof(SimulationFileHeader);
+    return chunkOffset(k - 1) + chunkBytes(chunkSize(k - 1));
+}
+
+bool SimulationFileHeader::isValid() const
+{
+    return std::memcmp(magic, Magic, sizeof(Magic)) == 0 && version == Version &&
+           (columns == 2 || columns == 4) && (steps == 0 || chunkSteps > 0);
+}
+
+ResultStore::ResultStore():
+    m_data(nullptr),
+    m_size(0),
+    m_writable(false)
+{
+
+}
+
+ResultStore::~ResultStore()
+{
+    close();
+}
+
+ResultStore::ResultStore(ResultStore&& other) noexcept:
+    m_data(other.m_data),
+    m_size(other.m_size),
+    m_writable(other.m_writable)
+{
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_writable = false;
+}
+
+ResultStore& ResultStore::operator=(ResultStore&& other) noexcept
+{
+    if (this != &other) {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_writable, other.m_writable);
+    }
+    return *this;
+}
+
+void ResultStore::create(const std::string& fileName, const SimulationFileHeader& header)
+{
+    if (!header.isValid())
+        throw std::invalid_argument("ResultStore: invalid header");
+    close();
+    map(fileName, header.fileBytes(), true, true);
+    std::memcpy(m_data, &header, sizeof(header));
+}
+
+void ResultStore::open(const std::string& fileName, bool writable)
+{
+    close();
+    map(fileName, 0, writable, false);
+    SimulationFileHeader header;
+    bool valid = m_size >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, m_data, sizeof(header));
+        valid = header.isValid() && header.fileBytes() == m_size;
+    }
+    if (!valid) {
+        close();
+        throw std::runtime_error("ResultStore: invalid result file " + fileName);
+    }
+}
+
+#ifdef _WIN32
+
+void ResultStore::map(const std::string& fileName, std::uint64_t size, bool writable, bool create)
+{
+    HANDLE file = CreateFileA(fileName.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("ResultStore: cannot open " + fileName);
+
+    LARGE_INTEGER length;
+    bool ok;
+    if (create) {
+        // setting the end of the file allocates it
+        length.QuadPart = LONGLONG(size);
+        ok = SetFilePointerEx(file, length, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+    } else {
+        ok = GetFileSizeEx(file, &length);
+        size = std::uint64_t(length.QuadPart);
+    }
+    ok = ok && size > 0 && size <= std::numeric_limits<SIZE_T>::max();
+
+    // the view keeps the file mapped after the handles are closed
+    void* data = nullptr;
+    if (ok) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY,
+                                            DWORD(size >> 32), DWORD(size), nullptr);
+        if (mapping) {
+            data = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, SIZE_T(size));
+            CloseHandle(mapping);
+        }
+    }
+    CloseHandle(file);
+    if (!data)
+        throw std::runtime_error("ResultStore: cannot map " + fileName);
+
+    m_data = static_cast<char*>(data);
+    m_size = size;
+    m_writable = writable;
+}
+
+void ResultStore::flush()
+{
+    if (m_data && m_writable && !FlushViewOfFile(m_data, 0))
+        throw std::runtime_error("ResultStore: cannot write the file");
+}
+
+void ResultStore::close()
+{
+    if (!m_data) return;
+    UnmapViewOfFile(m_data);
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+
+#else
+
+void ResultStore::map(const std::string& fileName, std::uint64_t size, bool writable, bool create)
+{
+    int flags = writable ? O_RDWR : O_RDONLY;
+    if (create) flags |= O_CREAT | O_TRUNC;
+    int file = ::open(fileName.c_str(), flags, 0644);
+    if (file < 0)
+        throw std::runtime_error("ResultStore: cannot open " + fileName);
+
+    bool ok;
+    if (create) {
+        // reserving the blocks up front avoids a fault on a full disk while writing through the mapping
+#ifdef __APPLE__
+        ok = ftruncate(file, off_t(size)) == 0;
+#else
+        ok = posix_fallocate(file, 0, off_t(size)) == 0;
+#endif
+    } else {
+        struct stat status;
+        ok = fstat(file, &status) == 0;
+        size = ok ? std::uint64_t(status.st_size) : 0;
+    }
+    ok = ok && size > 0 && size <= std::numeric_limits<std::size_t>::max();
+
+    // the mapping stays valid after the file is closed
+    void* data = MAP_FAILED;
+    if (ok)
+        data = mmap(nullptr, std::size_t(size), writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED)
+        throw std::runtime_error("ResultStore: cannot map " + fileName);
+
+    m_data = static_cast<char*>(data);
+    m_size = size;
+    m_writable = writable;
+}
+
+void ResultStore::flush()
+{
+    if (m_data && m_writable && msync(m_data, std::size_t(m_size), MS_SYNC) != 0)
+        throw std::runtime_error("ResultStore: cannot write the file");
+}
+
+void ResultStore::close()
+{
+    if (!m_data) return;
+    munmap(m_data, std::size_t(m_size));
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+
+#endif
+
+std::uint64_t ResultStore::findStep(double time) const
+{
+    const SimulationFileHeader& header = get_header();
+    double step = std::round((time - header.timeStart)/header.step);
+    if (!(step >= 0. && step < double(header.steps))) return npos;
+    return std::uint64_t(step);
+}
+
+double ResultStore::get_time(std::uint64_t step) const
+{
+    checkStep(step);
+    std::uint64_t chunkSteps = get_header().chunkSteps;
+    return times(step/chunkSteps)[step%chunkSteps];
+}
+
+vec3d ResultStore::get_sunVector(std::uint64_t step) const
+{
+    checkStep(step);
+    std::uint64_t chunkSteps = get_header().chunkSteps;
+    const double* s = sunVectors(step/chunkSteps) + 3*(step%chunkSteps);
+    return vec3d(s[0], s[1], s[2]);
+}
+
+void ResultStore::checkStep(std::uint64_t step) const
+{
+    if (step >= get_header().steps)
+        throw std::out_of_range("ResultStore: step out of range");
+}
+
+void ResultStore::checkWritable() const
+{
+    if (!m_writable)
+        throw std::logic_error("ResultStore: the store is read-only");
+}
+
+const char* ResultStore::chunk(std::uint64_t k) const
+{
+    const SimulationFileHeader& header = get_header();
+    if (k >= header.chunks())
+        throw std::out_of_range("ResultStore: chunk out of range");
+    return m_data + header.chunkOffset(k);
+}
+
+std::uint64_t ResultStore::columnOffset(std::uint64_t k, SimulationFileHeader::Column c) const
+{
+    const SimulationFileHeader& header = get_header();
+    if (std::uint32_t(c) >= header.columns)
+        throw std::out_of_range("ResultStore: column not in the file");
+    std::uint64_t n = header.chunkSize(k);
+    return padded(n*sizeof(double)) + padded(3*n*sizeof(double)) + c*padded(n*header.heliostats*sizeof(float));
+}
+
+double* ResultStore::times(std::uint64_t k)
+{
+    checkWritable();
+    return const_cast<double*>(static_cast<const ResultStore*>(this)->times(k));
+}
+
+const double* ResultStore::sunVectors(std::uint64_t k) const
+{
+    const char* data = chunk(k);
+    return reinterpret_cast<const double*>(data + padded(get_header().chunkSize(k)*sizeof(double)));
+}
+
+double* ResultStore::sunVectors(std::uint64_t k)
+{
+    checkWritable();
+    return const_cast<double*>(static_cast<const ResultStore*>(this)->sunVectors(k));
+}
+
+const float* ResultStore::column(std::uint64_t k, SimulationFileHeader::Column c) const
+{
+    const char* data = chunk(k);
+    return reinterpret_cast<const float*>(data + columnOffset(k, c));
+}
+
+float* ResultStore::column(std::uint64_t k, SimulationFileHeader::Column c)
+{
+    checkWritable();
+    return const_cast<float*>(static_cast<const ResultStore*>(this)->column(k, c));
+}
+
+const float* ResultStore::values(std::uint64_t step, SimulationFileHeader::Column c) const
+{
+    checkStep(step);
+    std::uint64_t chunkSteps = get_header().chunkSteps;
+    return column(step/chunkSteps, c) + (step%chunkSteps)*get_header().heliostats;
+}
+
+float* ResultStore::values(std::uint64_t step, SimulationFileHeader::Column c)
+{
+    checkWritable();
+    return const_cast<float*>(static_cast<const ResultStore*>(this)->values(step, c));
+}
+
+vec2ArrayView<const float> ResultStore::angles(std::uint64_t step) const
+{
+    return vec2ArrayView<const float>(values(step, SimulationFileHeader::primaryAngle),
+                                      values(step, SimulationFileHeader::secondaryAngle));
+}
+
+vec2fArrayView ResultStore::angles(std::uint64_t step)
+{
+    checkWritable();
+    return vec2fArrayView(values(step, SimulationFileHeader::primaryAngle),
+                          values(step, SimulationFileHeader::secondaryAngle));
+}
@@ -0,0 +1,43 @@
+#include "SimdMath.h"
+
+#include <atomic>
+
+#if defined(_MSC_VER) && HELIOSTAT_TRACKING_SIMD_X86
+#include <intrin.h>
+#endif
+
+static std::atomic<bool> s_enabledAVX2(true);
+
+static bool supportsAVX2()
+{
+#if HELIOSTAT_TRACKING_SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+    static const bool ans = __builtin_cpu_supports("avx2");
+    return ans;
+#elif HELIOSTAT_TRACKING_SIMD_X86 && defined(_MSC_VER)
+    static const bool ans = [] {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        __cpuid(info, 1);
+        bool osxsave = info[2] & (1 << 27);
+        bool avx = info[2] & (1 << 28);
+        if (!osxsave || !avx) return false;
+        if ((_xgetbv(0) & 6) != 6) return false; // XMM and YMM state enabled by the OS
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }();
+    return ans;
+#else
+    return false;
+#endif
+}
+
+bool simd::hasAVX2()
+{
+    return supportsAVX2() && s_enabledAVX2.load(std::memory_order_relaxed);
+}
+
+void simd::enableAVX2(bool enabled)
+{
+    s_enabledAVX2.store(enabled, std::memory_order_relaxed);
+}
@@ -0,0 +1,267 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "SunEphemeris.h"
+#include "SimdMath.h"
+
+namespace {
+    const char fileMagic[8] = {'H', 'T', 'S', 'U', 'N', 'E', 'P', 'H'};
+    const std::uint32_t fileVersion = 1;
+}
+
+SunEphemeris::SunEphemeris():
+    m_longitude(0.), m_latitude(0.), m_timeStart(0.), m_timeEnd(0.), m_step(60.), m_stepInv(1./60.)
+{
+
+}
+
+SunEphemeris::SunEphemeris(const SunPositionEngine& engine, double timeStart, double timeEnd, double step):
+    m_longitude(engine.get_longitude()), m_latitude(engine.get_latitude()),
+    m_timeStart(timeStart), m_timeEnd(timeEnd), m_step(step), m_stepInv(1./step)
+{
+    if (!(step > 0.) || !(timeEnd >= timeStart))
+        throw std::invalid_argument("SunEphemeris: invalid time range or step");
+
+    // one extra sample before the start and two after the end for the spline
+    std::size_t steps = std::size_t(std::ceil((timeEnd - timeStart)/step));
+    std::size_t count = steps + 3;
+    std::vector<double> times(count);
+    for (std::size_t i = 0; i < count; ++i)
+        times[i] = timeStart + (double(i) - 1.)*step;
+
+    std::vector<double> vectors(3*count);
+    engine.findSunVectors(count, times.data(), vectors.data());
+    m_data.resize(3*count);
+    for (std::size_t i = 0; i < count; ++i)
+        for (int c = 0; c < 3; ++c)
+            m_data[c*count + i] = float(vectors[3*i + c]);
+}
+
+SunEphemeris SunEphemeris::forYear(const SunPositionEngine& engine, int year, double step)
+{
+    return SunEphemeris(engine, SunPositionEngine::toUnixTime(year, 1, 1), SunPositionEngine::toUnixTime(year + 1, 1, 1), step);
+}
+
+vec3d SunEphemeris::findSunVector(double time) const
+{
+    if (!contains(time))
+        throw std::out_of_range("SunEphemeris: time outside the table");
+    return interpolate(time);
+}
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+// sum of each of the rows r0, r1, r2, r3
+HELIOSTAT_TRACKING_TARGET_AVX2
+static inline __m256d sumRows(__m256d r0, __m256d r1, __m256d r2, __m256d r3)
+{
+    __m256d a = _mm256_hadd_pd(r0, r1);
+    __m256d b = _mm256_hadd_pd(r2, r3);
+    return _mm256_add_pd(_mm256_permute2f128_pd(a, b, 0x20), _mm256_permute2f128_pd(a, b, 0x31));
+}
+
+// 4 times per iteration, the Catmull-Rom weights are transposed to one row per time
+// and applied to the 4 samples of each component, returns the number of times done
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t interpolate4(std::size_t count, const double* times, double* vectors,
+                                const float* data, std::size_t samples, double timeStart, double stepInv)
+{
+    const float* components[3] = {data, data + samples, data + 2*samples};
+    const __m256d nMax = _mm256_set1_pd(double(samples - 4));
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d one = _mm256_set1_pd(1.);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d s = _mm256_mul_pd(_mm256_sub_pd(_mm256_loadu_pd(times + i), _mm256_set1_pd(timeStart)), _mm256_set1_pd(stepInv));
+        __m256d nd = _mm256_min_pd(_mm256_floor_pd(s), nMax);
+        __m256d u = _mm256_sub_pd(s, nd);
+        alignas(16) int n[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(n), _mm256_cvttpd_epi32(nd));
+
+        __m256d u2 = _mm256_mul_pd(u, u);
+        __m256d u3 = _mm256_mul_pd(u2, u);
+        __m256d hu = _mm256_mul_pd(half, u);
+        __m256d hu3 = _mm256_mul_pd(half, u3);
+        __m256d w0 = _mm256_sub_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_setzero_pd(), hu3), u2), hu);
+        __m256d w1 = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(_mm256_set1_pd(1.5), u3), _mm256_mul_pd(_mm256_set1_pd(2.5), u2)), one);
+        __m256d w2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(-1.5), u3), _mm256_mul_pd(_mm256_set1_pd(2.), u2)), hu);
+        __m256d w3 = _mm256_sub_pd(hu3, _mm256_mul_pd(half, u2));
+
+        // rows k = (w0, w1, w2, w3) of time k
+        __m256d t0 = _mm256_unpacklo_pd(w0, w1);
+        __m256d t1 = _mm256_unpackhi_pd(w0, w1);
+        __m256d t2 = _mm256_unpacklo_pd(w2, w3);
+        __m256d t3 = _mm256_unpackhi_pd(w2, w3);
+        __m256d r[4] = {
+            _mm256_permute2f128_pd(t0, t2, 0x20),
+            _mm256_permute2f128_pd(t1, t3, 0x20),
+            _mm256_permute2f128_pd(t0, t2, 0x31),
+            _mm256_permute2f128_pd(t1, t3, 0x31)
+        };
+
+        __m256d v[3];
+        for (int c = 0; c < 3; ++c) {
+            const float* p = components[c];
+            v[c] = sumRows(
+                _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(p + n[0])), r[0]),
+                _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(p + n[1])), r[1]),
+                _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(p + n[2])), r[2]),
+                _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(p + n[3])), r[3]));
+        }
+        __m256d norm2 = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(v[0], v[0]), _mm256_mul_pd(v[1], v[1])), _mm256_mul_pd(v[2], v[2]));
+        __m256d normInv = _mm256_div_pd(one, _mm256_sqrt_pd(norm2));
+
+        alignas(32) double xyz[3][4];
+        for (int c = 0; c < 3; ++c)
+            _mm256_store_pd(xyz[c], _mm256_mul_pd(v[c], normInv));
+        for (int k = 0; k < 4; ++k) {
+            vectors[3*(i + k)] = xyz[0][k];
+            vectors[3*(i + k) + 1] = xyz[1][k];
+            vectors[3*(i + k) + 2] = xyz[2][k];
+        }
+    }
+    return i;
+}
+#endif
+
+void SunEphemeris::findSunVectors(std::size_t count, const double* times, double* vectors) const
+{
+    for (std::size_t i = 0; i < count; ++i)
+        if (!contains(times[i]))
+            throw std::out_of_range("SunEphemeris: time outside the table");
+
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (simd::hasAVX2())
+        i = interpolate4(count, times, vectors, m_data.data(), get_samples(), m_timeStart, m_stepInv);
+#endif
+    for (; i < count; ++i)
+    {
+        vec3d v = interpolate(times[i]);
+        vectors[3*i] = v.x;
+        vectors[3*i + 1] = v.y;
+        vectors[3*i + 2] = v.z;
+    }
+}
+
+vec3d SunEphemeris::interpolate(double time) const
+{
+    double s = (time - m_timeStart)*m_stepInv;
+    std::size_t n = std::size_t(s);
+    if (n + 3 >= get_samples()) n = get_samples() - 4; // time = timeEnd on a step boundary
+    double u = s - double(n);
+
+    // samples n, n + 1, n + 2, n + 3 are at the times of steps n - 1, n, n + 1, n + 2
+    double u2 = u*u;
+    double u3 = u2*u;
+    double w0 = -0.5*u3 + u2 - 0.5*u;
+    double w1 = 1.5*u3 - 2.5*u2 + 1.;
+    double w2 = -1.5*u3 + 2.*u2 + 0.5*u;
+    double w3 = 0.5*u3 - 0.5*u2;
+
+    const float* x = m_data.data() + n;
+    const float* y = x + get_samples();
+    const float* z = y + get_samples();
+    vec3d v(
+        (w0*x[0] + w1*x[1]) + (w2*x[2] + w3*x[3]),
+        (w0*y[0] + w1*y[1]) + (w2*y[2] + w3*y[3]),
+        (w0*z[0] + w1*z[1]) + (w2*z[2] + w3*z[3])
+    );
+    return v*(1./v.norm());
+}
+
+double SunEphemeris::findMaxError(const SunPositionEngine& engine, int samplesPerStep) const
+{
+    double ans = 0.;
+    std::size_t steps = get_samples() - 3;
+    for (std::size_t i = 0; i < steps; ++i)
+    {
+        for (int k = 0; k < samplesPerStep; ++k)
+        {
+            double time = m_timeStart + (i + (k + 0.5)/samplesPerStep)*m_step;
+            if (time > m_timeEnd) break;
+            vec3d a = interpolate(time);
+            vec3d b = engine.findSunVector(time);
+            double angle = std::atan2(cross(a, b).norm(), dot(a, b));
+            if (angle > ans) ans = angle;
+        }
+    }
+    return ans;
+}
+
+void SunEphemeris::save(const std::string& fileName) const
+{
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file)
+        throw std::runtime_error("SunEphemeris: cannot open " + fileName);
+
+    // the file keeps the samples interleaved (x, y, z per sample)
+    std::size_t samples = get_samples();
+    std::vector<float> data(m_data.size());
+    for (std::size_t i = 0; i < samples; ++i)
+        for (int c = 0; c < 3; ++c)
+            data[3*i + c] = m_data[c*samples + i];
+
+    std::uint64_t count = data.size();
+    file.write(fileMagic, sizeof(fileMagic));
+    file.write(reinterpret_cast<const char*>(&fileVersion), sizeof(fileVersion));
+    file.write(reinterpret_cast<const char*>(&m_longitude), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&m_latitude), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&m_timeStart), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&m_timeEnd), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&m_step), sizeof(double));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(data.data()), count*sizeof(float));
+    if (!file)
+        throw std::runtime_error("SunEphemeris: cannot write " + fileName);
+}
+
+SunEphemeris SunEphemeris::load(const std::string& fileName)
+{
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw std::runtime_error("SunEphemeris: cannot open " + fileName);
+    std::uint64_t bytes = std::uint64_t(file.tellg());
+    file.seekg(0);
+
+    char magic[sizeof(fileMagic)];
+    std::uint32_t version = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    if (!file || std::memcmp(magic, fileMagic, sizeof(magic)) != 0 || version != fileVersion)
+        throw std::runtime_error("SunEphemeris: " + fileName + " is not a sun ephemeris file");
+
+    SunEphemeris ans;
+    std::uint64_t count = 0;
+    file.read(reinterpret_cast<char*>(&ans.m_longitude), sizeof(double));
+    file.read(reinterpret_cast<char*>(&ans.m_latitude), sizeof(double));
+    file.read(reinterpret_cast<char*>(&ans.m_timeStart), sizeof(double));
+    file.read(reinterpret_cast<char*>(&ans.m_timeEnd), sizeof(double));
+    file.read(reinterpret_cast<char*>(&ans.m_step), sizeof(double));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!file || !(ans.m_step > 0.) || !std::isfinite(ans.m_timeStart) || !(ans.m_timeEnd >= ans.m_timeStart) ||
+        !std::isfinite(ans.m_timeEnd))
+        throw std::runtime_error("SunEphemeris: corrupted header in " + fileName);
+    ans.m_stepInv = 1./ans.m_step;
+
+    // the samples must cover the time range, as built by the constructor
+    double steps = std::ceil((ans.m_timeEnd - ans.m_timeStart)/ans.m_step);
+    if (count % 3 != 0 || double(count/3) != steps + 3.)
+        throw std::runtime_error("SunEphemeris: corrupted header in " + fileName);
+    if (count > (bytes - std::uint64_t(file.tellg()))/sizeof(float))
+        throw std::runtime_error("SunEphemeris: truncated data in " + fileName);
+
+    std::vector<float> data(static_cast<std::size_t>(count));
+    file.read(reinterpret_cast<char*>(data.data()), count*sizeof(float));
+    if (!file)
+        throw std::runtime_error("SunEphemeris: truncated data in " + fileName);
+
+    std::size_t samples = data.size()/3;
+    ans.m_data.resize(data.size());
+    for (std::size_t i = 0; i < samples; ++i)
+        for (int c = 0; c < 3; ++c)
+            ans.m_data[c*samples + i] = data[3*i + c];
+    return ans;
+}
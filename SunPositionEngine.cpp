@@ -0,0 +1,192 @@
+#include <cmath>
+
+#include "gcf.h"
+#include "SimdMath.h"
+#include "SunPositionEngine.h"
+
+namespace {
+    const double secondsPerDay = 86400.;
+    const double unixTimeJ2000 = 946728000.; // JD 2451545.0, noon 1 January 2000 UT
+    const double parallaxFactor = 6371.01/149597870.7; // Earth mean radius over astronomical unit
+}
+
+SunPositionEngine::SunPositionEngine(double longitude, double latitude):
+    m_longitude(longitude)
+{
+    set_latitude(latitude);
+}
+
+void SunPositionEngine::set_longitude(double longitude)
+{
+    m_longitude = longitude;
+}
+
+void SunPositionEngine::set_latitude(double latitude)
+{
+    m_latitude = latitude;
+    m_cosLatitude = cos(latitude);
+    m_sinLatitude = sin(latitude);
+}
+
+vec3d SunPositionEngine::findSunVector(double time) const
+{
+    double v[3];
+    findSunVectors(1, &time, v);
+    return vec3d(v[0], v[1], v[2]);
+}
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+// a + b*x
+HELIOSTAT_TRACKING_TARGET_AVX2
+static inline __m256d linear(double a, double b, __m256d x)
+{
+    return _mm256_add_pd(_mm256_set1_pd(a), _mm256_mul_pd(_mm256_set1_pd(b), x));
+}
+
+// The steps of findSunVectors for 4 times per iteration, returns the number of times done
+HELIOSTAT_TRACKING_TARGET_AVX2
+static std::size_t sunVectors4(std::size_t count, const double* times, double* vectors,
+                               double longitude, double cosLatitude, double sinLatitude)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d t = _mm256_loadu_pd(times + i);
+        __m256d n = _mm256_div_pd(_mm256_sub_pd(t, _mm256_set1_pd(unixTimeJ2000)), _mm256_set1_pd(secondsPerDay));
+        __m256d days = _mm256_floor_pd(_mm256_div_pd(t, _mm256_set1_pd(secondsPerDay)));
+        __m256d hours = _mm256_div_pd(_mm256_sub_pd(t, _mm256_mul_pd(days, _mm256_set1_pd(secondsPerDay))), _mm256_set1_pd(3600.));
+
+        // ecliptic coordinates
+        __m256d omega = linear(2.267127827, -0.00093003392670, n);
+        __m256d meanLongitude = linear(4.895036035, 0.01720279602, n);
+        __m256d meanAnomaly = linear(6.239468336, 0.01720200135, n);
+        __m256d sinOmega = simd::sin(omega);
+        __m256d cosOmega = simd::cos(omega);
+        __m256d sinAnomaly = simd::sin(meanAnomaly);
+        __m256d cosAnomaly = simd::cos(meanAnomaly);
+        __m256d eclipticLongitude = _mm256_add_pd(meanLongitude, _mm256_mul_pd(_mm256_set1_pd(0.03338320972), sinAnomaly));
+        eclipticLongitude = _mm256_add_pd(eclipticLongitude,
+            _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(0.0003497596876*2.), sinAnomaly), cosAnomaly));
+        eclipticLongitude = _mm256_sub_pd(eclipticLongitude, _mm256_set1_pd(0.0001544353226));
+        eclipticLongitude = _mm256_sub_pd(eclipticLongitude, _mm256_mul_pd(_mm256_set1_pd(0.00000868972936), sinOmega));
+        __m256d eclipticObliquity = _mm256_add_pd(linear(0.4090904909, -6.213605399e-9, n),
+                                                  _mm256_mul_pd(_mm256_set1_pd(0.00004418094944), cosOmega));
+
+        // celestial coordinates
+        __m256d sinLongitude = simd::sin(eclipticLongitude);
+        __m256d cosLongitude = simd::cos(eclipticLongitude);
+        __m256d sinDeclination = _mm256_mul_pd(simd::sin(eclipticObliquity), sinLongitude);
+        __m256d cosAscension = cosLongitude;
+        __m256d sinAscension = _mm256_mul_pd(simd::cos(eclipticObliquity), sinLongitude);
+
+        // local coordinates
+        __m256d siderealTime = _mm256_add_pd(linear(6.697096103, 0.06570984737, n), hours);
+        __m256d localSiderealTime = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(siderealTime, _mm256_set1_pd(15.)), _mm256_set1_pd(gcf::degree)),
+                                                  _mm256_set1_pd(longitude));
+        __m256d sinSidereal = simd::sin(localSiderealTime);
+        __m256d cosSidereal = simd::cos(localSiderealTime);
+        __m256d cosHour = _mm256_add_pd(_mm256_mul_pd(cosSidereal, cosAscension), _mm256_mul_pd(sinSidereal, sinAscension));
+        __m256d sinHour = _mm256_sub_pd(_mm256_mul_pd(sinSidereal, cosAscension), _mm256_mul_pd(cosSidereal, sinAscension));
+
+        __m256d east = _mm256_xor_pd(sinHour, _mm256_set1_pd(-0.));
+        __m256d north = _mm256_sub_pd(_mm256_mul_pd(sinDeclination, _mm256_set1_pd(cosLatitude)), _mm256_mul_pd(cosHour, _mm256_set1_pd(sinLatitude)));
+        __m256d up = _mm256_add_pd(_mm256_mul_pd(cosHour, _mm256_set1_pd(cosLatitude)), _mm256_mul_pd(sinDeclination, _mm256_set1_pd(sinLatitude)));
+
+        // parallax
+        __m256d horizontal2 = _mm256_add_pd(_mm256_mul_pd(east, east), _mm256_mul_pd(north, north));
+        __m256d p2 = _mm256_mul_pd(_mm256_set1_pd(parallaxFactor*parallaxFactor), horizontal2);
+        __m256d c = _mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(_mm256_set1_pd(0.5), p2));
+        __m256d s = _mm256_mul_pd(_mm256_set1_pd(parallaxFactor), _mm256_sub_pd(_mm256_set1_pd(1.), _mm256_div_pd(p2, _mm256_set1_pd(6.))));
+        __m256d scale = _mm256_add_pd(c, _mm256_mul_pd(up, s));
+
+        alignas(32) double x[4], y[4], z[4];
+        _mm256_store_pd(x, _mm256_mul_pd(east, scale));
+        _mm256_store_pd(y, _mm256_mul_pd(north, scale));
+        _mm256_store_pd(z, _mm256_sub_pd(_mm256_mul_pd(up, c), _mm256_mul_pd(horizontal2, s)));
+        double* v = vectors + 3*i;
+        for (int k = 0; k < 4; ++k) {
+            v[3*k] = x[k];
+            v[3*k + 1] = y[k];
+            v[3*k + 2] = z[k];
+        }
+    }
+    return i;
+}
+#endif
+
+// The right ascension, azimuth and zenith angle of the original algorithm are replaced
+// by the equivalent direction cosines, and the parallax correction of the zenith angle
+// by a rotation of the vector towards the horizon, so that the only transcendental
+// calls per time are the sines and cosines of five angles.
+void SunPositionEngine::findSunVectors(std::size_t count, const double* times, double* vectors) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    if (simd::hasAVX2())
+        i = sunVectors4(count, times, vectors, m_longitude, m_cosLatitude, m_sinLatitude);
+#endif
+    for (; i < count; ++i)
+    {
+        double t = times[i];
+        double n = (t - unixTimeJ2000)/secondsPerDay; // elapsed Julian days since J2000.0
+        double hours = (t - std::floor(t/secondsPerDay)*secondsPerDay)/3600.; // UT decimal hours
+
+        // ecliptic coordinates
+        double omega = 2.267127827 - 0.00093003392670*n;
+        double meanLongitude = 4.895036035 + 0.01720279602*n;
+        double meanAnomaly = 6.239468336 + 0.01720200135*n;
+        double sinOmega = sin(omega);
+        double cosOmega = cos(omega);
+        double sinAnomaly = sin(meanAnomaly);
+        double cosAnomaly = cos(meanAnomaly);
+        double eclipticLongitude = meanLongitude + 0.03338320972*sinAnomaly
+            + 0.0003497596876*2.*sinAnomaly*cosAnomaly - 0.0001544353226
+            - 0.00000868972936*sinOmega;
+        double eclipticObliquity = 0.4090904909 - 6.213605399e-9*n + 0.00004418094944*cosOmega;
+
+        // celestial coordinates
+        double sinLongitude = sin(eclipticLongitude);
+        double cosLongitude = cos(eclipticLongitude);
+        double sinObliquity = sin(eclipticObliquity);
+        double cosObliquity = cos(eclipticObliquity);
+        double sinDeclination = sinObliquity*sinLongitude;
+        // cos(declination) times cos and sin of the right ascension
+        double cosAscension = cosLongitude;
+        double sinAscension = cosObliquity*sinLongitude;
+
+        // local coordinates, with the hour angle = local mean sidereal time - right ascension
+        double siderealTime = 6.697096103 + 0.06570984737*n + hours;
+        double localSiderealTime = siderealTime*15.*gcf::degree + m_longitude;
+        double sinSidereal = sin(localSiderealTime);
+        double cosSidereal = cos(localSiderealTime);
+        double cosHour = cosSidereal*cosAscension + sinSidereal*sinAscension; // times cos(declination)
+        double sinHour = sinSidereal*cosAscension - cosSidereal*sinAscension; // times cos(declination)
+
+        double east = -sinHour;
+        double north = sinDeclination*m_cosLatitude - cosHour*m_sinLatitude;
+        double up = cosHour*m_cosLatitude + sinDeclination*m_sinLatitude;
+
+        // parallax: the zenith angle z grows by p = parallaxFactor*sin(z)
+        double horizontal2 = east*east + north*north;
+        double p2 = parallaxFactor*parallaxFactor*horizontal2;
+        double c = 1. - 0.5*p2;
+        double s = parallaxFactor*(1. - p2/6.); // sin(p)/sin(z)
+        double scale = c + up*s;
+
+        double* v = vectors + 3*i;
+        v[0] = east*scale;
+        v[1] = north*scale;
+        v[2] = up*c - horizontal2*s;
+    }
+}
+
+double SunPositionEngine::toUnixTime(int year, int month, int day, double hours, double minutes, double seconds)
+{
+    // days from 1 January 1970 of a Gregorian date (H. Hinnant's days_from_civil)
+    long long y = year - (month <= 2);
+    long long era = (y >= 0 ? y : y - 399)/400;
+    long long yoe = y - era*400;
+    long long doy = (153*(month + (month > 2 ? -3 : 9)) + 2)/5 + day - 1;
+    long long doe = yoe*365 + yoe/4 - yoe/100 + doy;
+    long long days = era*146097 + doe - 719468;
+    return days*secondsPerDay + hours*3600. + minutes*60. + seconds;
+}
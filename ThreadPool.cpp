@@ -0,0 +1,95 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(int threads):
+    m_stop(false), m_function(nullptr), m_count(0), m_chunk(1), m_next(0), m_busy(0), m_generation(0)
+{
+    if (threads <= 0)
+        threads = std::max(1, int(std::thread::hardware_concurrency()));
+    for (int n = 1; n < threads; ++n)
+        m_workers.emplace_back(&ThreadPool::work, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& function, std::size_t grain)
+{
+    if (count == 0) return;
+    std::size_t chunks = 4*get_threads(); // a few chunks per thread to even out the load
+    std::size_t chunk = std::max(std::max<std::size_t>(grain, 1), (count + chunks - 1)/chunks);
+    std::unique_lock<std::mutex> loop(m_loopMutex, std::try_to_lock);
+    if (!loop.owns_lock() || m_workers.empty() || chunk >= count) {
+        function(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_function = &function;
+        m_count = count;
+        m_chunk = chunk;
+        m_next = 0;
+        m_busy = int(m_workers.size()) + 1;
+        m_exception = nullptr;
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    runChunks();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] {return m_busy == 0;});
+    m_function = nullptr;
+    if (m_exception)
+        std::rethrow_exception(m_exception);
+}
+
+void ThreadPool::work()
+{
+    unsigned int generation = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] {return m_stop || m_generation != generation;});
+            if (m_stop) return;
+            generation = m_generation;
+        }
+        runChunks();
+    }
+}
+
+// takes chunks of the current loop until none is left, then signs off
+void ThreadPool::runChunks()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_next < m_count)
+    {
+        std::size_t begin = m_next;
+        std::size_t end = std::min(m_count, begin + m_chunk);
+        m_next = end;
+        const std::function<void(std::size_t, std::size_t)>& function = *m_function;
+        lock.unlock();
+        try {
+            function(begin, end);
+        } catch (...) {
+            lock.lock();
+            if (!m_exception) m_exception = std::current_exception();
+            m_next = m_count; // skip the remaining chunks
+            continue;
+        }
+        lock.lock();
+    }
+    if (--m_busy == 0)
+        m_done.notify_one();
+}
@@ -2,7 +2,8 @@
 #include "TrackerSolver2A.h"
 #include "TrackerTarget.h"
 
-TrackerArmature2A::TrackerArmature2A()
+TrackerArmature2A::TrackerArmature2A():
+    m_generation(0)
 {
     m_primaryShift = vec3d(0.f, 0.f, 0.f); // original value vec3d(0.f, 0.f, 1.f)
     m_primaryAxis = vec3d(0.f, 0.f, -1.f); // azimuth original value vec3d(0.f, 0.f, -1.f)
@@ -18,10 +19,74 @@ TrackerArmature2A::TrackerArmature2A()
     m_anglesDefault = vec2d(0., 0.);
 
     m_solver = new TrackerSolver2A(this);
-    onModified(); 
+    onModified();
 }
 
-void TrackerArmature2A::onModified()
+TrackerArmature2A::TrackerArmature2A(const vec3d& primaryShift, const vec3d& primaryAxis, const vec2d& primaryAngles,
+                                     const vec3d& secondaryShift, const vec3d& secondaryAxis, const vec2d& secondaryAngles,
+                                     const vec3d& facetShift, const vec3d& facetNormal, const vec2d& anglesDefault):
+    m_primaryShift(primaryShift),
+    m_primaryAxis(primaryAxis),
+    m_primaryAngles(primaryAngles),
+    m_secondaryShift(secondaryShift),
+    m_secondaryAxis(secondaryAxis),
+    m_secondaryAngles(secondaryAngles),
+    m_facetShift(facetShift),
+    m_facetNormal(facetNormal),
+    m_anglesDefault(anglesDefault),
+    m_generation(0)
+{
+    m_solver = new TrackerSolver2A(this);
+    onModified();
+}
+
+TrackerArmature2A::TrackerArmature2A(const Geometry& g):
+    TrackerArmature2A(g.primaryShift, g.primaryAxis, g.primaryAngles,
+                      g.secondaryShift, g.secondaryAxis, g.secondaryAngles,
+                      g.facetShift, g.facetNormal, g.anglesDefault)
+{
+
+}
+
+TrackerArmature2A::Geometry TrackerArmature2A::get_geometry() const
+{
+    Geometry g;
+    g.primaryShift = m_primaryShift;
+    g.primaryAxis = m_primaryAxis;
+    g.primaryAngles = m_primaryAngles;
+    g.secondaryShift = m_secondaryShift;
+    g.secondaryAxis = m_secondaryAxis;
+    g.secondaryAngles = m_secondaryAngles;
+    g.facetShift = m_facetShift;
+    g.facetNormal = m_facetNormal;
+    g.anglesDefault = m_anglesDefault;
+    return g;
+}
+
+void TrackerArmature2A::set_geometry(const Geometry& g)
+{
+    m_primaryShift = g.primaryShift;
+    m_primaryAxis = g.primaryAxis;
+    m_primaryAngles = g.primaryAngles;
+    m_secondaryShift = g.secondaryShift;
+    m_secondaryAxis = g.secondaryAxis;
+    m_secondaryAngles = g.secondaryAngles;
+    m_facetShift = g.facetShift;
+    m_facetNormal = g.facetNormal;
+    m_anglesDefault = g.anglesDefault;
+    setModified();
+}
+
+void TrackerArmature2A::compileModified() const
+{
+    // the first thread rebuilds, the others wait for it
+    std::lock_guard<std::mutex> lock(m_compileMutex);
+    if (!m_modified.load(std::memory_order_relaxed)) return;
+    onModified();
+    m_modified.store(false, std::memory_order_release);
+}
+
+void TrackerArmature2A::onModified() const
 {
     vec2d pa = m_primaryAngles * gcf::degree;
     m_primary = ArmatureJoint(
@@ -43,6 +108,25 @@ void TrackerArmature2A::onModified()
     );
 
     m_angles0 = m_anglesDefault * gcf::degree; // It is assumed that m_anglesDefault is given in degrees.
+
+    CompiledArmature2A& c = m_compiled;
+    c.a = m_primary.axis;
+    c.b = m_secondary.axis;
+    c.k = cross(c.a, c.b);
+    c.ab = dot(c.a, c.b);
+    double det = 1. - c.ab*c.ab;
+    c.degenerate = std::abs(det) < 1e-8;
+    c.k2Inv = c.degenerate ? 0. : 1./c.k.norm2();
+    c.detInv = c.degenerate ? 0. : 1./det;
+    c.primaryShift = m_primary.shift;
+    c.secondaryShift = m_secondary.shift;
+    c.facetShift = m_facet.shift;
+    c.facetNormal = m_facet.normal;
+    c.primaryAngles = m_primary.angles;
+    c.secondaryAngles = m_secondary.angles;
+    c.angles0 = m_angles0;
+    c.facetPoint0 = TrackerSolver2A::findFacetPoint(c, m_angles0);
+    m_compiledFloat = CompiledArmature2Af(c);
 }
 
 TrackerArmature2A::~TrackerArmature2A()
@@ -53,16 +137,54 @@ TrackerArmature2A::~TrackerArmature2A()
 
 void TrackerArmature2A::update(const Transform& toGlobal, const vec3d& vSun, TrackerTarget* target)
 {
-    std::vector<Angles> solutions;
-    Transform toLocal = toGlobal.inversed();
+    update(AffineTransform(toGlobal), vSun, target);
+}
+
+void TrackerArmature2A::update(const AffineTransform& toGlobal, const vec3d& vSun, TrackerTarget* target)
+{
+    Solutions2A solutions;
+    AffineTransform toLocal = toGlobal.inversed();
     vec3d vSunL = toLocal.transformVector(vSun);
     vec3d rAim = target->aimingPoint;
+    // the previous angles aim elsewhere after a retarget
+    if (target->aimingType != target->trackedAimingType || target->aimingPoint != target->trackedAimingPoint)
+        target->resetTracking();
+    SolverStatus2A status;
+    int iterationsCold = -1;
     if (target->aimingType == TrackerTarget::global) {
         rAim = toLocal.transformPoint(rAim);
-        solutions = m_solver->solveReflectionGlobal(vSunL, rAim);
+        if (target->warmStart && target->tracking) {
+            Angles anglesStart = target->angles*gcf::degree;
+            status = m_solver->solveReflectionGlobal(vSunL, rAim, anglesStart, solutions);
+            if (target->measureIterations) {
+                Solutions2A solutionsCold;
+                iterationsCold = m_solver->solveReflectionGlobal(vSunL, rAim, solutionsCold).iterations;
+            }
+        } else {
+            status = m_solver->solveReflectionGlobal(vSunL, rAim, solutions);
+            iterationsCold = status.iterations;
+        }
     } else if (target->aimingType == TrackerTarget::local) {
-        solutions = m_solver->solveReflectionSecondary(vSunL, rAim);
+        m_solver->solveReflectionSecondary(vSunL, rAim, solutions);
+        if (!solutions.empty()) status.convergence = SolverStatus2A::converged;
+        iterationsCold = status.iterations;
     }
     Angles solution = m_solver->selectSolution(solutions);
     target->angles = vec2d(solution.x/gcf::degree, solution.y/gcf::degree);
+    target->iterations = status.iterations;
+    target->iterationsCold = iterationsCold;
+    target->convergence = status.convergence;
+    target->tracking = !solutions.empty();
+    target->trackedAimingType = target->aimingType;
+    target->trackedAimingPoint = target->aimingPoint;
+}
+
+void TrackerArmature2A::updateBatch(std::size_t count, const vec3dArrayView& vSun, const vec3dArrayView& rAim,
+                                    TrackerTarget::AimingType aimingType, vec2dArrayView angles) const
+{
+    m_solver->solveBatch(count, vSun, rAim, aimingType, angles);
+    for (std::size_t i = 0; i < count; ++i) {
+        Angles solution = angles[i];
+        angles.set(i, vec2d(solution.x/gcf::degree, solution.y/gcf::degree));
+    }
 }
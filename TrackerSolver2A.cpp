@@ -1,102 +1,432 @@
+#include <algorithm>
+#include <type_traits>
 #include <vector>
 
 #include "TrackerSolver2A.h"
+#include "SimdMath.h"
 #include "gcf.h"
 
 // rotation around a from m to v
-inline double findAngle(const vec3d& a, const vec3d& m, const vec3d& v, double av)
+template<class T>
+inline T findAngle(const vec3<T>& a, const vec3<T>& m, const vec3<T>& v, T av)
 {
-    return atan2(dot(a, cross(m, v)), dot(m, v) - av*av);
+    return std::atan2(dot(a, cross(m, v)), dot(m, v) - av*av);
 }
 
-std::vector<Angles> TrackerSolver2A::solveReflectionGlobal(const vec3d& vSun, const vec3d& rAim) const
+// rotation of v around the unit axis a (Rodrigues' formula)
+template<class T>
+inline vec3<T> rotateAround(const vec3<T>& a, T angle, const vec3<T>& v)
 {
-    std::vector<Angles> ans;
-    int iMax = 5; // max iterations
-    double deltaMin = 0.001; // accuracy in meters
+    T c = std::cos(angle);
+    T s = std::sin(angle);
+    return v*c + cross(a, v)*s + a*(dot(a, v)*(1 - c));
+}
+
+template<class T>
+const CompiledArmature2AT<T>& TrackerSolver2AT<T>::compiled() const
+{
+    if constexpr (std::is_same_v<T, float>)
+        return m_armature->get_compiledFloat();
+    else
+        return m_armature->get_compiled();
+}
+
+template<class T>
+std::vector<typename TrackerSolver2AT<T>::Angles> TrackerSolver2AT<T>::solveReflectionGlobal(const Vector& vSun, const Vector& rAim) const
+{
+    Solutions ans;
+    solveReflectionGlobal(vSun, rAim, ans);
+    return ans.toVector();
+}
+
+template<class T>
+SolverStatus2A TrackerSolver2AT<T>::solveReflectionGlobal(const Vector& vSun, const Vector& rAim, Solutions& ans) const
+{
+    return solveReflectionGlobalFrom(vSun, rAim, compiled().facetPoint0, ans);
+}
+
+template<class T>
+SolverStatus2A TrackerSolver2AT<T>::solveReflectionGlobal(const Vector& vSun, const Vector& rAim, const Angles& anglesStart, Solutions& ans) const
+{
+    return solveReflectionGlobalFrom(vSun, rAim, findFacetPoint(anglesStart), ans);
+}
+
+template<class T>
+SolverStatus2A TrackerSolver2AT<T>::solveReflectionGlobalFrom(const Vector& vSun, const Vector& rAim, const Vector& rFacetStart, Solutions& ans) const
+{
+    ans.clear();
+    SolverStatus2A status;
+    bool failed = false;
 
     for (int s = 0; s < 2; ++s) // solutions
     {
-        vec3d rFacet = findFacetPoint(m_armature->get_angles0());
-        for (int i = 0; i < iMax; ++i)
-        {
-            vec3d vTarget = (rAim - rFacet).normalized();
-            vec3d normal = (vSun + vTarget).normalized();
-            std::vector<Angles> temp = solveFacetNormal(normal);
-            if (temp.empty()) break;
-            Angles& angles = temp[s];
-            rFacet = findFacetPoint(angles);
-            double delta = cross(rAim - rFacet, vTarget).norm();
-            if (delta > deltaMin) continue;
+        Angles angles;
+        SolverStatus2A::Convergence convergence = m_method == newton ?
+            solveNewton(vSun, rAim, rFacetStart, s, angles, status.iterations) :
+            solveFixedPoint(vSun, rAim, rFacetStart, s, angles, status.iterations);
+        if (convergence == SolverStatus2A::converged)
             ans.push_back(angles);
-            break;
-        }
+        else if (convergence == SolverStatus2A::notConverged)
+            failed = true;
+    }
+
+    if (failed)
+        status.convergence = SolverStatus2A::notConverged;
+    else if (!ans.empty())
+        status.convergence = SolverStatus2A::converged;
+    return status;
+}
+
+// fixed-point iteration on the facet point for the solution branch s
+template<class T>
+SolverStatus2A::Convergence TrackerSolver2AT<T>::solveFixedPoint(const Vector& vSun, const Vector& rAim, Vector rFacet, int s, Angles& angles, int& iterations) const
+{
+    Solutions temp;
+    for (int i = 0; i < m_iterationsMax; ++i)
+    {
+        ++iterations;
+        Vector vTarget = (rAim - rFacet).normalized();
+        Vector normal = (vSun + vTarget).normalized();
+        solveFacetNormal(normal, temp);
+        if (temp.empty()) return SolverStatus2A::noSolution;
+        angles = temp[s];
+        rFacet = findFacetPoint(angles);
+        T delta = cross(rAim - rFacet, vTarget).norm();
+        if (delta <= m_tolerance) return SolverStatus2A::converged;
+    }
+    return SolverStatus2A::notConverged;
+}
+
+// Gauss-Newton on the angles for the solution branch s, started from one fixed-point step.
+// The residual is the reflected sun direction minus the direction from the facet to the aiming point.
+// With r = sa + Ra(sb + Rb f) and n = Ra Rb n0, the derivatives are
+// dr/da = a x (r - sa), dr/db = Ra b x Ra Rb f, dn/da = a x n, dn/db = Ra b x n.
+template<class T>
+SolverStatus2A::Convergence TrackerSolver2AT<T>::solveNewton(const Vector& vSun, const Vector& rAim, const Vector& rFacet, int s, Angles& angles, int& iterations) const
+{
+    const CompiledArmature2AT<T>& c = compiled();
+
+    ++iterations;
+    Solutions temp;
+    Vector vTarget = (rAim - rFacet).normalized();
+    solveFacetNormal((vSun + vTarget).normalized(), temp);
+    if (temp.empty()) return SolverStatus2A::noSolution;
+    angles = temp[s];
+
+    for (int i = 1; ; ++i)
+    {
+        Vector f = rotateAround(c.b, angles.y, c.facetShift);
+        Vector p = rotateAround(c.a, angles.x, c.secondaryShift + f);
+        Vector n = rotateAround(c.a, angles.x, rotateAround(c.b, angles.y, c.facetNormal));
+        Vector bRotated = rotateAround(c.a, angles.x, c.b);
+
+        Vector rt = rAim - c.primaryShift - p;
+        T length = rt.norm();
+        Vector t = rt/length;
+        T ns = dot(n, vSun);
+        Vector d = T(2)*ns*n - vSun;
+        if (cross(rt, d).norm() <= m_tolerance) return SolverStatus2A::converged;
+        if (i >= m_iterationsMax) break;
+        ++iterations;
+
+        Vector drA = cross(c.a, p);
+        Vector drB = cross(bRotated, rotateAround(c.a, angles.x, f));
+        Vector dnA = cross(c.a, n);
+        Vector dnB = cross(bRotated, n);
+        Vector jA = T(2)*(dot(dnA, vSun)*n + ns*dnA) + (drA - t*dot(t, drA))/length;
+        Vector jB = T(2)*(dot(dnB, vSun)*n + ns*dnB) + (drB - t*dot(t, drB))/length;
+
+        Vector F = d - t;
+        T jAA = dot(jA, jA);
+        T jAB = dot(jA, jB);
+        T jBB = dot(jB, jB);
+        T det = jAA*jBB - jAB*jAB;
+        if (det <= T(1e-12)*jAA*jBB) break;
+
+        T gA = dot(jA, F);
+        T gB = dot(jB, F);
+        angles.x -= (jBB*gA - jAB*gB)/det;
+        angles.y -= (jAA*gB - jAB*gA)/det;
     }
+    return SolverStatus2A::notConverged;
+}
 
-    return ans;
+template<class T>
+vec3<T> TrackerSolver2AT<T>::findFacetPoint(const Angles& angles) const
+{
+    return findFacetPoint(compiled(), angles);
 }
 
-vec3d TrackerSolver2A::findFacetPoint(const Angles& angles) const
+template<class T>
+vec3<T> TrackerSolver2AT<T>::findFacetPoint(const CompiledArmature2AT<T>& c, const Angles& angles)
 {
-    vec3d r = m_armature->get_secondary().getTransform(angles.y).transformPoint(m_armature->get_facet().shift);
-    return m_armature->get_primary().getTransform(angles.x).transformPoint(r);
+    Vector r = c.secondaryShift + rotateAround(c.b, angles.y, c.facetShift);
+    return c.primaryShift + rotateAround(c.a, angles.x, r);
 }
 
 // rotate facet.normal to normal
-std::vector<Angles> TrackerSolver2A::solveFacetNormal(const vec3d& normal) const
+template<class T>
+std::vector<typename TrackerSolver2AT<T>::Angles> TrackerSolver2AT<T>::solveFacetNormal(const Vector& normal) const
+{
+    return solveRotation(compiled().facetNormal, normal);
+}
+
+template<class T>
+void TrackerSolver2AT<T>::solveFacetNormal(const Vector& normal, Solutions& ans) const
 {
-    return solveRotation(m_armature->get_facet().normal, normal);
+    solveRotation(compiled().facetNormal, normal, ans);
 }
 
 // rotate v0 to v
-std::vector<Angles> TrackerSolver2A::solveRotation(const vec3d& v0, const vec3d& v) const
-{
-    const vec3d& a = m_armature->get_primary().axis;
-    const vec3d& b = m_armature->get_secondary().axis;
-
-    vec3d k = cross(a, b);
-    double k2 = k.norm2();
-    double ab = dot(a, b);
-    double det = 1. - ab*ab;
-    if (std::abs(det) < 1e-8) return {};
-
-    double av = dot(a, v);
-    double bv0 = dot(b, v0);
-    double ma = (av - ab*bv0)/det;
-    double mb = (bv0 - ab*av)/det;
-    double mk = 1. - ma*ma - mb*mb - 2.*ma*mb*ab;
-    if (mk < 0.) return {};
-
-    mk = sqrt(mk/k2);
-    vec3d m0 = ma*a + mb*b;
-    std::vector<Angles> ans;
-    vec3d m = m0 - mk*k;
+template<class T>
+std::vector<typename TrackerSolver2AT<T>::Angles> TrackerSolver2AT<T>::solveRotation(const Vector& v0, const Vector& v) const
+{
+    Solutions ans;
+    solveRotation(v0, v, ans);
+    return ans.toVector();
+}
+
+template<class T>
+void TrackerSolver2AT<T>::solveRotation(const Vector& v0, const Vector& v, Solutions& ans) const
+{
+    ans.clear();
+    const CompiledArmature2AT<T>& c = compiled();
+    if (c.degenerate) return;
+    const Vector& a = c.a;
+    const Vector& b = c.b;
+    const Vector& k = c.k;
+    T ab = c.ab;
+
+    T av = dot(a, v);
+    T bv0 = dot(b, v0);
+    T ma = (av - ab*bv0)*c.detInv;
+    T mb = (bv0 - ab*av)*c.detInv;
+    T mk = 1 - ma*ma - mb*mb - 2*ma*mb*ab;
+    if (mk < 0) return;
+
+    mk = std::sqrt(mk*c.k2Inv);
+    Vector m0 = ma*a + mb*b;
+    Vector m = m0 - mk*k;
     ans.push_back(Angles(findAngle(a, m, v, av), findAngle(b, v0, m, bv0)));
     m = m0 + mk*k;
     ans.push_back(Angles(findAngle(a, m, v, av), findAngle(b, v0, m, bv0)));
-    return ans;
 }
 
-std::vector<Angles> TrackerSolver2A::solveReflectionSecondary(const vec3d& vSun, const vec3d& rAim) const
+#if HELIOSTAT_TRACKING_SIMD_X86
+
+HELIOSTAT_TRACKING_TARGET_AVX2
+static inline __m256d dot(__m256d x1, __m256d y1, __m256d z1, __m256d x2, __m256d y2, __m256d z2)
+{
+    return _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(x1, x2), _mm256_mul_pd(y1, y2)), _mm256_mul_pd(z1, z2));
+}
+
+// solveRotation for four problems at once, lanes of v0 and v are given per coordinate
+HELIOSTAT_TRACKING_TARGET_AVX2
+static void solveRotation4(const CompiledArmature2A& c, const double* v0, const double* v, Solutions2A* ans)
+{
+    const __m256d zero = _mm256_setzero_pd();
+    __m256d ax = _mm256_set1_pd(c.a.x), ay = _mm256_set1_pd(c.a.y), az = _mm256_set1_pd(c.a.z);
+    __m256d bx = _mm256_set1_pd(c.b.x), by = _mm256_set1_pd(c.b.y), bz = _mm256_set1_pd(c.b.z);
+    __m256d ab = _mm256_set1_pd(c.ab);
+    __m256d detInv = _mm256_set1_pd(c.detInv);
+
+    __m256d v0x = _mm256_loadu_pd(v0), v0y = _mm256_loadu_pd(v0 + 4), v0z = _mm256_loadu_pd(v0 + 8);
+    __m256d vx = _mm256_loadu_pd(v), vy = _mm256_loadu_pd(v + 4), vz = _mm256_loadu_pd(v + 8);
+
+    __m256d av = dot(ax, ay, az, vx, vy, vz);
+    __m256d bv0 = dot(bx, by, bz, v0x, v0y, v0z);
+    __m256d ma = _mm256_mul_pd(_mm256_sub_pd(av, _mm256_mul_pd(ab, bv0)), detInv);
+    __m256d mb = _mm256_mul_pd(_mm256_sub_pd(bv0, _mm256_mul_pd(ab, av)), detInv);
+    __m256d mk = _mm256_sub_pd(_mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(ma, ma)), _mm256_mul_pd(mb, mb));
+    mk = _mm256_sub_pd(mk, _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.), ma), mb), ab));
+    int valid = _mm256_movemask_pd(_mm256_cmp_pd(mk, zero, _CMP_GE_OQ));
+    mk = _mm256_sqrt_pd(_mm256_mul_pd(_mm256_max_pd(mk, zero), _mm256_set1_pd(c.k2Inv)));
+
+    __m256d m0x = _mm256_add_pd(_mm256_mul_pd(ma, ax), _mm256_mul_pd(mb, bx));
+    __m256d m0y = _mm256_add_pd(_mm256_mul_pd(ma, ay), _mm256_mul_pd(mb, by));
+    __m256d m0z = _mm256_add_pd(_mm256_mul_pd(ma, az), _mm256_mul_pd(mb, bz));
+    __m256d kx = _mm256_mul_pd(mk, _mm256_set1_pd(c.k.x));
+    __m256d ky = _mm256_mul_pd(mk, _mm256_set1_pd(c.k.y));
+    __m256d kz = _mm256_mul_pd(mk, _mm256_set1_pd(c.k.z));
+    __m256d avv = _mm256_mul_pd(av, av);
+    __m256d bvv = _mm256_mul_pd(bv0, bv0);
+
+    alignas(32) double angles[2][2][4];
+    for (int s = 0; s < 2; ++s)
+    {
+        __m256d mx = s == 0 ? _mm256_sub_pd(m0x, kx) : _mm256_add_pd(m0x, kx);
+        __m256d my = s == 0 ? _mm256_sub_pd(m0y, ky) : _mm256_add_pd(m0y, ky);
+        __m256d mz = s == 0 ? _mm256_sub_pd(m0z, kz) : _mm256_add_pd(m0z, kz);
+
+        // findAngle(a, m, v, av)
+        __m256d cx = _mm256_sub_pd(_mm256_mul_pd(my, vz), _mm256_mul_pd(mz, vy));
+        __m256d cy = _mm256_sub_pd(_mm256_mul_pd(mz, vx), _mm256_mul_pd(mx, vz));
+        __m256d cz = _mm256_sub_pd(_mm256_mul_pd(mx, vy), _mm256_mul_pd(my, vx));
+        __m256d alpha = simd::atan2(dot(ax, ay, az, cx, cy, cz), _mm256_sub_pd(dot(mx, my, mz, vx, vy, vz), avv));
+
+        // findAngle(b, v0, m, bv0)
+        cx = _mm256_sub_pd(_mm256_mul_pd(v0y, mz), _mm256_mul_pd(v0z, my));
+        cy = _mm256_sub_pd(_mm256_mul_pd(v0z, mx), _mm256_mul_pd(v0x, mz));
+        cz = _mm256_sub_pd(_mm256_mul_pd(v0x, my), _mm256_mul_pd(v0y, mx));
+        __m256d beta = simd::atan2(dot(bx, by, bz, cx, cy, cz), _mm256_sub_pd(dot(v0x, v0y, v0z, mx, my, mz), bvv));
+
+        _mm256_store_pd(angles[s][0], alpha);
+        _mm256_store_pd(angles[s][1], beta);
+    }
+
+    for (int n = 0; n < 4; ++n)
+    {
+        ans[n].clear();
+        if (!(valid & (1 << n))) continue;
+        ans[n].push_back(Angles(angles[0][0][n], angles[0][1][n]));
+        ans[n].push_back(Angles(angles[1][0][n], angles[1][1][n]));
+    }
+}
+
+HELIOSTAT_TRACKING_TARGET_AVX2
+static inline __m256 dot(__m256 x1, __m256 y1, __m256 z1, __m256 x2, __m256 y2, __m256 z2)
+{
+    return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x1, x2), _mm256_mul_ps(y1, y2)), _mm256_mul_ps(z1, z2));
+}
+
+// single precision version of solveRotation4 for eight problems at once
+HELIOSTAT_TRACKING_TARGET_AVX2
+static void solveRotation8(const CompiledArmature2Af& c, const float* v0, const float* v, Solutions2Af* ans)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 ax = _mm256_set1_ps(c.a.x), ay = _mm256_set1_ps(c.a.y), az = _mm256_set1_ps(c.a.z);
+    __m256 bx = _mm256_set1_ps(c.b.x), by = _mm256_set1_ps(c.b.y), bz = _mm256_set1_ps(c.b.z);
+    __m256 ab = _mm256_set1_ps(c.ab);
+    __m256 detInv = _mm256_set1_ps(c.detInv);
+
+    __m256 v0x = _mm256_loadu_ps(v0), v0y = _mm256_loadu_ps(v0 + 8), v0z = _mm256_loadu_ps(v0 + 16);
+    __m256 vx = _mm256_loadu_ps(v), vy = _mm256_loadu_ps(v + 8), vz = _mm256_loadu_ps(v + 16);
+
+    __m256 av = dot(ax, ay, az, vx, vy, vz);
+    __m256 bv0 = dot(bx, by, bz, v0x, v0y, v0z);
+    __m256 ma = _mm256_mul_ps(_mm256_sub_ps(av, _mm256_mul_ps(ab, bv0)), detInv);
+    __m256 mb = _mm256_mul_ps(_mm256_sub_ps(bv0, _mm256_mul_ps(ab, av)), detInv);
+    __m256 mk = _mm256_sub_ps(_mm256_sub_ps(_mm256_set1_ps(1.f), _mm256_mul_ps(ma, ma)), _mm256_mul_ps(mb, mb));
+    mk = _mm256_sub_ps(mk, _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(2.f), ma), mb), ab));
+    int valid = _mm256_movemask_ps(_mm256_cmp_ps(mk, zero, _CMP_GE_OQ));
+    mk = _mm256_sqrt_ps(_mm256_mul_ps(_mm256_max_ps(mk, zero), _mm256_set1_ps(c.k2Inv)));
+
+    __m256 m0x = _mm256_add_ps(_mm256_mul_ps(ma, ax), _mm256_mul_ps(mb, bx));
+    __m256 m0y = _mm256_add_ps(_mm256_mul_ps(ma, ay), _mm256_mul_ps(mb, by));
+    __m256 m0z = _mm256_add_ps(_mm256_mul_ps(ma, az), _mm256_mul_ps(mb, bz));
+    __m256 kx = _mm256_mul_ps(mk, _mm256_set1_ps(c.k.x));
+    __m256 ky = _mm256_mul_ps(mk, _mm256_set1_ps(c.k.y));
+    __m256 kz = _mm256_mul_ps(mk, _mm256_set1_ps(c.k.z));
+    __m256 avv = _mm256_mul_ps(av, av);
+    __m256 bvv = _mm256_mul_ps(bv0, bv0);
+
+    alignas(32) float angles[2][2][8];
+    for (int s = 0; s < 2; ++s)
+    {
+        __m256 mx = s == 0 ? _mm256_sub_ps(m0x, kx) : _mm256_add_ps(m0x, kx);
+        __m256 my = s == 0 ? _mm256_sub_ps(m0y, ky) : _mm256_add_ps(m0y, ky);
+        __m256 mz = s == 0 ? _mm256_sub_ps(m0z, kz) : _mm256_add_ps(m0z, kz);
+
+        __m256 cx = _mm256_sub_ps(_mm256_mul_ps(my, vz), _mm256_mul_ps(mz, vy));
+        __m256 cy = _mm256_sub_ps(_mm256_mul_ps(mz, vx), _mm256_mul_ps(mx, vz));
+        __m256 cz = _mm256_sub_ps(_mm256_mul_ps(mx, vy), _mm256_mul_ps(my, vx));
+        __m256 alpha = simd::atan2(dot(ax, ay, az, cx, cy, cz), _mm256_sub_ps(dot(mx, my, mz, vx, vy, vz), avv));
+
+        cx = _mm256_sub_ps(_mm256_mul_ps(v0y, mz), _mm256_mul_ps(v0z, my));
+        cy = _mm256_sub_ps(_mm256_mul_ps(v0z, mx), _mm256_mul_ps(v0x, mz));
+        cz = _mm256_sub_ps(_mm256_mul_ps(v0x, my), _mm256_mul_ps(v0y, mx));
+        __m256 beta = simd::atan2(dot(bx, by, bz, cx, cy, cz), _mm256_sub_ps(dot(v0x, v0y, v0z, mx, my, mz), bvv));
+
+        _mm256_store_ps(angles[s][0], alpha);
+        _mm256_store_ps(angles[s][1], beta);
+    }
+
+    for (int n = 0; n < 8; ++n)
+    {
+        ans[n].clear();
+        if (!(valid & (1 << n))) continue;
+        ans[n].push_back(vec2f(angles[0][0][n], angles[0][1][n]));
+        ans[n].push_back(vec2f(angles[1][0][n], angles[1][1][n]));
+    }
+}
+
+#endif
+
+template<class T>
+void TrackerSolver2AT<T>::solveRotationBatch(std::size_t count, const vec3ArrayView<T>& v0, const vec3ArrayView<T>& v, Solutions* ans) const
+{
+    std::size_t i = 0;
+#if HELIOSTAT_TRACKING_SIMD_X86
+    const CompiledArmature2AT<T>& c = compiled();
+    if (!c.degenerate && simd::hasAVX2())
+    {
+        const int w = 32/sizeof(T); // lanes of an AVX register
+        T lanes0[3*w];
+        T lanes[3*w];
+        for (; i + w <= count; i += w)
+        {
+            for (int n = 0; n < w; ++n)
+            {
+                Vector p0 = v0[i + n];
+                Vector p = v[i + n];
+                lanes0[n] = p0.x; lanes0[w + n] = p0.y; lanes0[2*w + n] = p0.z;
+                lanes[n] = p.x; lanes[w + n] = p.y; lanes[2*w + n] = p.z;
+            }
+            if constexpr (std::is_same_v<T, float>)
+                solveRotation8(c, lanes0, lanes, ans + i);
+            else
+                solveRotation4(c, lanes0, lanes, ans + i);
+        }
+    }
+#endif
+    for (; i < count; ++i)
+        solveRotation(v0[i], v[i], ans[i]);
+}
+
+template<class T>
+std::vector<typename TrackerSolver2AT<T>::Angles> TrackerSolver2AT<T>::solveReflectionSecondary(const Vector& vSun, const Vector& rAim) const
+{
+    Solutions ans;
+    solveReflectionSecondary(vSun, rAim, ans);
+    return ans.toVector();
+}
+
+template<class T>
+void TrackerSolver2AT<T>::solveReflectionSecondary(const Vector& vSun, const Vector& rAim, Solutions& ans) const
+{
+    const CompiledArmature2AT<T>& c = compiled();
+    Vector vTarget0 = (rAim - c.facetShift).normalized();
+    Vector vSun0 = -vTarget0.reflected(c.facetNormal);
+    solveRotation(vSun0, vSun, ans);
+}
+
+template<class T>
+typename TrackerSolver2AT<T>::Angles TrackerSolver2AT<T>::selectSolution(const std::vector<Angles>& solutions) const
+{
+    return selectSolution(solutions.data(), solutions.data() + solutions.size());
+}
+
+template<class T>
+typename TrackerSolver2AT<T>::Angles TrackerSolver2AT<T>::selectSolution(const Solutions& solutions) const
 {
-    vec3d vTarget0 = (rAim - m_armature->get_facet().shift).normalized();
-    vec3d vSun0 = -vTarget0.reflected(m_armature->get_facet().normal);
-    return solveRotation(vSun0, vSun);
+    return selectSolution(solutions.begin(), solutions.end());
 }
 
-Angles TrackerSolver2A::selectSolution(const std::vector<Angles>& solutions) const
+template<class T>
+typename TrackerSolver2AT<T>::Angles TrackerSolver2AT<T>::selectSolution(const Angles* begin, const Angles* end) const
 {
+    const CompiledArmature2AT<T>& c = compiled();
     Angles ans;
-    double zAns = gcf::infinity;
+    T zAns = gcf::infinity;
 
-    for (const Angles& solution : solutions)
+    for (const Angles* solution = begin; solution != end; ++solution)
     {
         Angles temp;
-        temp.x = m_armature->get_primary().angles.normalizeAngle(solution.x);
-        if (!m_armature->get_primary().angles.isInside(temp.x)) continue;
-        temp.y = m_armature->get_secondary().angles.normalizeAngle(solution.y);
-        if (!m_armature->get_secondary().angles.isInside(temp.y)) continue;
-        double z = (temp - m_armature->get_angles0()).norm2();
+        temp.x = c.primaryAngles.normalizeAngle(solution->x);
+        if (!c.primaryAngles.isInside(temp.x)) continue;
+        temp.y = c.secondaryAngles.normalizeAngle(solution->y);
+        if (!c.secondaryAngles.isInside(temp.y)) continue;
+        T z = (temp - c.angles0).norm2();
         if (z > zAns) continue;
         ans = temp;
         zAns = z;
@@ -104,5 +434,43 @@ Angles TrackerSolver2A::selectSolution(const std::vector<Angles>& solutions) con
 
     if (zAns < gcf::infinity)
         return ans;
-    return m_armature->get_angles0();
+    return c.angles0;
+}
+
+template<class T>
+void TrackerSolver2AT<T>::solveBatch(std::size_t count, const vec3ArrayView<T>& vSun, const vec3ArrayView<T>& rAim,
+                                  TrackerTarget::AimingType aimingType, vec2ArrayView<T> angles) const
+{
+    if (aimingType == TrackerTarget::global)
+    {
+        Solutions solutions;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            solveReflectionGlobal(vSun[i], rAim[i], solutions);
+            angles.set(i, selectSolution(solutions));
+        }
+        return;
+    }
+
+    // local aiming is a single rotation per heliostat, solved in chunks with solveRotationBatch
+    const CompiledArmature2AT<T>& c = compiled();
+    const std::size_t chunk = 64;
+    T vSun0[3][chunk];
+    Solutions solutions[chunk];
+    for (std::size_t i = 0; i < count; i += chunk)
+    {
+        std::size_t n = std::min(chunk, count - i);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            Vector vTarget0 = (rAim[i + j] - c.facetShift).normalized();
+            Vector v = -vTarget0.reflected(c.facetNormal);
+            vSun0[0][j] = v.x; vSun0[1][j] = v.y; vSun0[2][j] = v.z;
+        }
+        solveRotationBatch(n, vec3ArrayView<T>(vSun0[0], vSun0[1], vSun0[2]), vSun.from(i), solutions);
+        for (std::size_t j = 0; j < n; ++j)
+            angles.set(i + j, selectSolution(solutions[j]));
+    }
 }
+
+template class TrackerSolver2AT<double>;
+template class TrackerSolver2AT<float>;
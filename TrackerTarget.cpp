@@ -5,6 +5,15 @@ TrackerTarget::TrackerTarget()
     aimingType = global;
     aimingPoint = vec3d(0.f, 0.f, 100.f); // original value vec3d(0.f, 0.f, 100.f)
     angles = vec2d(0.f, 0.f);
+
+    warmStart = false;
+    tracking = false;
+    trackedAimingType = aimingType;
+    trackedAimingPoint = aimingPoint;
+    measureIterations = false;
+    iterations = 0;
+    iterationsCold = 0;
+    convergence = SolverStatus2A::noSolution;
 }
 
 TrackerTarget::~TrackerTarget()
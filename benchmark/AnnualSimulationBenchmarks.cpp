@@ -0,0 +1,37 @@
+#include <cstdio>
+
+#include <benchmark/benchmark.h>
+
+#include "AnnualSimulation.h"
+#include "HeliostatField.h"
+#include "SunPositionEngine.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+// one day at 5 minute steps for the whole field, items are heliostat steps
+static void BM_AnnualSimulation_day(benchmark::State& state)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+    ElevationAngleKM elevation = bluesolarElevationAngleKM();
+    HourAngleKM hour = bluesolarHourAngleKM();
+
+    HeliostatField field(int(state.range(0)));
+    TrackerTarget target;
+    target.aimingPoint = dataset.aimingPoint;
+    target.warmStart = true;
+    for (const Transform& location : dataset.locations)
+        field.addHeliostat(location, &armature, target);
+
+    AnnualSimulation simulation(&field, SunPositionEngine(-2.46*gcf::degree, 37.09*gcf::degree));
+    double timeStart = SunPositionEngine::toUnixTime(2024, 6, 21);
+    simulation.set_timeRange(timeStart, timeStart + 86400., 300.);
+    simulation.set_actuatorModels(&elevation, &hour);
+    const char* fileName = "annual_simulation_benchmark.bin";
+    for (auto _ : state)
+        simulation.run(fileName);
+    std::remove(fileName);
+    state.SetItemsProcessed(state.iterations()*simulation.get_steps()*field.size());
+}
+BENCHMARK(BM_AnnualSimulation_day)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
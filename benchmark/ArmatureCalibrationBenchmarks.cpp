@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "gcf.h"
+#include "ArmatureCalibration.h"
+#include "TrackerArmature2A.h"
+#include "TrackerSolver2A.h"
+#include "FieldDataset.h"
+
+// Nightly calibration of a field: for each heliostat, 40 beam observations of an armature
+// with millimetre shift errors and milliradian axis errors, measured with 3 mm noise,
+// fitted from the nominal Bluesolar armature and actuator models.
+
+namespace {
+
+struct CalibrationDataset
+{
+    CalibrationDataset(std::size_t heliostats, std::size_t observations);
+
+    TrackerArmature2A nominal;
+    ElevationAngleKM elevation = bluesolarElevationAngleKM();
+    HourAngleKM hour = bluesolarHourAngleKM();
+    std::vector<std::vector<CalibrationObservation>> observations;
+    std::vector<CalibrationProblem> problems;
+};
+
+vec3d rotate(const vec3d& a, double angle, const vec3d& v)
+{
+    return v*std::cos(angle) + cross(a, v)*std::sin(angle) + a*(dot(a, v)*(1. - std::cos(angle)));
+}
+
+CalibrationDataset::CalibrationDataset(std::size_t heliostats, std::size_t count)
+{
+    nominal.set_geometry(bluesolarGeometry());
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> unit(0., 1.);
+    std::normal_distribution<double> error(0., 1.);
+    observations.resize(heliostats);
+    for (std::size_t i = 0; i < heliostats; ++i) {
+        TrackerArmature2A::Geometry g = nominal.get_geometry();
+        g.primaryShift += vec3d(error(random), error(random), error(random))*0.01;
+        g.primaryAxis += vec3d(0., error(random), error(random))*0.005;
+        g.secondaryShift += vec3d(0., error(random), error(random))*0.005;
+        g.secondaryAxis += vec3d(error(random), error(random), 0.)*0.005;
+        TrackerArmature2A actual(g);
+        const CompiledArmature2A& c = actual.get_compiled();
+
+        for (std::size_t k = 0; k < count; ++k) {
+            CalibrationObservation o;
+            o.vSun = vec3d::directionAE((60. + 240.*unit(random))*gcf::degree, (10. + 70.*unit(random))*gcf::degree);
+            vec2d angles((5. + 80.*unit(random))*gcf::degree, (-45. + 90.*unit(random))*gcf::degree);
+            o.input = vec2d(elevation.getActuatorLengthFromElevationAngle(angles.x),
+                            hour.getActuatorLengthFromHourAngle(angles.y));
+            vec3d p = TrackerSolver2A::findFacetPoint(c, angles);
+            vec3d n = rotate(c.a, angles.x, rotate(c.b, angles.y, c.facetNormal));
+            o.beam = p + (2.*dot(n, o.vSun)*n - o.vSun)*50. + vec3d(error(random), error(random), error(random))*0.003;
+            observations[i].push_back(o);
+        }
+    }
+    for (const std::vector<CalibrationObservation>& o : observations)
+        problems.push_back(CalibrationProblem{&nominal, &elevation, &hour, o.data(), o.size()});
+}
+
+}
+
+static void BM_ArmatureCalibration_field(benchmark::State& state)
+{
+    static const CalibrationDataset dataset(FieldDataset::heliostatsDefault, 40);
+    ArmatureCalibration calibration(int(state.range(0)));
+    for (auto _ : state) {
+        std::vector<CalibrationResult> results = calibration.calibrate(dataset.problems);
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.SetItemsProcessed(state.iterations()*dataset.problems.size());
+}
+BENCHMARK(BM_ArmatureCalibration_field)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include "FacetBVH.h"
+#include "FluxTracer.h"
+#include "HeliostatField.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+namespace {
+
+struct BVHField
+{
+    TrackerArmature2A armature;
+    HeliostatField field;
+
+    BVHField()
+    {
+        const FieldDataset& dataset = FieldDataset::instance();
+        armature.set_geometry(bluesolarGeometry());
+        TrackerTarget target;
+        target.aimingPoint = dataset.aimingPoint;
+        for (const Transform& location : dataset.locations)
+            field.addHeliostat(location, &armature, target);
+        field.update(dataset.sunVectors[0]);
+    }
+};
+
+}
+
+static void BM_FacetBVH_build(benchmark::State& state)
+{
+    BVHField f;
+    FacetBVH bvh;
+    for (auto _ : state) {
+        bvh.build(f.field, vec2d(1.2, 1.2));
+        benchmark::DoNotOptimize(bvh.nodes());
+    }
+    state.SetItemsProcessed(state.iterations()*f.field.size());
+}
+BENCHMARK(BM_FacetBVH_build);
+
+// refit after every tick, the field is updated outside of the timing
+static void BM_FacetBVH_refit(benchmark::State& state)
+{
+    BVHField f;
+    const FieldDataset& dataset = FieldDataset::instance();
+    FacetBVH bvh;
+    bvh.build(f.field, vec2d(1.2, 1.2));
+    std::size_t s = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        f.field.update(dataset.sunVectors[s]);
+        s = (s + 1) % dataset.sunVectors.size();
+        state.ResumeTiming();
+        bvh.refit(f.field);
+    }
+    state.SetItemsProcessed(state.iterations()*f.field.size());
+}
+BENCHMARK(BM_FacetBVH_refit);
+
+// shading queries toward the sun from every facet center
+static void BM_FacetBVH_occluded(benchmark::State& state)
+{
+    BVHField f;
+    const vec3d& vSun = FieldDataset::instance().sunVectors[0];
+    FacetBVH bvh;
+    bvh.build(f.field, vec2d(1.2, 1.2));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(bvh.occluded(Ray(bvh.get_facet(i).center, vSun), i));
+        if (++i == bvh.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FacetBVH_occluded);
+
+// the same queries four at a time, neighbouring facets share a packet
+static void BM_FacetBVH_occludedPacket(benchmark::State& state)
+{
+    BVHField f;
+    const vec3d& vSun = FieldDataset::instance().sunVectors[0];
+    FacetBVH bvh;
+    bvh.build(f.field, vec2d(1.2, 1.2));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        RayPacket packet;
+        std::size_t ignore[RayPacket::Width];
+        for (int lane = 0; lane < RayPacket::Width; ++lane) {
+            ignore[lane] = (i + lane) % bvh.size();
+            packet.add(Ray(bvh.get_facet(ignore[lane]).center, vSun));
+        }
+        benchmark::DoNotOptimize(bvh.occluded(packet, ignore));
+        i = (i + RayPacket::Width) % bvh.size();
+    }
+    state.SetItemsProcessed(state.iterations()*RayPacket::Width);
+}
+BENCHMARK(BM_FacetBVH_occludedPacket);
+
+// flux tracing with shading and blocking
+static void BM_FacetBVH_traceShadingBlocking(benchmark::State& state)
+{
+    BVHField f;
+    const FieldDataset& dataset = FieldDataset::instance();
+    FacetBVH bvh;
+    bvh.build(f.field, vec2d(1.2, 1.2));
+    FluxTracer tracer(1);
+    tracer.set_facetSize(vec2d(1.2, 1.2));
+    FluxReceiver receiver(Transform::translate(dataset.aimingPoint)*Transform::rotateX(-90.*gcf::degree), 10., 10., 100, 100);
+    const std::size_t raysPerHeliostat = 100;
+    for (auto _ : state) {
+        FluxMap map = tracer.trace(f.field, dataset.sunVectors[0], receiver, raysPerHeliostat, &bvh);
+        benchmark::DoNotOptimize(map.flux.data());
+    }
+    state.SetItemsProcessed(state.iterations()*f.field.size()*raysPerHeliostat);
+}
+BENCHMARK(BM_FacetBVH_traceShadingBlocking);
@@ -0,0 +1,54 @@
+#include <cmath>
+
+#include "gcf.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+FieldDataset::FieldDataset(std::size_t heliostats, std::size_t sunPositions):
+    aimingPoint(0., 0., 20.)
+{
+    // rings of heliostats 3 m apart, every other ring rotated by half a slot
+    double spacing = 3.;
+    for (int ring = 0; locations.size() < heliostats; ++ring)
+    {
+        double radius = 15. + 2.5*ring;
+        int slots = int(gcf::TwoPi*radius/spacing);
+        double step = gcf::TwoPi/slots;
+        double phase = ring % 2 == 0 ? 0. : 0.5*step;
+        for (int n = 0; n < slots && locations.size() < heliostats; ++n)
+        {
+            double phi = phase + n*step;
+            if (std::abs(std::remainder(phi, gcf::TwoPi)) > 75.*gcf::degree) continue; // northern sector
+            locations.push_back(Transform::translate(radius*sin(phi), radius*cos(phi), 0.));
+        }
+    }
+
+    for (std::size_t i = 0; i < sunPositions; ++i)
+    {
+        double t = (i + 0.5)/sunPositions;
+        double azimuth = (100. + 160.*t)*gcf::degree;
+        double elevation = (10. + 60.*sin(gcf::Pi*t))*gcf::degree;
+        sunVectors.push_back(vec3d::directionAE(azimuth, elevation));
+    }
+
+    TrackerArmature2A armature(bluesolarGeometry());
+    vec3d vSun = sunVectors[sunPositions/2];
+    for (const Transform& location : locations)
+    {
+        vec3d rAim = location.inversed().transformPoint(aimingPoint);
+        aimX.push_back(rAim.x);
+        aimY.push_back(rAim.y);
+        aimZ.push_back(rAim.z);
+
+        TrackerTarget target;
+        target.aimingPoint = aimingPoint;
+        armature.update(location, vSun, &target);
+        angles.push_back(target.angles);
+    }
+}
+
+const FieldDataset& FieldDataset::instance()
+{
+    static const FieldDataset dataset;
+    return dataset;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "Bluesolar.h"
+#include "Transform.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Field-sized input data shared by the benchmarks: Bluesolar heliostats
+// in a radially staggered field north of a tower at the origin,
+// and sun positions sampled over a day.
+struct FieldDataset
+{
+    static const std::size_t heliostatsDefault = 10000;
+    static const std::size_t sunPositionsDefault = 64;
+
+    FieldDataset(std::size_t heliostats = heliostatsDefault, std::size_t sunPositions = sunPositionsDefault);
+
+    // shared instance with the default sizes
+    static const FieldDataset& instance();
+
+    std::vector<Transform> locations; // heliostat frames in the field frame
+    std::vector<vec3d> sunVectors; // in the field frame
+    vec3d aimingPoint; // receiver center
+
+    // per heliostat, in the heliostat frame (structure of arrays)
+    std::vector<double> aimX, aimY, aimZ;
+
+    // angles in degrees from TrackerArmature2A::update, used as kinematic model inputs
+    std::vector<vec2d> angles;
+};
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "FieldDefinition.h"
+#include "HeliostatField.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+// Controller restart for a calibrated field, with an armature and actuator models per heliostat.
+// The setup benchmark configures each armature through its setters and each location from its matrix,
+// the load benchmark reads the same field from a field file.
+
+namespace {
+
+// armature of heliostat i, the Bluesolar geometry with small calibration offsets
+void setCalibratedArmature(TrackerArmature2A& armature, std::size_t i)
+{
+    armature.set_geometry(bluesolarGeometry());
+    double d = 1e-4*double(i % 17);
+    armature.set_primaryShift(armature.get_primaryShift() + vec3d(d, -d, 0.));
+    armature.set_secondaryAxis(vec3d(d, 0., -1.));
+}
+
+std::string fieldFileName()
+{
+    return "field_definition_benchmark.bin";
+}
+
+}
+
+static void BM_FieldDefinition_setup(benchmark::State& state)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    TrackerTarget target;
+    target.aimingPoint = dataset.aimingPoint;
+
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<TrackerArmature2A>> armatures;
+        std::vector<ElevationAngleKM> elevationModels;
+        std::vector<HourAngleKM> hourModels;
+        HeliostatField field(1);
+        for (std::size_t i = 0; i < dataset.locations.size(); ++i) {
+            armatures.emplace_back(new TrackerArmature2A);
+            setCalibratedArmature(*armatures.back(), i);
+            elevationModels.push_back(bluesolarElevationAngleKM());
+            hourModels.push_back(bluesolarHourAngleKM());
+            Transform location(dataset.locations[i].getMatrix()->m);
+            field.addHeliostat(location, armatures.back().get(), target);
+        }
+        benchmark::DoNotOptimize(field.size());
+    }
+    state.SetItemsProcessed(state.iterations()*dataset.locations.size());
+}
+BENCHMARK(BM_FieldDefinition_setup)->Unit(benchmark::kMillisecond);
+
+static void BM_FieldDefinition_load(benchmark::State& state)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    {
+        FieldDefinition definition;
+        TrackerTarget target;
+        target.aimingPoint = dataset.aimingPoint;
+        std::size_t models = definition.addModels(bluesolarElevationAngleKM(), bluesolarHourAngleKM());
+        for (std::size_t i = 0; i < dataset.locations.size(); ++i) {
+            TrackerArmature2A armature;
+            setCalibratedArmature(armature, i);
+            definition.addHeliostat(dataset.locations[i], definition.addArmature(armature), target, models);
+        }
+        definition.save(fieldFileName());
+    }
+
+    for (auto _ : state) {
+        FieldDefinition definition = FieldDefinition::load(fieldFileName());
+        HeliostatField field(1);
+        definition.addToField(field);
+        benchmark::DoNotOptimize(field.size());
+    }
+    state.SetItemsProcessed(state.iterations()*dataset.locations.size());
+    std::remove(fieldFileName().c_str());
+}
+BENCHMARK(BM_FieldDefinition_load)->Unit(benchmark::kMillisecond);
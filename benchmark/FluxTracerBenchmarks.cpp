@@ -0,0 +1,39 @@
+#include <benchmark/benchmark.h>
+
+#include "FacetBVH.h"
+#include "FluxTracer.h"
+#include "HeliostatField.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+// rays per second over the whole field, the argument is the number of threads,
+// with shading and blocking against a facet BVH of the field if bvh is true
+static void BM_FluxTracer_trace(benchmark::State& state, bool bvh)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    HeliostatField field;
+    TrackerTarget target;
+    target.aimingPoint = dataset.aimingPoint;
+    for (const Transform& location : dataset.locations)
+        field.addHeliostat(location, &armature, target);
+    const vec3d& vSun = dataset.sunVectors[0];
+    field.update(vSun);
+
+    FluxTracer tracer(int(state.range(0)));
+    tracer.set_slopeError(2e-3);
+    FacetBVH tree;
+    if (bvh)
+        tree.build(field, tracer.get_facetSize());
+    FluxReceiver receiver(Transform::translate(dataset.aimingPoint)*Transform::rotateX(-90.*gcf::degree), 10., 10., 100, 100);
+    const std::size_t raysPerHeliostat = 1000;
+    for (auto _ : state) {
+        FluxMap map = tracer.trace(field, vSun, receiver, raysPerHeliostat, bvh ? &tree : nullptr);
+        benchmark::DoNotOptimize(map.flux.data());
+    }
+    state.SetItemsProcessed(state.iterations()*field.size()*raysPerHeliostat);
+}
+BENCHMARK_CAPTURE(BM_FluxTracer_trace, direct, false)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+BENCHMARK_CAPTURE(BM_FluxTracer_trace, bvh, true)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
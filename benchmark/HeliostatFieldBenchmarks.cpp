@@ -0,0 +1,54 @@
+#include <benchmark/benchmark.h>
+
+#include "HeliostatField.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+// whole field per iteration, the argument is the number of threads
+static void BM_HeliostatField_update(benchmark::State& state)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    HeliostatField field(int(state.range(0)));
+    TrackerTarget target;
+    target.aimingPoint = dataset.aimingPoint;
+    for (const Transform& location : dataset.locations)
+        field.addHeliostat(location, &armature, target);
+
+    std::size_t s = 0;
+    for (auto _ : state) {
+        field.update(dataset.sunVectors[s]);
+        benchmark::DoNotOptimize(field.get_angles().data());
+        s = (s + 1) % dataset.sunVectors.size();
+    }
+    state.SetItemsProcessed(state.iterations()*field.size());
+}
+BENCHMARK(BM_HeliostatField_update)->RangeMultiplier(2)->Range(1, 32)->UseRealTime();
+
+// control cycles with the sun moving 0.1 mrad per cycle, the argument is the tolerance in microradians
+static void BM_HeliostatField_updateIncremental(benchmark::State& state)
+{
+    const FieldDataset& dataset = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    HeliostatField field(1);
+    TrackerTarget target;
+    target.aimingPoint = dataset.aimingPoint;
+    for (const Transform& location : dataset.locations)
+        field.addHeliostat(location, &armature, target);
+
+    double tolerance = state.range(0)*1e-6;
+    std::size_t skipped = 0;
+    int step = 0;
+    for (auto _ : state) {
+        vec3d vSun = vec3d::directionAE(150.*gcf::degree + 1e-4*step, 50.*gcf::degree);
+        skipped += field.update(vSun, tolerance);
+        benchmark::DoNotOptimize(field.get_angles().data());
+        step = (step + 1) % 1000;
+    }
+    state.SetItemsProcessed(state.iterations()*field.size());
+    state.counters["skipped"] = double(skipped)/(state.iterations()*field.size());
+}
+BENCHMARK(BM_HeliostatField_updateIncremental)->Arg(0)->Arg(100)->Arg(1000);
@@ -0,0 +1,150 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "gcf.h"
+#include "ElevationAngleKM.h"
+#include "HourAngleKM.h"
+#include "FieldDataset.h"
+
+// Kinematic model inputs are the field's angles in radians and the matching actuator lengths.
+
+static void BM_ElevationAngleKM_lengthFromAngle(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    ElevationAngleKM km = bluesolarElevationAngleKM();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(km.getActuatorLengthFromElevationAngle(angles[i].x*gcf::degree));
+        if (++i == angles.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ElevationAngleKM_lengthFromAngle);
+
+static void BM_ElevationAngleKM_angleFromLength(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    ElevationAngleKM km = bluesolarElevationAngleKM();
+    std::vector<double> lengths;
+    for (const vec2d& a : angles)
+        lengths.push_back(km.getActuatorLengthFromElevationAngle(a.x*gcf::degree));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(km.getElevationAngleFromActuatorLength(lengths[i]));
+        if (++i == lengths.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ElevationAngleKM_angleFromLength);
+
+static void BM_HourAngleKM_lengthFromAngle(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    HourAngleKM km = bluesolarHourAngleKM();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(km.getActuatorLengthFromHourAngle(angles[i].y*gcf::degree));
+        if (++i == angles.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HourAngleKM_lengthFromAngle);
+
+static void BM_HourAngleKM_angleFromLength(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    HourAngleKM km = bluesolarHourAngleKM();
+    std::vector<double> lengths;
+    for (const vec2d& a : angles)
+        lengths.push_back(km.getActuatorLengthFromHourAngle(a.y*gcf::degree));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(km.getHourAngleFromActuatorLength(lengths[i]));
+        if (++i == lengths.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HourAngleKM_angleFromLength);
+
+// Batch conversions over the whole field
+
+static void BM_ElevationAngleKM_lengthsFromAngles(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    ElevationAngleKM km = bluesolarElevationAngleKM();
+    std::vector<double> input, output(angles.size());
+    for (const vec2d& a : angles)
+        input.push_back(a.x*gcf::degree);
+    for (auto _ : state) {
+        km.getActuatorLengthsFromElevationAngles(input.size(), input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations()*input.size());
+}
+BENCHMARK(BM_ElevationAngleKM_lengthsFromAngles);
+
+static void BM_ElevationAngleKM_anglesFromLengths(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    ElevationAngleKM km = bluesolarElevationAngleKM();
+    std::vector<double> input, output(angles.size());
+    for (const vec2d& a : angles)
+        input.push_back(km.getActuatorLengthFromElevationAngle(a.x*gcf::degree));
+    for (auto _ : state) {
+        km.getElevationAnglesFromActuatorLengths(input.size(), input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations()*input.size());
+}
+BENCHMARK(BM_ElevationAngleKM_anglesFromLengths);
+
+static void BM_HourAngleKM_lengthsFromAngles(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    HourAngleKM km = bluesolarHourAngleKM();
+    std::vector<double> input, output(angles.size());
+    for (const vec2d& a : angles)
+        input.push_back(a.y*gcf::degree);
+    for (auto _ : state) {
+        km.getActuatorLengthsFromHourAngles(input.size(), input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations()*input.size());
+}
+BENCHMARK(BM_HourAngleKM_lengthsFromAngles);
+
+static void BM_HourAngleKM_anglesFromLengths(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    HourAngleKM km = bluesolarHourAngleKM();
+    std::vector<double> input, output(angles.size());
+    for (const vec2d& a : angles)
+        input.push_back(km.getActuatorLengthFromHourAngle(a.y*gcf::degree));
+    for (auto _ : state) {
+        km.getHourAnglesFromActuatorLengths(input.size(), input.data(), output.data());
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations()*input.size());
+}
+BENCHMARK(BM_HourAngleKM_anglesFromLengths);
+
+// Polynomial fast path over the Bluesolar elevation range
+
+static void BM_ElevationAngleKM_approximation(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    ElevationAngleKM km = bluesolarElevationAngleKM();
+    km.setApproximation(Interval(0., 90.*gcf::degree));
+    std::vector<double> lengths;
+    for (const vec2d& a : angles)
+        lengths.push_back(km.getActuatorLengthFromElevationAngle(a.x*gcf::degree));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(km.getElevationAngleFromActuatorLength(lengths[i]));
+        if (++i == lengths.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["segments"] = km.get_angleApproximation().get_segments();
+}
+BENCHMARK(BM_ElevationAngleKM_approximation);
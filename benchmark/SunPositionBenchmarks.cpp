@@ -0,0 +1,43 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "gcf.h"
+#include "SunEphemeris.h"
+#include "SunPositionEngine.h"
+
+// one day at one-second steps per iteration
+static void BM_SunPositionEngine_findSunVectors(benchmark::State& state)
+{
+    SunPositionEngine engine(-2.358*gcf::degree, 37.094*gcf::degree);
+    std::vector<double> times(86400);
+    double start = SunPositionEngine::toUnixTime(2024, 6, 20);
+    for (std::size_t i = 0; i < times.size(); ++i)
+        times[i] = start + i;
+    std::vector<double> vectors(3*times.size());
+
+    for (auto _ : state) {
+        engine.findSunVectors(times.size(), times.data(), vectors.data());
+        benchmark::DoNotOptimize(vectors.data());
+    }
+    state.SetItemsProcessed(state.iterations()*times.size());
+}
+BENCHMARK(BM_SunPositionEngine_findSunVectors);
+
+static void BM_SunEphemeris_findSunVectors(benchmark::State& state)
+{
+    SunPositionEngine engine(-2.358*gcf::degree, 37.094*gcf::degree);
+    SunEphemeris ephemeris = SunEphemeris::forYear(engine, 2024, 60.);
+    std::vector<double> times(86400);
+    double start = SunPositionEngine::toUnixTime(2024, 6, 20);
+    for (std::size_t i = 0; i < times.size(); ++i)
+        times[i] = start + i;
+    std::vector<double> vectors(3*times.size());
+
+    for (auto _ : state) {
+        ephemeris.findSunVectors(times.size(), times.data(), vectors.data());
+        benchmark::DoNotOptimize(vectors.data());
+    }
+    state.SetItemsProcessed(state.iterations()*times.size());
+}
+BENCHMARK(BM_SunEphemeris_findSunVectors);
@@ -0,0 +1,263 @@
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "ArrayView.h"
+#include "gcf.h"
+#include "TrackerArmature2A.h"
+#include "TrackerSolver2A.h"
+#include "TrackerTarget.h"
+#include "FieldDataset.h"
+
+// Each iteration handles one heliostat of the field, cycling through heliostats and sun positions.
+
+static void BM_TrackerArmature2A_update(benchmark::State& state, TrackerTarget::AimingType aimingType)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    std::vector<TrackerTarget> targets(field.locations.size());
+    for (std::size_t i = 0; i < targets.size(); ++i) {
+        targets[i].aimingType = aimingType;
+        if (aimingType == TrackerTarget::global)
+            targets[i].aimingPoint = field.aimingPoint;
+        else
+            targets[i].aimingPoint = vec3d(field.aimX[i], field.aimY[i], field.aimZ[i]);
+    }
+
+    std::size_t i = 0;
+    std::size_t s = 0;
+    for (auto _ : state) {
+        armature.update(field.locations[i], field.sunVectors[s], &targets[i]);
+        benchmark::DoNotOptimize(targets[i].angles);
+        if (++i == targets.size()) {
+            i = 0;
+            s = (s + 1) % field.sunVectors.size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_TrackerArmature2A_update, local, TrackerTarget::local);
+BENCHMARK_CAPTURE(BM_TrackerArmature2A_update, global, TrackerTarget::global);
+
+static void BM_TrackerArmature2A_updateWarmStart(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    std::vector<TrackerTarget> targets(field.locations.size());
+    for (TrackerTarget& target : targets) {
+        target.aimingPoint = field.aimingPoint;
+        target.warmStart = true;
+    }
+
+    std::size_t i = 0;
+    std::size_t s = 0;
+    for (auto _ : state) {
+        armature.update(field.locations[i], field.sunVectors[s], &targets[i]);
+        benchmark::DoNotOptimize(targets[i].angles);
+        if (++i == targets.size()) {
+            i = 0;
+            s = (s + 1) % field.sunVectors.size();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrackerArmature2A_updateWarmStart);
+
+// whole field per iteration, sun vector in the heliostat frame equals the field frame for translations
+static void BM_TrackerArmature2A_updateBatch(benchmark::State& state, TrackerTarget::AimingType aimingType)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    TrackerArmature2A armature(bluesolarGeometry());
+
+    std::size_t count = field.locations.size();
+    std::vector<double> sun(3*count);
+    std::vector<double> angles(2*count);
+    vec3dArrayView rAim(field.aimX.data(), field.aimY.data(), field.aimZ.data());
+
+    std::size_t s = 0;
+    for (auto _ : state) {
+        const vec3d& vSun = field.sunVectors[s];
+        for (std::size_t i = 0; i < count; ++i) {
+            sun[3*i] = vSun.x;
+            sun[3*i + 1] = vSun.y;
+            sun[3*i + 2] = vSun.z;
+        }
+        armature.updateBatch(count, vec3dArrayView::interleaved(sun.data()), rAim,
+                             aimingType, vec2dArrayView::interleaved(angles.data()));
+        benchmark::DoNotOptimize(angles.data());
+        s = (s + 1) % field.sunVectors.size();
+    }
+    state.SetItemsProcessed(state.iterations()*count);
+}
+BENCHMARK_CAPTURE(BM_TrackerArmature2A_updateBatch, local, TrackerTarget::local);
+BENCHMARK_CAPTURE(BM_TrackerArmature2A_updateBatch, global, TrackerTarget::global);
+
+// calibration-style reconfiguration: all the geometry is set and the armature is used once,
+// the setters defer the rebuild to the first use
+static void BM_TrackerArmature2A_configure(benchmark::State& state)
+{
+    TrackerArmature2A armature;
+    double d = 0.;
+    for (auto _ : state) {
+        armature.set_geometry(bluesolarGeometry());
+        armature.set_primaryShift(vec3d(0., 0., 2.415 + d));
+        benchmark::DoNotOptimize(armature.get_compiled().facetPoint0);
+        d = d < 1e-3 ? d + 1e-6 : 0.;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TrackerArmature2A_configure);
+
+// solver methods in the heliostat frame
+
+class SolverFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(const benchmark::State&) override
+    {
+        armature.set_geometry(bluesolarGeometry());
+        solver = armature.get_solver();
+        const FieldDataset& field = FieldDataset::instance();
+        for (std::size_t i = 0; i < field.locations.size(); ++i) {
+            rAim.push_back(vec3d(field.aimX[i], field.aimY[i], field.aimZ[i]));
+            vSun.push_back(field.sunVectors[i % field.sunVectors.size()]);
+        }
+    }
+
+    TrackerArmature2A armature;
+    TrackerSolver2A* solver;
+    std::vector<vec3d> rAim;
+    std::vector<vec3d> vSun;
+};
+
+BENCHMARK_F(SolverFixture, solveReflectionGlobal)(benchmark::State& state)
+{
+    Solutions2A solutions;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver->solveReflectionGlobal(vSun[i], rAim[i], solutions));
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveReflectionGlobalNewton)(benchmark::State& state)
+{
+    solver->set_method(TrackerSolver2A::newton);
+    Solutions2A solutions;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver->solveReflectionGlobal(vSun[i], rAim[i], solutions));
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveReflectionGlobalVector)(benchmark::State& state)
+{
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver->solveReflectionGlobal(vSun[i], rAim[i]));
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveReflectionSecondary)(benchmark::State& state)
+{
+    Solutions2A solutions;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        solver->solveReflectionSecondary(vSun[i], rAim[i], solutions);
+        benchmark::DoNotOptimize(solutions);
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveFacetNormal)(benchmark::State& state)
+{
+    Solutions2A solutions;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        solver->solveFacetNormal((vSun[i] + rAim[i].normalized()).normalized(), solutions);
+        benchmark::DoNotOptimize(solutions);
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveRotation)(benchmark::State& state)
+{
+    const vec3d& v0 = armature.get_compiled().facetNormal;
+    Solutions2A solutions;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        solver->solveRotation(v0, vSun[i], solutions);
+        benchmark::DoNotOptimize(solutions);
+        if (++i == rAim.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, solveRotationBatch)(benchmark::State& state)
+{
+    std::size_t count = vSun.size();
+    const vec3d& normal = armature.get_compiled().facetNormal;
+    std::vector<double> v0, v;
+    for (const vec3d& vS : vSun) {
+        v0.insert(v0.end(), {normal.x, normal.y, normal.z});
+        v.insert(v.end(), {vS.x, vS.y, vS.z});
+    }
+    std::vector<Solutions2A> solutions(count);
+    for (auto _ : state) {
+        solver->solveRotationBatch(count, vec3dArrayView::interleaved(v0.data()), vec3dArrayView::interleaved(v.data()), solutions.data());
+        benchmark::DoNotOptimize(solutions.data());
+    }
+    state.SetItemsProcessed(state.iterations()*count);
+}
+
+BENCHMARK_F(SolverFixture, solveRotationBatchFloat)(benchmark::State& state)
+{
+    TrackerSolver2Af solverFloat(&armature);
+    std::size_t count = vSun.size();
+    const vec3f& normal = armature.get_compiledFloat().facetNormal;
+    std::vector<float> v0, v;
+    for (const vec3d& vS : vSun) {
+        v0.insert(v0.end(), {normal.x, normal.y, normal.z});
+        v.insert(v.end(), {float(vS.x), float(vS.y), float(vS.z)});
+    }
+    std::vector<Solutions2Af> solutions(count);
+    for (auto _ : state) {
+        solverFloat.solveRotationBatch(count, vec3fArrayView::interleaved(v0.data()), vec3fArrayView::interleaved(v.data()), solutions.data());
+        benchmark::DoNotOptimize(solutions.data());
+    }
+    state.SetItemsProcessed(state.iterations()*count);
+}
+
+BENCHMARK_F(SolverFixture, findFacetPoint)(benchmark::State& state)
+{
+    const std::vector<vec2d>& angles = FieldDataset::instance().angles;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver->findFacetPoint(angles[i]*gcf::degree));
+        if (++i == angles.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_F(SolverFixture, selectSolution)(benchmark::State& state)
+{
+    std::vector<Solutions2A> solutions(rAim.size());
+    for (std::size_t i = 0; i < rAim.size(); ++i)
+        solver->solveReflectionSecondary(vSun[i], rAim[i], solutions[i]);
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(solver->selectSolution(solutions[i]));
+        if (++i == solutions.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
@@ -0,0 +1,98 @@
+#include <benchmark/benchmark.h>
+
+#include "gcf.h"
+#include "AffineTransform.h"
+#include "Matrix4x4.h"
+#include "Transform.h"
+#include "FieldDataset.h"
+
+static void BM_Transform_multiply(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    Transform rotation = Transform::rotate(25.*gcf::degree, vec3d(1., 0., 0.));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(field.locations[i]*rotation);
+        if (++i == field.locations.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transform_multiply);
+
+static void BM_Transform_inversed(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(field.locations[i].inversed());
+        if (++i == field.locations.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transform_inversed);
+
+static void BM_Transform_rotate(benchmark::State& state)
+{
+    vec3d axis(-1., 0., 0.);
+    double angle = 0.;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Transform::rotate(angle, axis));
+        angle += 0.001;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transform_rotate);
+
+static void BM_Transform_transformPoint(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(field.locations[i].transformPoint(field.aimingPoint));
+        if (++i == field.locations.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Transform_transformPoint);
+
+static void BM_AffineTransform_multiply(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    std::vector<AffineTransform> locations(field.locations.begin(), field.locations.end());
+    AffineTransform rotation = AffineTransform::rotate(25.*gcf::degree, vec3d(1., 0., 0.));
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(locations[i]*rotation);
+        if (++i == locations.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AffineTransform_multiply);
+
+static void BM_AffineTransform_inversed(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    std::vector<AffineTransform> locations(field.locations.begin(), field.locations.end());
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(locations[i].inversed());
+        if (++i == locations.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AffineTransform_inversed);
+
+static void BM_Matrix4x4_inversed(benchmark::State& state)
+{
+    const FieldDataset& field = FieldDataset::instance();
+    std::vector<Matrix4x4> matrices;
+    for (const Transform& location : field.locations)
+        matrices.push_back(*(location*Transform::rotate(25.*gcf::degree, vec3d(1., 1., 0.))).getMatrix());
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(matrices[i].inversed());
+        if (++i == matrices.size()) i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Matrix4x4_inversed);
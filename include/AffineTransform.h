@@ -0,0 +1,79 @@
+#pragma once
+
+#include <iostream>
+
+#include "heliostat_tracking_export.h"
+#include "vec3d.h"
+
+class Ray;
+template<class T> class TransformT;
+typedef TransformT<double> Transform;
+
+// Affine transform with value semantics.
+// The direct and inverse matrices are stored inline as the upper 3x4 block of the
+// homogeneous matrix (the last row is implicitly 0, 0, 0, 1), so copying, inverting
+// and composing transforms never allocates.
+class HELIOSTAT_TRACKING_EXPORT AffineTransform
+{
+public:
+    AffineTransform();
+    AffineTransform(const double mdir[3][4], const double minv[3][4]);
+    explicit AffineTransform(const double mdir[3][4]); // the inverse is computed, mdir must be invertible
+    AffineTransform(const Transform& t); // t is assumed to be affine
+
+    Transform toTransform() const;
+
+    const double (&getMatrix() const)[3][4] {return m_mdir;}
+    const double (&getInverseMatrix() const)[3][4] {return m_minv;}
+
+    AffineTransform inversed() const {return AffineTransform(m_minv, m_mdir);}
+    vec3d getScales() const;
+    bool SwapsHandedness() const;
+
+    AffineTransform operator*(const AffineTransform& rhs) const;
+
+    vec3d transformPoint(const vec3d& p) const
+    {
+        return vec3d(
+            m_mdir[0][0]*p.x + m_mdir[0][1]*p.y + m_mdir[0][2]*p.z + m_mdir[0][3],
+            m_mdir[1][0]*p.x + m_mdir[1][1]*p.y + m_mdir[1][2]*p.z + m_mdir[1][3],
+            m_mdir[2][0]*p.x + m_mdir[2][1]*p.y + m_mdir[2][2]*p.z + m_mdir[2][3]
+        );
+    }
+
+    vec3d transformVector(const vec3d& v) const
+    {
+        return vec3d(
+            m_mdir[0][0]*v.x + m_mdir[0][1]*v.y + m_mdir[0][2]*v.z,
+            m_mdir[1][0]*v.x + m_mdir[1][1]*v.y + m_mdir[1][2]*v.z,
+            m_mdir[2][0]*v.x + m_mdir[2][1]*v.y + m_mdir[2][2]*v.z
+        );
+    }
+
+    vec3d transformNormal(const vec3d& n) const;
+    vec3d transformInverseNormal(const vec3d& n) const;
+    Ray transformDirect(const Ray& r) const;
+    Ray transformInverse(const Ray& r) const;
+
+    vec3d operator()(const vec3d& v) const {return transformVector(v);}
+    Ray operator()(const Ray& r) const;
+
+    bool operator==(const AffineTransform& t) const;
+
+    static const AffineTransform Identity;
+    static AffineTransform translate(double x, double y, double z);
+    static AffineTransform translate(const vec3d& v) {return translate(v.x, v.y, v.z);}
+    static AffineTransform scale(double x, double y, double z);
+    static AffineTransform rotateX(double angle);
+    static AffineTransform rotateY(double angle);
+    static AffineTransform rotateZ(double angle);
+    static AffineTransform rotate(double angle, const vec3d& axis);
+
+private:
+    static AffineTransform fromRotation(const double r[3][3]);
+
+    double m_mdir[3][4];
+    double m_minv[3][4];
+};
+
+HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const AffineTransform& t);
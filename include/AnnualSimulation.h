@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "ElevationAngleKM.h"
+#include "HeliostatField.h"
+#include "HourAngleKM.h"
+#include "ResultStore.h"
+#include "SunPositionEngine.h"
+
+// Tracking of a heliostat field over a time range, written to a SimulationFileHeader file
+// preallocated and mapped by a ResultStore.
+// The sun positions, the field updates and the file output run as a pipeline
+// on three threads, exchanging a fixed number of chunk buffers,
+// so the memory does not depend on the number of steps.
+// The field is updated in place (its targets keep the state of the last step)
+// and must not be used by other threads during run.
+// Steps with the sun below the horizon write NaN and reset the tracking of the targets,
+// so the warm-started targets start cold in the morning.
+class HELIOSTAT_TRACKING_EXPORT AnnualSimulation
+{
+public:
+    AnnualSimulation(HeliostatField* field, const SunPositionEngine& engine);
+
+    // Times [timeStart, timeEnd] in Unix seconds with the step in seconds.
+    // Throws std::invalid_argument for an empty range or a step that is not positive.
+    void set_timeRange(double timeStart, double timeEnd, double step);
+    double get_timeStart() const { return m_timeStart; }
+    double get_timeEnd() const { return m_timeEnd; }
+    double get_step() const { return m_step; }
+    std::size_t get_steps() const;
+
+    // Actuator lengths of the primary angle (elevation) and secondary angle (hour) for every heliostat,
+    // nullptr for both writes the angles only. The models are not owned.
+    void set_actuatorModels(const ElevationAngleKM* elevation, const HourAngleKM* hour);
+    // One pair of models per heliostat of the field, nullptr for both writes NaN lengths for the heliostat.
+    // Consecutive heliostats sharing their models are converted in one batch.
+    // run throws std::invalid_argument if the field has another number of heliostats.
+    void set_actuatorModels(const std::vector<const ElevationAngleKM*>& elevations,
+                            const std::vector<const HourAngleKM*>& hours);
+
+    // Time steps per chunk, a chunk buffer holds chunkSteps*heliostats values per column
+    std::size_t get_chunkSteps() const { return m_chunkSteps; }
+    void set_chunkSteps(std::size_t chunkSteps);
+
+    // Runs the simulation and writes fileName.
+    // Throws std::runtime_error if the file cannot be written, errors of the stages are rethrown.
+    void run(const std::string& fileName);
+
+private:
+    HeliostatField* m_field;
+    SunPositionEngine m_engine;
+    double m_timeStart;
+    double m_timeEnd;
+    double m_step;
+    // a single pair for all heliostats or one pair per heliostat
+    std::vector<const ElevationAngleKM*> m_elevations;
+    std::vector<const HourAngleKM*> m_hours;
+    bool m_modelsShared;
+    std::size_t m_chunkSteps;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "ElevationAngleKM.h"
+#include "HourAngleKM.h"
+#include "ThreadPool.h"
+#include "TrackerArmature2A.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Measurement of the reflected beam of a heliostat, in the heliostat frame
+// (field vectors are brought to it with the inverse of the heliostat location).
+struct CalibrationObservation
+{
+    vec3d vSun; // unit vector towards the sun
+    vec2d input; // commanded actuator lengths (meters) with actuator models, angles (degrees) otherwise
+    vec3d beam; // measured point of the reflected beam, e.g. the beam center on a camera target
+};
+
+// Observations of one heliostat with its nominal armature and actuator models.
+// The models are optional (both or none), the pointed data must outlive the calibration.
+struct CalibrationProblem
+{
+    const TrackerArmature2A* armature = nullptr;
+    const ElevationAngleKM* elevation = nullptr;
+    const HourAngleKM* hour = nullptr;
+    const CalibrationObservation* observations = nullptr;
+    std::size_t count = 0;
+};
+
+struct CalibrationResult
+{
+    // fitted geometry, the angle limits, facet and default angles are those of the nominal armature
+    TrackerArmature2A::Geometry geometry;
+    // fitted actuator models, the angle offsets are folded into alpha2 (elevation) and gamma (hour)
+    std::optional<ElevationAngleKM> elevation;
+    std::optional<HourAngleKM> hour;
+    vec2d angleOffsets; // degrees, added to the commanded angles when there are no actuator models
+
+    double rmsStart; // rms distance in meters from the beam points to the reflected rays, nominal armature
+    double rms; // the same with the fitted parameters
+    std::size_t observations; // observations used, those out of the actuator ranges are skipped
+    int iterations;
+    bool converged;
+};
+
+// Fit of the armature geometry (and actuator models) of heliostats to beam observations
+// with Levenberg-Marquardt and analytic Jacobians.
+// The residual of an observation is the distance from the beam point to the reflected ray,
+// as cross(d, beam - p) for the facet point p and the reflected direction d.
+// The fitted parameters are selected by groups:
+//   shifts: primary shift (3) and secondary shift across the primary axis (2),
+//   the other components move the facet along the axes and are not observable
+//   axes: tilts of the primary and secondary axes (2 + 2)
+//   angleOffsets: offsets of the primary and secondary angles (2)
+//   actuatorModels: rbc, rad and offset of both actuator models (3 + 3), rab is kept
+// Heliostats are calibrated independently, in parallel over a thread pool,
+// and the results do not depend on the number of threads.
+class HELIOSTAT_TRACKING_EXPORT ArmatureCalibration
+{
+public:
+    enum Parameters {
+        shifts = 1,
+        axes = 2,
+        angleOffsets = 4,
+        actuatorModels = 8,
+        all = shifts | axes | angleOffsets | actuatorModels
+    };
+
+    ArmatureCalibration(int threads = 0);
+
+    // combination of Parameters, actuatorModels is ignored for problems without models
+    int get_parameters() const { return m_parameters; }
+    void set_parameters(int parameters) { m_parameters = parameters; }
+
+    // Stops when an accepted step lowers the sum of squares by less than tolerance (relative)
+    // or after iterationsMax iterations
+    int get_iterationsMax() const { return m_iterationsMax; }
+    void set_iterationsMax(int iterationsMax) { m_iterationsMax = iterationsMax; }
+    double get_tolerance() const { return m_tolerance; }
+    void set_tolerance(double tolerance) { m_tolerance = tolerance; }
+
+    int get_threads() const { return m_pool->get_threads(); }
+    void set_threads(int threads);
+
+    // Calibrates one heliostat.
+    // Throws std::invalid_argument without armature or with a single actuator model.
+    CalibrationResult calibrate(const CalibrationProblem& problem) const;
+    // Calibrates heliostats in parallel, one result per problem
+    std::vector<CalibrationResult> calibrate(const std::vector<CalibrationProblem>& problems) const;
+
+private:
+    int m_parameters;
+    int m_iterationsMax;
+    double m_tolerance;
+    std::unique_ptr<ThreadPool> m_pool;
+};
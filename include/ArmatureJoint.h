@@ -1,6 +1,7 @@
 #pragma once
 
 #include "heliostat_tracking_export.h"
+#include "AffineTransform.h"
 #include "Transform.h"
 #include "IntervalPeriodic.h"
 #include "gcf.h"
@@ -19,6 +20,7 @@ struct HELIOSTAT_TRACKING_EXPORT ArmatureJoint
     IntervalPeriodic angles;
 
     Transform getTransform(double angle) const;
+    AffineTransform getAffineTransform(double angle) const;
 };
 
 
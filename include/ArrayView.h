@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Non-owning views over arrays of vectors stored as separate component arrays.
+// Structure-of-arrays data uses stride 1. Interleaved data (e.g. an N x 3 buffer)
+// is addressed with x = data, y = data + 1, z = data + 2 and stride 3.
+// The views are templated on the scalar type, with d and f aliases for double and float.
+
+template<class T>
+struct vec3ArrayView
+{
+    vec3ArrayView(const T* x = nullptr, const T* y = nullptr, const T* z = nullptr, std::size_t stride = 1):
+        x(x), y(y), z(z), stride(stride) {}
+
+    static vec3ArrayView interleaved(const T* data) {return vec3ArrayView(data, data + 1, data + 2, 3);}
+
+    // view starting at element i
+    vec3ArrayView from(std::size_t i) const
+    {
+        std::size_t k = i*stride;
+        return vec3ArrayView(x + k, y + k, z + k, stride);
+    }
+
+    vec3<T> operator[](std::size_t i) const
+    {
+        std::size_t k = i*stride;
+        return vec3<T>(x[k], y[k], z[k]);
+    }
+
+    const T* x;
+    const T* y;
+    const T* z;
+    std::size_t stride;
+};
+
+template<class T>
+struct vec2ArrayView
+{
+    vec2ArrayView(T* x = nullptr, T* y = nullptr, std::size_t stride = 1):
+        x(x), y(y), stride(stride) {}
+
+    // a view of float converts to a view of const float
+    template<class U>
+    vec2ArrayView(const vec2ArrayView<U>& view):
+        x(view.x), y(view.y), stride(view.stride) {}
+
+    static vec2ArrayView interleaved(T* data) {return vec2ArrayView(data, data + 1, 2);}
+
+    // view starting at element i
+    vec2ArrayView from(std::size_t i) const
+    {
+        std::size_t k = i*stride;
+        return vec2ArrayView(x + k, y + k, stride);
+    }
+
+    vec2<T> operator[](std::size_t i) const
+    {
+        std::size_t k = i*stride;
+        return vec2<T>(x[k], y[k]);
+    }
+
+    void set(std::size_t i, const vec2<T>& v)
+    {
+        std::size_t k = i*stride;
+        x[k] = v.x;
+        y[k] = v.y;
+    }
+
+    T* x;
+    T* y;
+    std::size_t stride;
+};
+
+typedef vec3ArrayView<double> vec3dArrayView;
+typedef vec3ArrayView<float> vec3fArrayView;
+typedef vec2ArrayView<double> vec2dArrayView;
+typedef vec2ArrayView<float> vec2fArrayView;
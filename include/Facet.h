@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+#include "heliostat_tracking_export.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+class HeliostatField;
+class Ray;
+
+// Flat rectangular facet in the field frame, the corners are center +- u +- v.
+struct HELIOSTAT_TRACKING_EXPORT Facet
+{
+    vec3d center;
+    vec3d u; // half of the width, along the secondary axis
+    vec3d v; // half of the height
+    vec3d normal;
+
+    // Facet of heliostat i at the angles of the last field update.
+    // size is the width along the secondary axis and the height across it.
+    static Facet fromField(const HeliostatField& field, std::size_t i, const vec2d& size);
+
+    // Axis-aligned bounds of the rectangle
+    void getBounds(vec3d& lo, vec3d& hi) const;
+
+    // Intersection with the ray inside (tMin, tMax), from either side
+    bool intersect(const Ray& ray, double& t) const;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "Facet.h"
+#include "RayPacket.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+class HeliostatField;
+
+// Bounding volume hierarchy over the facets of a heliostat field,
+// used for shading and blocking queries.
+// build splits the facets at the median of their centers along the widest axis,
+// refit recomputes the facets from the current angles and updates the bounds
+// bottom-up without changing the tree, which stays efficient as long as
+// the heliostats only rotate.
+class HELIOSTAT_TRACKING_EXPORT FacetBVH
+{
+public:
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    FacetBVH() {}
+
+    // size is the facet width along the secondary axis and the height across it
+    void build(const HeliostatField& field, const vec2d& size);
+    // field must hold the heliostats the tree was built for
+    void refit(const HeliostatField& field);
+
+    std::size_t size() const { return m_facets.size(); }
+    std::size_t nodes() const { return m_nodes.size(); }
+    const vec2d& get_facetSize() const { return m_size; }
+    const Facet& get_facet(std::size_t i) const { return m_facets[m_slots[i]]; }
+
+    // Closest facet hit by the ray, the facet ignore is skipped (e.g. the one the ray starts on).
+    // Returns the heliostat index or npos, ray.tMax is set to the hit.
+    std::size_t intersect(const Ray& ray, std::size_t ignore = npos) const;
+    // Any facet hit by the ray, stops at the first hit
+    bool occluded(const Ray& ray, std::size_t ignore = npos) const;
+
+    // Packet versions, the lanes are traversed together with AVX2 when the CPU supports it
+    // and get the same results as single rays. ignore holds a facet per lane or is nullptr.
+    // intersect writes the closest facet of each lane to hits (npos for none) and sets the lane tMax,
+    // occluded returns the occluded lanes as a bit mask.
+    void intersect(RayPacket& packet, std::size_t* hits, const std::size_t* ignore = nullptr) const;
+    int occluded(const RayPacket& packet, const std::size_t* ignore = nullptr) const;
+
+private:
+    struct Node
+    {
+        vec3d lo;
+        vec3d hi;
+        std::uint32_t index; // first facet for leaves, right child for inner nodes (the left child follows the node)
+        std::uint32_t count; // facets in a leaf, 0 for inner nodes
+    };
+
+    std::uint32_t buildNode(std::uint32_t begin, std::uint32_t end);
+    template<bool any>
+    std::size_t traverse(const Ray& ray, std::size_t ignore) const;
+
+    vec2d m_size;
+    std::vector<Facet> m_facets; // in leaf order
+    std::vector<std::uint32_t> m_ids; // heliostat of each facet
+    std::vector<std::uint32_t> m_slots; // facet of each heliostat
+    std::vector<Node> m_nodes; // depth-first, children after their parent
+};
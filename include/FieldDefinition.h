@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "AffineTransform.h"
+#include "ElevationAngleKM.h"
+#include "HourAngleKM.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+
+class HeliostatField;
+
+// Description of a heliostat field: armature types (geometry and joint limits),
+// actuator kinematic models and heliostats (location, armature, models and target).
+// It is saved in a compact binary file, in native byte order, and loaded in bulk:
+// every armature is built once from all its parameters and the locations keep
+// their stored inverses inline, so nothing is recomputed or allocated per setter or per heliostat.
+// The definition owns the armatures used by the fields built from it and must outlive them.
+class HELIOSTAT_TRACKING_EXPORT FieldDefinition
+{
+public:
+    static constexpr std::size_t npos = std::size_t(-1);
+
+    FieldDefinition() {}
+    FieldDefinition(FieldDefinition&&) = default;
+    FieldDefinition& operator=(FieldDefinition&&) = default;
+    FieldDefinition(const FieldDefinition&) = delete;
+    FieldDefinition& operator=(const FieldDefinition&) = delete;
+
+    // returns the index of the armature, which copies the geometry of armature
+    std::size_t addArmature(const TrackerArmature2A& armature);
+    // returns the index of the pair of kinematic models, for the primary and secondary actuators
+    std::size_t addModels(const ElevationAngleKM& elevation, const HourAngleKM& hour);
+    // returns the index of the heliostat, models is npos for heliostats without actuator models
+    std::size_t addHeliostat(const AffineTransform& location, std::size_t armature,
+                             const TrackerTarget& target = TrackerTarget(), std::size_t models = npos);
+    void clear();
+
+    std::size_t armatures() const { return m_armatures.size(); }
+    std::size_t models() const { return m_elevationModels.size(); }
+    std::size_t size() const { return m_locations.size(); }
+
+    TrackerArmature2A* get_armature(std::size_t k) const { return m_armatures[k].get(); }
+    const ElevationAngleKM& get_elevationModel(std::size_t k) const { return m_elevationModels[k]; }
+    const HourAngleKM& get_hourModel(std::size_t k) const { return m_hourModels[k]; }
+
+    const AffineTransform& get_location(std::size_t i) const { return m_locations[i]; }
+    std::size_t get_armatureIndex(std::size_t i) const { return m_armatureIndices[i]; }
+    std::size_t get_modelIndex(std::size_t i) const { return m_modelIndices[i]; }
+    const TrackerTarget& get_target(std::size_t i) const { return m_targets[i]; }
+
+    // Definition of the heliostats of field, an armature is added for each distinct armature of the field
+    static FieldDefinition fromField(const HeliostatField& field);
+    // Appends the heliostats to field, with the armatures of this definition
+    void addToField(HeliostatField& field) const;
+    // Appends the models of the heliostats in the order of addToField, nullptr for heliostats without models,
+    // e.g. for AnnualSimulation::set_actuatorModels. The pointers are valid until models are added.
+    void addToModels(std::vector<const ElevationAngleKM*>& elevations, std::vector<const HourAngleKM*>& hours) const;
+
+    // Throw std::runtime_error if the file cannot be written or read or is not a valid field file
+    void save(const std::string& fileName) const;
+    static FieldDefinition load(const std::string& fileName);
+
+private:
+    std::vector<std::unique_ptr<TrackerArmature2A>> m_armatures;
+    std::vector<ElevationAngleKM> m_elevationModels;
+    std::vector<HourAngleKM> m_hourModels;
+
+    std::vector<AffineTransform> m_locations;
+    std::vector<std::size_t> m_armatureIndices;
+    std::vector<std::size_t> m_modelIndices;
+    std::vector<TrackerTarget> m_targets;
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "FacetBVH.h"
+#include "HeliostatField.h"
+#include "ThreadPool.h"
+#include "Transform.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Planar receiver in the xy plane of its frame.
+// The flux map covers |x| <= width/2, |y| <= height/2 with nx by ny bins,
+// hits from both sides of the plane are counted.
+struct HELIOSTAT_TRACKING_EXPORT FluxReceiver
+{
+    FluxReceiver(const Transform& location = Transform::Identity, double width = 1., double height = 1., int nx = 1, int ny = 1):
+        location(location), width(width), height(height), nx(nx), ny(ny) {}
+
+    Transform location; // receiver frame to field frame
+    double width;
+    double height;
+    int nx;
+    int ny;
+};
+
+// Flux density in W/m^2, bin (i, j) is column i along x and row j along y.
+struct HELIOSTAT_TRACKING_EXPORT FluxMap
+{
+    int nx = 0;
+    int ny = 0;
+    std::vector<double> flux; // row-major, ny rows of nx bins
+
+    double power = 0.; // power on the receiver in W
+    std::size_t rays = 0; // rays traced
+    std::size_t hits = 0; // rays hitting the receiver
+    std::size_t shaded = 0; // rays stopped by another facet before reaching the facet
+    std::size_t blocked = 0; // reflected rays stopped by another facet before the receiver
+
+    double operator()(int i, int j) const { return flux[j*nx + i]; }
+};
+
+// Monte Carlo ray tracer for the flux on a planar receiver.
+// Each heliostat is a flat rectangular facet at the facet point of its armature,
+// oriented by the angles from the last HeliostatField update.
+// Sun rays are sampled on the facet and in a pillbox sun disk, reflected with an optional
+// gaussian slope error and intersected with the receiver.
+// Shading and blocking are checked against a FacetBVH of the field when one is given.
+// Every heliostat has its own random stream derived from the seed and its index,
+// and partial maps are summed in a fixed order, so the map does not depend on the threads.
+// The heliostats are split into at most 64 groups with a partial map each,
+// fewer for large receivers so that the partial maps stay within 64 MB.
+class HELIOSTAT_TRACKING_EXPORT FluxTracer
+{
+public:
+    FluxTracer(int threads = 0);
+
+    // Threads used by trace, 0 uses all hardware threads
+    int get_threads() const { return m_pool->get_threads(); }
+    void set_threads(int threads);
+
+    // Facet width along the secondary axis and height across it, in meters
+    const vec2d& get_facetSize() const { return m_facetSize; }
+    void set_facetSize(const vec2d& facetSize) { m_facetSize = facetSize; }
+
+    double get_reflectivity() const { return m_reflectivity; }
+    void set_reflectivity(double reflectivity) { m_reflectivity = reflectivity; }
+
+    // Direct normal irradiance in W/m^2
+    double get_dni() const { return m_dni; }
+    void set_dni(double dni) { m_dni = dni; }
+
+    // Angular radius of the sun disk in radians
+    double get_sunRadius() const { return m_sunRadius; }
+    void set_sunRadius(double sunRadius) { m_sunRadius = sunRadius; }
+
+    // Standard deviation of the facet normal in radians
+    double get_slopeError() const { return m_slopeError; }
+    void set_slopeError(double slopeError) { m_slopeError = slopeError; }
+
+    std::uint64_t get_seed() const { return m_seed; }
+    void set_seed(std::uint64_t seed) { m_seed = seed; }
+
+    // Traces raysPerHeliostat rays for every heliostat of the field, vSun points to the sun.
+    // bvh, if given, must be built or refit for the current angles of the field.
+    // Throws std::invalid_argument for a receiver without bins or area or a tree of another field.
+    FluxMap trace(const HeliostatField& field, const vec3d& vSun, const FluxReceiver& receiver, std::size_t raysPerHeliostat,
+                  const FacetBVH* bvh = nullptr) const;
+
+private:
+    vec2d m_facetSize;
+    double m_reflectivity;
+    double m_dni;
+    double m_sunRadius;
+    double m_slopeError;
+    std::uint64_t m_seed;
+    std::unique_ptr<ThreadPool> m_pool;
+};
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "AffineTransform.h"
+#include "ThreadPool.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Collection of heliostats updated together for a common sun vector.
+// Armatures are not owned and may be shared by several heliostats,
+// they must outlive the field and must not be modified during update.
+// Locations are stored as AffineTransform, inline with their inverses.
+class HELIOSTAT_TRACKING_EXPORT HeliostatField
+{
+public:
+    HeliostatField(int threads = 0);
+
+    // returns the index of the new heliostat
+    std::size_t addHeliostat(const AffineTransform& location, TrackerArmature2A* armature, const TrackerTarget& target = TrackerTarget());
+    void clear();
+    // reserves memory for count heliostats
+    void reserve(std::size_t count);
+    std::size_t size() const { return m_locations.size(); }
+
+    const AffineTransform& get_location(std::size_t i) const { return m_locations[i]; }
+    // moves a heliostat, it is solved again by the next update
+    void set_location(std::size_t i, const AffineTransform& location);
+    TrackerArmature2A* get_armature(std::size_t i) const { return m_armatures[i]; }
+    const TrackerTarget& get_target(std::size_t i) const { return m_targets[i]; }
+    TrackerTarget& get_target(std::size_t i) { return m_targets[i]; }
+
+    // Threads used by update, 0 uses all hardware threads
+    int get_threads() const { return m_pool->get_threads(); }
+    void set_threads(int threads);
+
+    // Calls TrackerArmature2A::update for every heliostat, in parallel over the thread pool.
+    // The results are the same as for a serial loop.
+    void update(const vec3d& vSun);
+
+    // Incremental update: a heliostat is solved again only if the sun vector or its target
+    // changed enough since its last solve to turn the facet normal by more than tolerance (radians).
+    // For global aiming the normal bisects the sun and target directions, so it turns by about
+    // (dSun + dTarget)/(2 cos(incidence)) from the last solution. For local aiming the target
+    // turns with the facet and the normal turns by about dSun + dTarget.
+    // Heliostats without a solution, targets with a new aiming type, moved heliostats
+    // and armatures with a new geometry (see TrackerArmature2A::get_generation) are always solved.
+    // Returns the number of heliostats skipped.
+    std::size_t update(const vec3d& vSun, double tolerance);
+
+    // Heliostats skipped by the last update, 0 after a full update
+    std::size_t get_skipped() const { return m_skipped; }
+
+    // Angles in degrees from the last update, interleaved per heliostat (size 2*size())
+    const std::vector<double>& get_angles() const { return m_angles; }
+    vec2d get_angles(std::size_t i) const { return vec2d(m_angles[2*i], m_angles[2*i + 1]); }
+
+private:
+    // what the last solve of a heliostat depended on
+    struct SolveState
+    {
+        bool valid;
+        std::uint64_t generation; // of the armature
+        vec3d vSun; // unit sun vector
+        TrackerTarget::AimingType aimingType;
+        vec3d aimingPoint;
+        double distanceInv; // 1/distance from the facet to the aiming point
+        double sensitivity; // turn of the normal per turn of the sun or target direction
+    };
+
+    void solve(std::size_t i, const vec3d& vSun);
+    bool isSolved(std::size_t i, const vec3d& vSun, double tolerance) const;
+
+    std::vector<AffineTransform> m_locations;
+    std::vector<TrackerArmature2A*> m_armatures;
+    std::vector<TrackerTarget> m_targets;
+    std::vector<double> m_angles;
+    std::vector<SolveState> m_states;
+    std::size_t m_skipped;
+    std::unique_ptr<ThreadPool> m_pool;
+};
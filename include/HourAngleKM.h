@@ -1,13 +1,15 @@
 #pragma once
 
 #include <cmath>  // For std::cos, std::sqrt, std::asin, and std::acos
+#include <cstddef>
 #include "heliostat_tracking_export.h"
+#include "PiecewiseChebyshev.h"
 
 class HELIOSTAT_TRACKING_EXPORT HourAngleKM
 {
     public:
         HourAngleKM(double gamma, double rab, double rbc, double rad, double offset)
-            : m_gamma(gamma), m_rab(rab), m_rbc(rbc), m_rad(rad), m_offset(offset) { }
+            : m_gamma(gamma), m_rab(rab), m_rbc(rbc), m_rad(rad), m_offset(offset) { onModified(); }
 
          ~HourAngleKM() = default;
 
@@ -19,20 +21,43 @@ class HELIOSTAT_TRACKING_EXPORT HourAngleKM
         double get_offset() const { return m_offset; }
 
         // Setter functions
-        void set_gamma(double gamma) { m_gamma = gamma; }
-        void set_rab(double rab) { m_rab = rab; }
-        void set_rbc(double rbc) { m_rbc = rbc; }
-        void set_rad(double rad) { m_rad = rad; }
-        void set_offset(double offset) { m_offset = offset; }
+        void set_gamma(double gamma) { m_gamma = gamma; onModified(); }
+        void set_rab(double rab) { m_rab = rab; onModified(); }
+        void set_rbc(double rbc) { m_rbc = rbc; onModified(); }
+        void set_rad(double rad) { m_rad = rad; onModified(); }
+        void set_offset(double offset) { m_offset = offset; onModified(); }
 
         // Additional functions for calculation
         double getActuatorLengthFromHourAngle(double hour_angle) const;
         double getHourAngleFromActuatorLength(double actuator_length) const;
 
+        // Batch versions over count values, NaN for out-of-range inputs
+        void getActuatorLengthsFromHourAngles(std::size_t count, const double* angles, double* lengths) const;
+        void getHourAnglesFromActuatorLengths(std::size_t count, const double* lengths, double* angles) const;
+
+        // Polynomial fast path over a range of angles, without transcendental calls.
+        // Once set, the conversions use it for inputs inside its range, it is rebuilt by the setters.
+        // The tolerances are met at test points with a margin, see PiecewiseChebyshev.
+        // Throws if the tolerances cannot be met, e.g. if the length is not monotonic in the range.
+        void setApproximation(const Interval& angles, double lengthTolerance = 1e-7, double angleTolerance = 1e-7);
+        void clearApproximation();
+        bool hasApproximation() const { return !m_approximation.isEmpty(); }
+        const PiecewiseChebyshev& get_lengthApproximation() const { return m_approximation.get_function(); }
+        const PiecewiseChebyshev& get_angleApproximation() const { return m_approximation.get_inverse(); }
+
     private:
+        void onModified();
+        double findActuatorLength(double hour_angle) const;
+        double findHourAngle(double actuator_length) const;
+
         double m_gamma; // Angle between the line AB and the vertical plane that contains Axis 1 and is oriented in the North – South direction
         double m_rab; // Minimum, i.e., perpendicular, distance between Axis 1 and Axis 3
         double m_rbc; // Minimum, i.e., perpendicular, distance between Axis 3 and the plane containing Axis 2 and the axis of the actuator
         double m_rad; // Minimum, i.e., perpendicular, distance between Axis 1 and Axis 2
         double m_offset;  // Extension offset.
-};
\ No newline at end of file
+
+        double m_c0; // rab^2 + rad^2 - rbc^2
+        double m_c1; // 2*rab*rad
+
+        PiecewiseChebyshevPair m_approximation; // lengths from angles and angles from lengths
+};
@@ -5,27 +5,46 @@
 
 #include "heliostat_tracking_export.h"
 
-class HELIOSTAT_TRACKING_EXPORT Matrix4x4
+// 4x4 matrix templated on the scalar type, Matrix4x4 and Matrix4x4f are the double and float versions
+template<class T>
+class HELIOSTAT_TRACKING_EXPORT Matrix4x4T
 {
 public:
-    Matrix4x4();
-    Matrix4x4(double t00, double t01, double t02, double t03,
-              double t10, double t11, double t12, double t13,
-              double t20, double t21, double t22, double t23,
-              double t30, double t31, double t32, double t33);
-    Matrix4x4(double array[4][4]);
-    Matrix4x4(const Matrix4x4& rhs);
+    Matrix4x4T();
+    Matrix4x4T(T t00, T t01, T t02, T t03,
+               T t10, T t11, T t12, T t13,
+               T t20, T t21, T t22, T t23,
+               T t30, T t31, T t32, T t33);
+    Matrix4x4T(T array[4][4]);
+    Matrix4x4T(const Matrix4x4T& rhs);
 
-    bool operator==(const Matrix4x4& matrix) const;
+    // conversion from the other precision
+    template<class U>
+    explicit Matrix4x4T(const Matrix4x4T<U>& rhs)
+    {
+        for (int i = 0; i < 4; ++i)
+            for (int j = 0; j < 4; ++j)
+                m[i][j] = T(rhs.m[i][j]);
+    }
 
-    std::shared_ptr<Matrix4x4> transposed() const;
-    std::shared_ptr<Matrix4x4> inversed() const;
+    bool operator==(const Matrix4x4T& matrix) const;
 
-    double determinant() const;
+    std::shared_ptr<Matrix4x4T> transposed() const;
+    std::shared_ptr<Matrix4x4T> inversed() const;
 
+    T determinant() const;
 
-    double m[4][4];
+
+    T m[4][4];
 };
 
-HELIOSTAT_TRACKING_EXPORT std::shared_ptr<Matrix4x4> multiply(const Matrix4x4& m1, const Matrix4x4& m2);
-HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const Matrix4x4& matrix);
+template<class T>
+HELIOSTAT_TRACKING_EXPORT std::shared_ptr<Matrix4x4T<T>> multiply(const Matrix4x4T<T>& m1, const Matrix4x4T<T>& m2);
+template<class T>
+HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const Matrix4x4T<T>& matrix);
+
+typedef Matrix4x4T<double> Matrix4x4;
+typedef Matrix4x4T<float> Matrix4x4f;
+
+extern template class Matrix4x4T<double>;
+extern template class Matrix4x4T<float>;
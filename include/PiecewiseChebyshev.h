@@ -0,0 +1,83 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "Interval.h"
+
+// Piecewise polynomial approximation of a smooth function over an interval.
+// The interval is split into uniform segments, each with a Chebyshev interpolant
+// stored as monomials in t = [-1, 1], so that an evaluation is an index
+// computation and Horner's scheme, without transcendental calls.
+class HELIOSTAT_TRACKING_EXPORT PiecewiseChebyshev
+{
+public:
+    PiecewiseChebyshev();
+
+    // Segments are doubled until the error at 8*(degree + 1) test points per segment is below tolerance/2.
+    // The error is only estimated at these points, the margin of 2 covers the error between them.
+    // Throws std::runtime_error if this needs more than segmentsMax segments.
+    PiecewiseChebyshev(const std::function<double(double)>& f, const Interval& interval,
+                       double tolerance, int degree = 6, int segmentsMax = 4096);
+
+    bool isEmpty() const {return m_segments == 0;}
+    bool isInside(double x) const {return m_interval.isInside(x);}
+
+    const Interval& get_interval() const {return m_interval;}
+    int get_degree() const {return m_degree;}
+    int get_segments() const {return m_segments;}
+    double get_error() const {return m_error;} // largest error found at the test points, an estimate
+
+    // x is clamped to the interval
+    double operator()(double x) const
+    {
+        double u = (x - m_interval.min())*m_scale;
+        int n = int(u);
+        if (n < 0) n = 0;
+        else if (n >= m_segments) n = m_segments - 1;
+        double t = 2.*(u - n) - 1.;
+        const double* c = &m_coefficients[n*(m_degree + 1)];
+        double ans = c[0];
+        for (int k = 1; k <= m_degree; ++k)
+            ans = ans*t + c[k];
+        return ans;
+    }
+
+protected:
+    void fit(const std::function<double(double)>& f);
+    double findError(const std::function<double(double)>& f) const;
+
+    Interval m_interval;
+    int m_degree;
+    int m_segments;
+    double m_scale; // segments per unit of x
+    double m_error;
+    std::vector<double> m_coefficients; // m_degree + 1 per segment, highest power first
+};
+
+// Approximations of a monotonic function over an interval and of its inverse over the range
+// of the function, e.g. for the two directions of an actuator kinematic model.
+class HELIOSTAT_TRACKING_EXPORT PiecewiseChebyshevPair
+{
+public:
+    PiecewiseChebyshevPair();
+
+    // The range of f is found at 1025 points of the interval.
+    // Throws as PiecewiseChebyshev if a tolerance cannot be met, the pair is then empty.
+    void fit(const std::function<double(double)>& f, const std::function<double(double)>& inverse,
+             const Interval& interval, double tolerance, double inverseTolerance);
+    // fits the new functions over the same interval and with the same tolerances, if not empty
+    void refit(const std::function<double(double)>& f, const std::function<double(double)>& inverse);
+    void clear();
+
+    bool isEmpty() const {return m_function.isEmpty();}
+    const PiecewiseChebyshev& get_function() const {return m_function;}
+    const PiecewiseChebyshev& get_inverse() const {return m_inverse;}
+
+protected:
+    PiecewiseChebyshev m_function;
+    PiecewiseChebyshev m_inverse;
+    double m_tolerance;
+    double m_inverseTolerance;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "heliostat_tracking_export.h"
+#include "gcf.h"
+#include "Ray.h"
+
+// Rays in structure-of-arrays layout for the packet traversal kernels,
+// one AVX2 register holds a component of all the lanes.
+// Lanes from count up to Width are inactive.
+struct HELIOSTAT_TRACKING_EXPORT RayPacket
+{
+    static constexpr int Width = 4;
+
+    RayPacket(): count(0) {}
+
+    RayPacket(const Ray* rays, int count): count(0)
+    {
+        for (int i = 0; i < count; ++i)
+            add(rays[i]);
+    }
+
+    // appends a lane, count must be below Width
+    void add(const Ray& ray) { set(count++, ray); }
+
+    void set(int lane, const Ray& ray)
+    {
+        ox[lane] = ray.origin.x;
+        oy[lane] = ray.origin.y;
+        oz[lane] = ray.origin.z;
+        dx[lane] = ray.direction().x;
+        dy[lane] = ray.direction().y;
+        dz[lane] = ray.direction().z;
+        ix[lane] = ray.invDirection().x;
+        iy[lane] = ray.invDirection().y;
+        iz[lane] = ray.invDirection().z;
+        tMin[lane] = ray.tMin;
+        tMax[lane] = ray.tMax;
+    }
+
+    Ray ray(int lane) const
+    {
+        return Ray(vec3d(ox[lane], oy[lane], oz[lane]), vec3d(dx[lane], dy[lane], dz[lane]), tMin[lane], tMax[lane]);
+    }
+
+    alignas(32) double ox[Width] = {};
+    alignas(32) double oy[Width] = {};
+    alignas(32) double oz[Width] = {};
+    alignas(32) double dx[Width] = {};
+    alignas(32) double dy[Width] = {};
+    alignas(32) double dz[Width] = {};
+    alignas(32) double ix[Width] = {}; // 1/dx
+    alignas(32) double iy[Width] = {};
+    alignas(32) double iz[Width] = {};
+    alignas(32) double tMin[Width] = {};
+    alignas(32) double tMax[Width] = {};
+    int count;
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "heliostat_tracking_export.h"
+#include "ArrayView.h"
+#include "vec3d.h"
+
+// Header of the simulation result file, in native byte order.
+// The header is followed by chunks of chunkSteps time steps (the last one may be shorter).
+// A chunk of n steps holds, each block padded to 8 bytes:
+//   double times[n] (Unix seconds)
+//   double sunVectors[3*n] (interleaved, in the field frame)
+//   float column[n*heliostats] for each column, step by step
+// Every chunk but the last takes chunkBytes(chunkSteps) bytes, so chunk k starts at
+// sizeof(SimulationFileHeader) + k*chunkBytes(chunkSteps).
+// Steps with the sun below the horizon hold NaN.
+struct HELIOSTAT_TRACKING_EXPORT SimulationFileHeader
+{
+    enum Column {
+        primaryAngle, // degrees
+        secondaryAngle, // degrees
+        elevationLength, // actuator length of the primary angle, meters
+        hourLength // actuator length of the secondary angle, meters
+    };
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t columns; // 2 for the angles only, 4 with the actuator lengths
+    std::uint64_t heliostats;
+    std::uint64_t steps;
+    std::uint64_t chunkSteps;
+    double timeStart;
+    double step;
+    double longitude;
+    double latitude;
+
+    std::uint64_t chunks() const { return chunkSteps == 0 ? 0 : (steps + chunkSteps - 1)/chunkSteps; }
+    // steps of chunk k, chunkSteps but for the last chunk
+    std::uint64_t chunkSize(std::uint64_t k) const { return k + 1 < chunks() ? chunkSteps : steps - k*chunkSteps; }
+    std::uint64_t chunkBytes(std::uint64_t n) const;
+    std::uint64_t chunkOffset(std::uint64_t k) const { return sizeof(SimulationFileHeader) + k*chunkBytes(chunkSteps); }
+    std::uint64_t fileBytes() const;
+    bool isValid() const;
+
+    static const char Magic[8];
+    static constexpr std::uint32_t Version = 1;
+};
+
+// Simulation result file mapped in memory.
+// create preallocates the file for the layout of a header and maps it for writing,
+// open maps an existing file, so the results are read in place without copies:
+// a column at a step is a contiguous array with one value per heliostat,
+// and the angles of a step form the structure-of-arrays view of the batch solvers.
+// The accessors require an open store. The non-const ones, which return writable pointers,
+// throw std::logic_error on a read-only store: read it through a const reference.
+// The pointers stay valid until the store is closed or destroyed.
+class HELIOSTAT_TRACKING_EXPORT ResultStore
+{
+public:
+    static constexpr std::uint64_t npos = std::uint64_t(-1);
+
+    ResultStore();
+    ~ResultStore();
+    ResultStore(ResultStore&& other) noexcept;
+    ResultStore& operator=(ResultStore&& other) noexcept;
+    ResultStore(const ResultStore&) = delete;
+    ResultStore& operator=(const ResultStore&) = delete;
+
+    // Creates fileName with the size of the layout in header, the data is zero until written.
+    // Throws std::invalid_argument for an invalid header and std::runtime_error if the file cannot be created.
+    void create(const std::string& fileName, const SimulationFileHeader& header);
+    // Maps fileName, read-only unless writable.
+    // Throws std::runtime_error if the file cannot be mapped or is not a valid result file.
+    void open(const std::string& fileName, bool writable = false);
+    // Writes the modified pages to the file, throws std::runtime_error on failure
+    void flush();
+    // Unmaps the file, called by the destructor (which ignores flush errors)
+    void close();
+
+    bool isOpen() const { return m_data != nullptr; }
+    bool isWritable() const { return m_writable; }
+    const SimulationFileHeader& get_header() const { return *reinterpret_cast<const SimulationFileHeader*>(m_data); }
+    std::uint64_t heliostats() const { return get_header().heliostats; }
+    std::uint64_t steps() const { return get_header().steps; }
+    std::uint64_t chunks() const { return get_header().chunks(); }
+
+    // step of a time, rounded to the nearest step, npos outside the time range
+    std::uint64_t findStep(double time) const;
+    // Throw std::out_of_range for a step not in the file
+    double get_time(std::uint64_t step) const;
+    vec3d get_sunVector(std::uint64_t step) const;
+
+    // Blocks of chunk k, see SimulationFileHeader.
+    // Throw std::out_of_range for a chunk or a column not in the file.
+    const double* times(std::uint64_t k) const { return reinterpret_cast<const double*>(chunk(k)); }
+    double* times(std::uint64_t k);
+    const double* sunVectors(std::uint64_t k) const;
+    double* sunVectors(std::uint64_t k);
+    // column c of the steps of chunk k, step by step
+    const float* column(std::uint64_t k, SimulationFileHeader::Column c) const;
+    float* column(std::uint64_t k, SimulationFileHeader::Column c);
+
+    // column c at a step, one value per heliostat, throw std::out_of_range for a step not in the file
+    const float* values(std::uint64_t step, SimulationFileHeader::Column c) const;
+    float* values(std::uint64_t step, SimulationFileHeader::Column c);
+    // primary and secondary angles at a step, as written by the batch solvers
+    vec2ArrayView<const float> angles(std::uint64_t step) const;
+    vec2fArrayView angles(std::uint64_t step);
+
+private:
+    void checkStep(std::uint64_t step) const;
+    void checkWritable() const;
+    const char* chunk(std::uint64_t k) const;
+    std::uint64_t columnOffset(std::uint64_t k, SimulationFileHeader::Column c) const;
+    // maps the whole file, create resizes it to size first
+    void map(const std::string& fileName, std::uint64_t size, bool writable, bool create);
+
+    char* m_data;
+    std::uint64_t m_size;
+    bool m_writable;
+};
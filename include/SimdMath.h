@@ -0,0 +1,251 @@
+#pragma once
+
+#include "heliostat_tracking_export.h"
+#include "gcf.h"
+
+// SIMD helpers for the batch kernels of the library.
+// AVX2 code is compiled with function-level target attributes and selected at run time
+// with simd::hasAVX2(), so the library keeps working on CPUs without AVX2.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define HELIOSTAT_TRACKING_SIMD_X86 1
+#include <immintrin.h>
+#else
+#define HELIOSTAT_TRACKING_SIMD_X86 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define HELIOSTAT_TRACKING_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define HELIOSTAT_TRACKING_TARGET_AVX2
+#endif
+
+namespace simd
+{
+    // true if the CPU and the operating system support AVX2 and the AVX2 kernels are enabled
+    HELIOSTAT_TRACKING_EXPORT bool hasAVX2();
+    // enabled by default, disabling selects the scalar paths (e.g. to test them on AVX2 hosts)
+    HELIOSTAT_TRACKING_EXPORT void enableAVX2(bool enabled);
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+
+    // atan for x in [0, 1], Cephes rational approximation
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d atanUnit(__m256d x)
+    {
+        const __m256d one = _mm256_set1_pd(1.);
+        __m256d big = _mm256_cmp_pd(x, _mm256_set1_pd(0.66), _CMP_GT_OQ);
+        __m256d xr = _mm256_blendv_pd(x, _mm256_div_pd(_mm256_sub_pd(x, one), _mm256_add_pd(x, one)), big);
+        __m256d y0 = _mm256_and_pd(big, _mm256_set1_pd(gcf::Pi/4.));
+        __m256d more = _mm256_and_pd(big, _mm256_set1_pd(0.5*6.123233995736765886130e-17));
+
+        __m256d z = _mm256_mul_pd(xr, xr);
+        __m256d p = _mm256_set1_pd(-8.750608600031904122785e-1);
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-1.615753718733365076637e1));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-7.500855792314704667340e1));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-1.228866684490136173410e2));
+        p = _mm256_add_pd(_mm256_mul_pd(p, z), _mm256_set1_pd(-6.485021904942025371773e1));
+        __m256d q = _mm256_add_pd(z, _mm256_set1_pd(2.485846490142306297962e1));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(1.650270098316988542046e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(4.328810604912902668951e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(4.853903996359136964868e2));
+        q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(1.945506571482613964425e2));
+
+        __m256d r = _mm256_add_pd(_mm256_mul_pd(xr, _mm256_div_pd(_mm256_mul_pd(z, p), q)), xr);
+        return _mm256_add_pd(y0, _mm256_add_pd(r, more));
+    }
+
+    // four-lane std::atan2, atan2(0, 0) = 0
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d atan2(__m256d y, __m256d x)
+    {
+        const __m256d signMask = _mm256_set1_pd(-0.);
+        const __m256d zero = _mm256_setzero_pd();
+        __m256d ax = _mm256_andnot_pd(signMask, x);
+        __m256d ay = _mm256_andnot_pd(signMask, y);
+        __m256d mx = _mm256_max_pd(ax, ay);
+        __m256d mn = _mm256_min_pd(ax, ay);
+        __m256d t = _mm256_div_pd(mn, mx);
+        t = _mm256_blendv_pd(t, zero, _mm256_cmp_pd(mx, zero, _CMP_EQ_OQ));
+
+        __m256d a = atanUnit(t);
+        a = _mm256_blendv_pd(a, _mm256_sub_pd(_mm256_set1_pd(gcf::Pi/2.), a), _mm256_cmp_pd(ay, ax, _CMP_GT_OQ));
+        a = _mm256_blendv_pd(a, _mm256_sub_pd(_mm256_set1_pd(gcf::Pi), a), _mm256_cmp_pd(x, zero, _CMP_LT_OQ));
+        return _mm256_xor_pd(a, _mm256_and_pd(signMask, y));
+    }
+
+    // atan for x in [0, 1], Cephes single precision polynomial
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256 atanUnit(__m256 x)
+    {
+        const __m256 one = _mm256_set1_ps(1.f);
+        __m256 big = _mm256_cmp_ps(x, _mm256_set1_ps(0.4142135623730950f), _CMP_GT_OQ);
+        __m256 xr = _mm256_blendv_ps(x, _mm256_div_ps(_mm256_sub_ps(x, one), _mm256_add_ps(x, one)), big);
+        __m256 y0 = _mm256_and_ps(big, _mm256_set1_ps(float(gcf::Pi/4.)));
+
+        __m256 z = _mm256_mul_ps(xr, xr);
+        __m256 p = _mm256_set1_ps(8.05374449538e-2f);
+        p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.38776856032e-1f));
+        p = _mm256_add_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(1.99777106478e-1f));
+        p = _mm256_sub_ps(_mm256_mul_ps(p, z), _mm256_set1_ps(3.33329491539e-1f));
+        p = _mm256_mul_ps(_mm256_mul_ps(p, z), xr);
+        return _mm256_add_ps(y0, _mm256_add_ps(p, xr));
+    }
+
+    // eight-lane std::atan2 in single precision, atan2(0, 0) = 0
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256 atan2(__m256 y, __m256 x)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.f);
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 ax = _mm256_andnot_ps(signMask, x);
+        __m256 ay = _mm256_andnot_ps(signMask, y);
+        __m256 mx = _mm256_max_ps(ax, ay);
+        __m256 mn = _mm256_min_ps(ax, ay);
+        __m256 t = _mm256_div_ps(mn, mx);
+        t = _mm256_blendv_ps(t, zero, _mm256_cmp_ps(mx, zero, _CMP_EQ_OQ));
+
+        __m256 a = atanUnit(t);
+        a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(float(gcf::Pi/2.)), a), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+        a = _mm256_blendv_ps(a, _mm256_sub_ps(_mm256_set1_ps(float(gcf::Pi)), a), _mm256_cmp_ps(x, zero, _CMP_LT_OQ));
+        return _mm256_xor_ps(a, _mm256_and_ps(signMask, y));
+    }
+
+    // p[0]*x^(n-1) + ... + p[n-1], Horner's scheme
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d polynomial(__m256d x, const double* p, int n)
+    {
+        __m256d ans = _mm256_set1_pd(p[0]);
+        for (int i = 1; i < n; ++i)
+            ans = _mm256_add_pd(_mm256_mul_pd(ans, x), _mm256_set1_pd(p[i]));
+        return ans;
+    }
+
+    // x^n + p[0]*x^(n-1) + ... + p[n-1]
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d polynomial1(__m256d x, const double* p, int n)
+    {
+        __m256d ans = _mm256_add_pd(x, _mm256_set1_pd(p[0]));
+        for (int i = 1; i < n; ++i)
+            ans = _mm256_add_pd(_mm256_mul_pd(ans, x), _mm256_set1_pd(p[i]));
+        return ans;
+    }
+
+    // Cephes sin and cos, for |x| up to about 1e8.
+    // The argument is reduced to [-pi/4, pi/4] by octants j, each of the results
+    // uses the sine or the cosine polynomial with a sign depending on j.
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline void sinCosReduce(__m256d x, __m256d& z, __m128i& j)
+    {
+        __m256d y = _mm256_floor_pd(_mm256_mul_pd(x, _mm256_set1_pd(4./gcf::Pi)));
+        j = _mm256_cvttpd_epi32(y);
+        __m128i odd = _mm_and_si128(j, _mm_set1_epi32(1));
+        j = _mm_add_epi32(j, odd); // even octants
+        y = _mm256_cvtepi32_pd(j);
+        z = _mm256_sub_pd(x, _mm256_mul_pd(y, _mm256_set1_pd(7.85398125648498535156e-1)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(3.77489470793079817668e-8)));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, _mm256_set1_pd(2.69515142907905952645e-15)));
+    }
+
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d sinPolynomial(__m256d z)
+    {
+        static const double sinCoefficients[] = {
+            1.58962301576546568060e-10, -2.50507477628578072866e-8, 2.75573136213857245213e-6,
+            -1.98412698295895385996e-4, 8.33333333332211858878e-3, -1.66666666666666307295e-1
+        };
+        __m256d zz = _mm256_mul_pd(z, z);
+        return _mm256_add_pd(z, _mm256_mul_pd(_mm256_mul_pd(z, zz), polynomial(zz, sinCoefficients, 6)));
+    }
+
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d cosPolynomial(__m256d z)
+    {
+        static const double cosCoefficients[] = {
+            -1.13585365213876817300e-11, 2.08757008419747316778e-9, -2.75573141792967388112e-7,
+            2.48015872888517045348e-5, -1.38888888888730564116e-3, 4.16666666666665929218e-2
+        };
+        __m256d zz = _mm256_mul_pd(z, z);
+        __m256d ans = _mm256_sub_pd(_mm256_set1_pd(1.), _mm256_mul_pd(_mm256_set1_pd(0.5), zz));
+        return _mm256_add_pd(ans, _mm256_mul_pd(_mm256_mul_pd(zz, zz), polynomial(zz, cosCoefficients, 6)));
+    }
+
+    // lanes with the given bit of j set, as a mask of all ones
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d octantMask(__m128i j, int bit)
+    {
+        __m256i b = _mm256_and_si256(_mm256_cvtepi32_epi64(j), _mm256_set1_epi64x(bit));
+        return _mm256_castsi256_pd(_mm256_cmpeq_epi64(b, _mm256_set1_epi64x(bit)));
+    }
+
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d sin(__m256d x)
+    {
+        const __m256d signMask = _mm256_set1_pd(-0.);
+        __m256d sign = _mm256_and_pd(x, signMask);
+        __m256d z;
+        __m128i j;
+        sinCosReduce(_mm256_andnot_pd(signMask, x), z, j);
+        __m256d ans = _mm256_blendv_pd(sinPolynomial(z), cosPolynomial(z), octantMask(j, 2));
+        sign = _mm256_xor_pd(sign, _mm256_and_pd(octantMask(j, 4), signMask));
+        return _mm256_xor_pd(ans, sign);
+    }
+
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d cos(__m256d x)
+    {
+        const __m256d signMask = _mm256_set1_pd(-0.);
+        __m256d z;
+        __m128i j;
+        sinCosReduce(_mm256_andnot_pd(signMask, x), z, j);
+        __m256d second = octantMask(j, 2);
+        __m256d ans = _mm256_blendv_pd(cosPolynomial(z), sinPolynomial(z), second);
+        __m256d sign = _mm256_xor_pd(_mm256_and_pd(octantMask(j, 4), signMask), _mm256_and_pd(second, signMask));
+        return _mm256_xor_pd(ans, sign);
+    }
+
+    // Cephes asin, NaN outside [-1, 1]
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d asin(__m256d x)
+    {
+        static const double p[] = {
+            4.253011369004428248960e-3, -6.019598008014123785661e-1, 5.444622390564711410273e0,
+            -1.626247967210700244449e1, 1.956261983317594739197e1, -8.198089802484824371615e0
+        };
+        static const double q[] = {
+            -1.474091372988853791896e1, 7.049610280856842141659e1, -1.471791292232726029859e2,
+            1.395105614657485689735e2, -4.918853881490881290097e1
+        };
+        static const double r[] = {
+            2.967721961301243206100e-3, -5.634242780008963776856e-1, 6.968710824104713396794e0,
+            -2.556901049652824852289e1, 2.853665548261061424989e1
+        };
+        static const double s[] = {
+            -2.194779531642920639778e1, 1.470656354026814941758e2, -3.838770957603691357202e2,
+            3.424398657913078477438e2
+        };
+        const __m256d signMask = _mm256_set1_pd(-0.);
+        const __m256d pio4 = _mm256_set1_pd(gcf::Pi/4.);
+        __m256d a = _mm256_andnot_pd(signMask, x);
+
+        // |x| <= 0.625
+        __m256d z = _mm256_mul_pd(a, a);
+        __m256d small = _mm256_div_pd(_mm256_mul_pd(z, polynomial(z, p, 6)), polynomial1(z, q, 5));
+        small = _mm256_add_pd(_mm256_mul_pd(a, small), a);
+
+        // |x| > 0.625
+        __m256d zz = _mm256_sub_pd(_mm256_set1_pd(1.), a);
+        __m256d pr = _mm256_div_pd(_mm256_mul_pd(zz, polynomial(zz, r, 5)), polynomial1(zz, s, 4));
+        zz = _mm256_sqrt_pd(_mm256_add_pd(zz, zz));
+        __m256d big = _mm256_sub_pd(pio4, zz);
+        zz = _mm256_sub_pd(_mm256_mul_pd(zz, pr), _mm256_set1_pd(6.123233995736765886130e-17));
+        big = _mm256_add_pd(_mm256_sub_pd(big, zz), pio4);
+
+        __m256d ans = _mm256_blendv_pd(small, big, _mm256_cmp_pd(a, _mm256_set1_pd(0.625), _CMP_GT_OQ));
+        ans = _mm256_or_pd(ans, _mm256_and_pd(x, signMask));
+        return _mm256_or_pd(ans, _mm256_cmp_pd(a, _mm256_set1_pd(1.), _CMP_NLE_UQ)); // NaN outside the domain
+    }
+
+    // Cephes acos, NaN outside [-1, 1]
+    HELIOSTAT_TRACKING_TARGET_AVX2 inline __m256d acos(__m256d x)
+    {
+        const __m256d half = _mm256_set1_pd(0.5);
+        const __m256d pio4 = _mm256_set1_pd(gcf::Pi/4.);
+        // x > 0.5 uses 2*asin(sqrt((1 - x)/2)), a single asin for both branches
+        __m256d big = _mm256_cmp_pd(x, half, _CMP_GT_OQ);
+        __m256d a = asin(_mm256_blendv_pd(x, _mm256_sqrt_pd(_mm256_sub_pd(half, _mm256_mul_pd(half, x))), big));
+        __m256d ans = _mm256_sub_pd(pio4, a);
+        ans = _mm256_add_pd(_mm256_add_pd(ans, _mm256_set1_pd(6.123233995736765886130e-17)), pio4);
+        ans = _mm256_blendv_pd(ans, _mm256_add_pd(a, a), big);
+        return _mm256_or_pd(ans, _mm256_cmp_pd(_mm256_andnot_pd(_mm256_set1_pd(-0.), x), _mm256_set1_pd(1.), _CMP_NLE_UQ));
+    }
+
+#endif
+}
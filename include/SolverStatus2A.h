@@ -0,0 +1,17 @@
+#pragma once
+
+// Outcome of a global aiming solve of TrackerSolver2A
+struct SolverStatus2A
+{
+    enum Convergence {
+        converged, // every solution branch reached the tolerance
+        notConverged, // a branch ran out of iterations or hit a singular Jacobian
+        noSolution // the required facet normal cannot be reached by the armature
+    };
+
+    SolverStatus2A(int iterations = 0, Convergence convergence = noSolution):
+        iterations(iterations), convergence(convergence) {}
+
+    int iterations;
+    Convergence convergence;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+#include "SunPositionEngine.h"
+#include "vec3d.h"
+
+// Table of sun vectors of a SunPositionEngine sampled at a fixed time step,
+// stored in single precision and interpolated with uniform Catmull-Rom splines.
+// The spline error grows with the cube of the step: over a year at any latitude
+// the angular error is below 1e-7 rad (0.02 arcsec) for a 60 s step,
+// 3e-7 rad for 300 s and 2e-6 rad for 600 s.
+// findMaxError measures the actual bound of a table.
+// findSunVectors interpolates 4 times at once with AVX2 when available
+// and gives the same vectors as findSunVector.
+// load checks the header against the samples and the file size.
+class HELIOSTAT_TRACKING_EXPORT SunEphemeris
+{
+public:
+    SunEphemeris();
+    // covers the times [timeStart, timeEnd] in Unix seconds, step in seconds
+    SunEphemeris(const SunPositionEngine& engine, double timeStart, double timeEnd, double step = 60.);
+
+    // table for a calendar year in UTC
+    static SunEphemeris forYear(const SunPositionEngine& engine, int year, double step = 60.);
+
+    double get_longitude() const { return m_longitude; }
+    double get_latitude() const { return m_latitude; }
+    double get_timeStart() const { return m_timeStart; }
+    double get_timeEnd() const { return m_timeEnd; }
+    double get_step() const { return m_step; }
+    std::size_t get_samples() const { return m_data.size()/3; }
+
+    bool contains(double time) const { return !m_data.empty() && m_timeStart <= time && time <= m_timeEnd; }
+
+    // throws std::out_of_range for times outside the table
+    vec3d findSunVector(double time) const;
+    // vectors receives count interleaved sun vectors (count x 3)
+    void findSunVectors(std::size_t count, const double* times, double* vectors) const;
+
+    // largest angle in radians between the table and the engine,
+    // checked at samplesPerStep points in every step
+    double findMaxError(const SunPositionEngine& engine, int samplesPerStep = 4) const;
+
+    // Binary file with a small header followed by the samples, in native byte order.
+    // Throws std::runtime_error on failure.
+    void save(const std::string& fileName) const;
+    static SunEphemeris load(const std::string& fileName);
+
+private:
+    vec3d interpolate(double time) const;
+
+    double m_longitude;
+    double m_latitude;
+    double m_timeStart;
+    double m_timeEnd;
+    double m_step;
+    double m_stepInv;
+    std::vector<float> m_data; // x, y and z planes of the samples from timeStart - step to past timeEnd + step
+};
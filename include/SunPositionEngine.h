@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+
+#include "heliostat_tracking_export.h"
+#include "vec3d.h"
+
+// Sun position algorithm of the Plataforma Solar de Almeria (Blanco-Muriel et al., 2001),
+// evaluated for arrays of times.
+// Times are Unix timestamps in seconds (UTC), the location is given in radians
+// with longitude positive to the East and latitude positive to the North.
+// Sun vectors point to the sun in the frame used by TrackerArmature2A::update:
+// x to the East, y to the North and z to the zenith, the parallax correction included.
+class HELIOSTAT_TRACKING_EXPORT SunPositionEngine
+{
+public:
+    SunPositionEngine(double longitude = 0., double latitude = 0.);
+
+    double get_longitude() const { return m_longitude; }
+    double get_latitude() const { return m_latitude; }
+
+    void set_longitude(double longitude);
+    void set_latitude(double latitude);
+
+    vec3d findSunVector(double time) const;
+
+    // vectors receives count interleaved sun vectors (count x 3).
+    // 4 times at once with AVX2 when available, which agrees with findSunVector to about 1e-15.
+    void findSunVectors(std::size_t count, const double* times, double* vectors) const;
+
+    // Unix timestamp of a UTC calendar date (proleptic Gregorian calendar)
+    static double toUnixTime(int year, int month, int day, double hours = 0., double minutes = 0., double seconds = 0.);
+
+private:
+    double m_longitude;
+    double m_latitude;
+    double m_cosLatitude;
+    double m_sinLatitude;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "heliostat_tracking_export.h"
+
+// Fixed set of worker threads running one parallel loop at a time.
+// The calling thread takes part in the loop, so a pool of n threads starts n - 1 workers.
+class HELIOSTAT_TRACKING_EXPORT ThreadPool
+{
+public:
+    // threads = 0 uses std::thread::hardware_concurrency()
+    ThreadPool(int threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int get_threads() const { return int(m_workers.size()) + 1; }
+
+    // Calls function(begin, end) on contiguous chunks covering [0, count) and waits for all of them.
+    // Chunks hold at least grain elements. The first exception thrown by a chunk is rethrown here.
+    // Only one loop runs on the pool at a time: a call made while the pool is busy,
+    // from another thread or from inside a chunk, runs serially on the calling thread.
+    void parallelFor(std::size_t count, const std::function<void(std::size_t, std::size_t)>& function, std::size_t grain = 1);
+
+private:
+    void work();
+    void runChunks();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_loopMutex; // held by the thread running the current loop
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    bool m_stop;
+
+    // current loop, guarded by m_mutex
+    const std::function<void(std::size_t, std::size_t)>* m_function;
+    std::size_t m_count;
+    std::size_t m_chunk;
+    std::size_t m_next;
+    int m_busy;
+    unsigned int m_generation;
+    std::exception_ptr m_exception;
+};
@@ -1,17 +1,90 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
 #include "heliostat_tracking_export.h"
 #include "ArmatureJoint.h"
+#include "ArrayView.h"
+#include "TrackerTarget.h"
+
+template<class T> class TrackerSolver2AT;
+typedef TrackerSolver2AT<double> TrackerSolver2A;
+
+// Solver-ready data derived from the armature geometry in onModified.
+// Axes and normals are unit vectors, angles are in radians.
+// The float version is converted from the double one for the float solver.
+template<class T>
+struct CompiledArmature2AT
+{
+    CompiledArmature2AT() = default;
+
+    // conversion from the other precision
+    template<class U>
+    explicit CompiledArmature2AT(const CompiledArmature2AT<U>& c):
+        a(c.a), b(c.b), k(c.k), ab(T(c.ab)), k2Inv(T(c.k2Inv)), detInv(T(c.detInv)), degenerate(c.degenerate),
+        primaryShift(c.primaryShift), secondaryShift(c.secondaryShift), facetShift(c.facetShift), facetNormal(c.facetNormal),
+        primaryAngles(c.primaryAngles), secondaryAngles(c.secondaryAngles), angles0(c.angles0), facetPoint0(c.facetPoint0) {}
+
+    vec3<T> a; // primary axis
+    vec3<T> b; // secondary axis
+    vec3<T> k; // cross(a, b)
+    T ab; // dot(a, b)
+    T k2Inv; // 1/|k|^2
+    T detInv; // 1/(1 - ab^2)
+    bool degenerate; // parallel axes, solveRotation has no solutions
+
+    vec3<T> primaryShift;
+    vec3<T> secondaryShift;
+    vec3<T> facetShift;
+    vec3<T> facetNormal;
+
+    IntervalPeriodic primaryAngles;
+    IntervalPeriodic secondaryAngles;
+    vec2<T> angles0;
+    vec3<T> facetPoint0; // facet point at angles0
+};
+
+typedef CompiledArmature2AT<double> CompiledArmature2A;
+typedef CompiledArmature2AT<float> CompiledArmature2Af;
+
+// Geometry of a two-axis armature, in the units of the setters (angles in degrees).
+// get_geometry and set_geometry read and apply all the parameters at once.
+struct TrackerArmature2AGeometry
+{
+    vec3d primaryShift;
+    vec3d primaryAxis;
+    vec2d primaryAngles;
 
-struct vec3d;
-class TrackerTarget;
-class TrackerSolver2A;
+    vec3d secondaryShift;
+    vec3d secondaryAxis;
+    vec2d secondaryAngles;
 
+    vec3d facetShift;
+    vec3d facetNormal;
+
+    vec2d anglesDefault;
+};
+
+// The setters only mark the armature as modified, the derived state (joints and compiled armature)
+// is rebuilt once by compile, which the getters of the derived state and the solvers call.
+// A sequence of setters, or set_geometry, thus costs a single rebuild at the next use.
+// compile may run from several threads at once, the setters must not run concurrently with any use.
 class HELIOSTAT_TRACKING_EXPORT TrackerArmature2A
 {
 public:
+    typedef TrackerArmature2AGeometry Geometry;
+
     TrackerArmature2A();
+    // Armature with the whole geometry in the units of the setters, compiled once
+    TrackerArmature2A(const vec3d& primaryShift, const vec3d& primaryAxis, const vec2d& primaryAngles,
+                      const vec3d& secondaryShift, const vec3d& secondaryAxis, const vec2d& secondaryAngles,
+                      const vec3d& facetShift, const vec3d& facetNormal, const vec2d& anglesDefault = vec2d(0., 0.));
+    explicit TrackerArmature2A(const Geometry& geometry);
     ~TrackerArmature2A();
+    TrackerArmature2A(const TrackerArmature2A&) = delete;
+    TrackerArmature2A& operator=(const TrackerArmature2A&) = delete;
 
     // Getter functions
     const vec3d& get_primaryShift() const { return m_primaryShift; }
@@ -26,33 +99,54 @@ public:
     const vec3d& get_facetNormal() const { return m_facetNormal; }
 
     const vec2d& get_anglesDefault() const { return m_anglesDefault; }
-
-    const ArmatureJoint& get_primary() const { return m_primary; }
-    const ArmatureJoint& get_secondary() const { return m_secondary; }
-    const ArmatureVertex& get_facet() const { return m_facet; }
-    const vec2d& get_angles0() const { return m_angles0; }
+    Geometry get_geometry() const;
+
+    // derived state, rebuilt first if the armature was modified
+    const ArmatureJoint& get_primary() const { compile(); return m_primary; }
+    const ArmatureJoint& get_secondary() const { compile(); return m_secondary; }
+    const ArmatureVertex& get_facet() const { compile(); return m_facet; }
+    const vec2d& get_angles0() const { compile(); return m_angles0; }
+    const CompiledArmature2A& get_compiled() const { compile(); return m_compiled; }
+    const CompiledArmature2Af& get_compiledFloat() const { compile(); return m_compiledFloat; }
     TrackerSolver2A* const& get_solver() const { return m_solver; }
 
     // Setter functions
-    void set_primaryShift(vec3d primaryShift) { m_primaryShift = primaryShift; onModified(); }
-    void set_primaryAxis(vec3d primaryAxis) { m_primaryAxis = primaryAxis; onModified(); }
-    void set_primaryAngles(vec2d primaryAngles) { m_primaryAngles = primaryAngles; onModified(); }
+    void set_primaryShift(vec3d primaryShift) { m_primaryShift = primaryShift; setModified(); }
+    void set_primaryAxis(vec3d primaryAxis) { m_primaryAxis = primaryAxis; setModified(); }
+    void set_primaryAngles(vec2d primaryAngles) { m_primaryAngles = primaryAngles; setModified(); }
+
+    void set_secondaryShift(vec3d secondaryShift) { m_secondaryShift = secondaryShift; setModified(); }
+    void set_secondaryAxis(vec3d secondaryAxis) { m_secondaryAxis = secondaryAxis; setModified(); }
+    void set_secondaryAngles(vec2d secondaryAngles) { m_secondaryAngles = secondaryAngles; setModified(); }
 
-    void set_secondaryShift(vec3d secondaryShift) { m_secondaryShift = secondaryShift; onModified(); }
-    void set_secondaryAxis(vec3d secondaryAxis) { m_secondaryAxis = secondaryAxis; onModified(); }
-    void set_secondaryAngles(vec2d secondaryAngles) { m_secondaryAngles = secondaryAngles; onModified(); }
+    void set_facetShift(vec3d facetShift) { m_facetShift = facetShift; setModified(); }
+    void set_facetNormal(vec3d facetNormal) { m_facetNormal = facetNormal; setModified(); }
 
-    void set_facetShift(vec3d facetShift) { m_facetShift = facetShift; onModified(); }
-    void set_facetNormal(vec3d facetNormal) { m_facetNormal = facetNormal; onModified(); }
+    void set_anglesDefault(vec2d anglesDefault) { m_anglesDefault = anglesDefault; setModified(); }
+    void set_geometry(const Geometry& geometry);
 
-    void set_anglesDefault(vec2d anglesDefault) { m_anglesDefault = anglesDefault; onModified(); }
+    // incremented by every change of the geometry, to detect results of an older geometry
+    std::uint64_t get_generation() const { return m_generation; }
+    // true if the derived state is out of date
+    bool isModified() const { return m_modified.load(std::memory_order_acquire); }
+    // rebuilds the derived state if the armature was modified
+    void compile() const { if (isModified()) compileModified(); }
 
+    void update(const AffineTransform& toGlobal,
+                const vec3d& vSun, TrackerTarget* target);
     void update(const Transform& toGlobal,
                 const vec3d& vSun, TrackerTarget* target);
 
+    // Batch version of update for heliostats sharing this armature.
+    // vSun and rAim are given in the armature frame, angles are written in degrees.
+    void updateBatch(std::size_t count, const vec3dArrayView& vSun, const vec3dArrayView& rAim,
+                     TrackerTarget::AimingType aimingType, vec2dArrayView angles) const;
+
 
 protected:
-    void onModified();
+    void setModified() { ++m_generation; m_modified.store(true, std::memory_order_relaxed); }
+    void compileModified() const;
+    void onModified() const;
 
     vec3d m_primaryShift;
     vec3d m_primaryAxis;
@@ -67,10 +161,16 @@ protected:
 
     vec2d m_anglesDefault;
 
-    ArmatureJoint m_primary;
-    ArmatureJoint m_secondary;
-    ArmatureVertex m_facet;
-    vec2d m_angles0;
+    // derived state
+    mutable ArmatureJoint m_primary;
+    mutable ArmatureJoint m_secondary;
+    mutable ArmatureVertex m_facet;
+    mutable vec2d m_angles0;
+    mutable CompiledArmature2A m_compiled;
+    mutable CompiledArmature2Af m_compiledFloat;
+    mutable std::atomic<bool> m_modified;
+    std::uint64_t m_generation;
+    mutable std::mutex m_compileMutex;
 
     TrackerSolver2A* m_solver;
 
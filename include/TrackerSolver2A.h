@@ -4,22 +4,117 @@
 #include<vector>
 
 #include "heliostat_tracking_export.h"
+#include "ArrayView.h"
+#include "SolverStatus2A.h"
 #include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
 
 typedef vec2d Angles;
 
-class HELIOSTAT_TRACKING_EXPORT TrackerSolver2A
+// Fixed-capacity container for the at most two solutions of a two-axis tracker,
+// used by the allocation-free overloads of TrackerSolver2A.
+template<class T>
+struct Solutions2AT
+{
+    typedef vec2<T> Angles;
+
+    Solutions2AT(): count(0) {}
+
+    void push_back(const Angles& angles) {data[count++] = angles;}
+    void clear() {count = 0;}
+
+    bool empty() const {return count == 0;}
+    int size() const {return count;}
+
+    Angles& operator[](int i) {return data[i];}
+    const Angles& operator[](int i) const {return data[i];}
+
+    const Angles* begin() const {return data;}
+    const Angles* end() const {return data + count;}
+
+    std::vector<Angles> toVector() const {return std::vector<Angles>(begin(), end());}
+
+    Angles data[2];
+    int count;
+};
+
+typedef Solutions2AT<double> Solutions2A;
+typedef Solutions2AT<float> Solutions2Af;
+
+// Solver for the angles of a two-axis tracker, templated on the scalar type.
+// TrackerSolver2A and TrackerSolver2Af are the double and float versions,
+// the float version reads the float copy of the compiled armature.
+template<class T>
+class HELIOSTAT_TRACKING_EXPORT TrackerSolver2AT
 {
 public:
-    TrackerSolver2A(TrackerArmature2A* armature) : m_armature(armature) {}
+    typedef vec2<T> Angles;
+    typedef vec3<T> Vector;
+    typedef Solutions2AT<T> Solutions;
 
-    virtual std::vector<Angles> solveReflectionGlobal(const vec3d& vSun, const vec3d& rAim) const;
-    vec3d findFacetPoint(const Angles& angles) const;
-    std::vector<Angles> solveFacetNormal(const vec3d& normal) const;
-    std::vector<Angles> solveRotation(const vec3d& v0, const vec3d& v) const;
-    virtual std::vector<Angles> solveReflectionSecondary(const vec3d& vSun, const vec3d& rAim) const;
+    // Strategies for the global aiming problem
+    enum Method {
+        fixedPoint, // fixed-point iteration on the facet point, linear convergence
+        newton // Gauss-Newton on the angles with analytic Jacobians, quadratic convergence
+    };
+
+    TrackerSolver2AT(TrackerArmature2A* armature) :
+        m_armature(armature), m_method(fixedPoint), m_tolerance(0.001), m_iterationsMax(5) {}
+
+    // Settings of the global aiming solver.
+    // The tolerance is the distance in meters between the aiming point and the reflected ray.
+    Method get_method() const { return m_method; }
+    double get_tolerance() const { return m_tolerance; }
+    int get_iterationsMax() const { return m_iterationsMax; }
+
+    void set_method(Method method) { m_method = method; }
+    void set_tolerance(double tolerance) { m_tolerance = tolerance; }
+    void set_iterationsMax(int iterationsMax) { m_iterationsMax = iterationsMax; }
+
+    virtual std::vector<Angles> solveReflectionGlobal(const Vector& vSun, const Vector& rAim) const;
+    Vector findFacetPoint(const Angles& angles) const;
+    // facet point of a compiled armature, angles in radians
+    static Vector findFacetPoint(const CompiledArmature2AT<T>& c, const Angles& angles);
+    std::vector<Angles> solveFacetNormal(const Vector& normal) const;
+    std::vector<Angles> solveRotation(const Vector& v0, const Vector& v) const;
+    virtual std::vector<Angles> solveReflectionSecondary(const Vector& vSun, const Vector& rAim) const;
     virtual Angles selectSolution(const std::vector<Angles>& solutions) const;
 
+    // Allocation-free overloads, ans is cleared and filled with the solutions found.
+    // The global solvers report the iterations performed and the convergence status,
+    // the anglesStart overload starts iterating from the facet point at anglesStart
+    // instead of the default angles (warm start).
+    virtual SolverStatus2A solveReflectionGlobal(const Vector& vSun, const Vector& rAim, Solutions& ans) const;
+    virtual SolverStatus2A solveReflectionGlobal(const Vector& vSun, const Vector& rAim, const Angles& anglesStart, Solutions& ans) const;
+    void solveFacetNormal(const Vector& normal, Solutions& ans) const;
+    void solveRotation(const Vector& v0, const Vector& v, Solutions& ans) const;
+    virtual void solveReflectionSecondary(const Vector& vSun, const Vector& rAim, Solutions& ans) const;
+    virtual Angles selectSolution(const Solutions& solutions) const;
+
+    // solveRotation for count problems, ans must hold count elements.
+    // Uses the AVX2 kernel four (double) or eight (float) problems at a time when the CPU
+    // supports it, the angles then agree with the scalar path to a few ulps.
+    void solveRotationBatch(std::size_t count, const vec3ArrayView<T>& v0, const vec3ArrayView<T>& v, Solutions* ans) const;
+
+    // vSun and rAim are given in the armature frame, angles are written in radians
+    void solveBatch(std::size_t count, const vec3ArrayView<T>& vSun, const vec3ArrayView<T>& rAim,
+                    TrackerTarget::AimingType aimingType, vec2ArrayView<T> angles) const;
+
 private:
+    SolverStatus2A solveReflectionGlobalFrom(const Vector& vSun, const Vector& rAim, const Vector& rFacetStart, Solutions& ans) const;
+    SolverStatus2A::Convergence solveFixedPoint(const Vector& vSun, const Vector& rAim, Vector rFacet, int s, Angles& angles, int& iterations) const;
+    SolverStatus2A::Convergence solveNewton(const Vector& vSun, const Vector& rAim, const Vector& rFacet, int s, Angles& angles, int& iterations) const;
+    Angles selectSolution(const Angles* begin, const Angles* end) const;
+    const CompiledArmature2AT<T>& compiled() const;
+
     TrackerArmature2A* m_armature;
+    Method m_method;
+    double m_tolerance;
+    int m_iterationsMax;
 };
+
+typedef TrackerSolver2AT<double> TrackerSolver2A;
+typedef TrackerSolver2AT<float> TrackerSolver2Af;
+
+extern template class TrackerSolver2AT<double>;
+extern template class TrackerSolver2AT<float>;
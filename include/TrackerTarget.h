@@ -1,6 +1,7 @@
 #pragma once
 
 #include "heliostat_tracking_export.h"
+#include "SolverStatus2A.h"
 #include "vec2d.h"
 #include "vec3d.h"
 
@@ -19,5 +20,22 @@ public:
     AimingType aimingType;
     vec3d aimingPoint;
     vec2d angles;
+
+    // Warm-started tracking: once tracking, global aiming starts from the previous angles.
+    // Changing aimingPoint or aimingType stops tracking, the next update starts cold.
+    bool warmStart;
+    bool tracking; // angles hold the solution of the previous update
+    AimingType trackedAimingType; // aim of the previous update
+    vec3d trackedAimingPoint;
+    // Statistics: warm-started updates also solve from the default angles to count iterationsCold,
+    // which doubles their cost
+    bool measureIterations;
+    int iterations; // solver iterations used by the last update
+    int iterationsCold; // solver iterations from the default angles for the inputs of the last update, -1 if not measured
+    SolverStatus2A::Convergence convergence; // solver status of the last update
+
+    void resetTracking() { tracking = false; }
+    // iterations saved by the last update, 0 if it started cold or iterationsCold was not measured
+    int iterationsSaved() const { return iterationsCold > iterations ? iterationsCold - iterations : 0; }
 };
 
@@ -6,61 +6,83 @@
 
 class Ray;
 
-class HELIOSTAT_TRACKING_EXPORT Transform
+// Affine transform with its inverse, templated on the scalar type.
+// Transform and Transformf are the double and float versions, rays are transformed in double.
+template<class T>
+class HELIOSTAT_TRACKING_EXPORT TransformT
 {
 public:
-    Transform();
-    Transform(
-        double t00, double t01, double t02, double t03,
-        double t10, double t11, double t12, double t13,
-        double t20, double t21, double t22, double t23,
-        double t30, double t31, double t32, double t33
+    TransformT();
+    TransformT(
+        T t00, T t01, T t02, T t03,
+        T t10, T t11, T t12, T t13,
+        T t20, T t21, T t22, T t23,
+        T t30, T t31, T t32, T t33
     );
-    Transform(double m[4][4]);
-    Transform(Matrix4x4* m);
-    Transform(const std::shared_ptr<Matrix4x4>& mdir);
-    Transform(const std::shared_ptr<Matrix4x4>& mdir, const std::shared_ptr<Matrix4x4>& minv);
+    TransformT(T m[4][4]);
+    TransformT(Matrix4x4T<T>* m);
+    TransformT(const std::shared_ptr<Matrix4x4T<T>>& mdir);
+    TransformT(const std::shared_ptr<Matrix4x4T<T>>& mdir, const std::shared_ptr<Matrix4x4T<T>>& minv);
 
-    std::shared_ptr<Matrix4x4> getMatrix() const {return m_mdir;}
-    Transform transposed() const {return Transform(m_mdir->transposed(), m_minv->transposed());}
-    Transform inversed() const {return Transform(m_minv, m_mdir);}
-    vec3d getScales() const;
+    // conversion from the other precision
+    template<class U>
+    explicit TransformT(const TransformT<U>& t):
+        m_mdir(std::make_shared<Matrix4x4T<T>>(*t.getMatrix())),
+        m_minv(std::make_shared<Matrix4x4T<T>>(*t.inversed().getMatrix())) {}
+
+    std::shared_ptr<Matrix4x4T<T>> getMatrix() const {return m_mdir;}
+    TransformT transposed() const {return TransformT(m_mdir->transposed(), m_minv->transposed());}
+    TransformT inversed() const {return TransformT(m_minv, m_mdir);}
+    vec3<T> getScales() const;
 
     bool SwapsHandedness() const;
 
-    Transform operator*(const Transform& rhs) const;
+    TransformT operator*(const TransformT& rhs) const;
 
-    vec3d transformPoint(const vec3d& p) const;
-    vec3d transformVector(const vec3d& v) const;
-    vec3d transformNormal(const vec3d& n) const;
-    vec3d transformInverseNormal(const vec3d& n) const;
+    vec3<T> transformPoint(const vec3<T>& p) const;
+    vec3<T> transformVector(const vec3<T>& v) const;
+    vec3<T> transformNormal(const vec3<T>& n) const;
+    vec3<T> transformInverseNormal(const vec3<T>& n) const;
     Ray transformDirect(const Ray& r) const;
     Ray transformInverse(const Ray& r) const;
 
-    vec3d operator()(const vec3d& v) const;
-    void operator()(const vec3d& v, vec3d& ans) const;
+    vec3<T> operator()(const vec3<T>& v) const;
+    void operator()(const vec3<T>& v, vec3<T>& ans) const;
 
     Ray operator()(const Ray& r) const;
     void operator()(const Ray& r, Ray& ans) const;
 
-    vec3d multVecMatrix(const vec3d& v) const;
-    vec3d multDirMatrix(const vec3d& src) const;
+    vec3<T> multVecMatrix(const vec3<T>& v) const;
+    vec3<T> multDirMatrix(const vec3<T>& src) const;
 
-    bool operator==(const Transform& mat) const;
+    bool operator==(const TransformT& mat) const;
 
-    static const Transform Identity;
-    static Transform translate(double x, double y, double z);
-    static Transform translate(const vec3d& v) {return translate(v.x, v.y, v.z);}
-    static Transform scale(double x, double y, double z);
-    static Transform rotateX(double angle);
-    static Transform rotateY(double angle);
-    static Transform rotateZ(double angle);
-    static Transform rotate(double angle, const vec3d& axis);
-    static Transform LookAt(const vec3d& pos, const vec3d& look, const vec3d& up);
+    static const TransformT Identity;
+    static TransformT translate(T x, T y, T z);
+    static TransformT translate(const vec3<T>& v) {return translate(v.x, v.y, v.z);}
+    static TransformT scale(T x, T y, T z);
+    static TransformT rotateX(T angle);
+    static TransformT rotateY(T angle);
+    static TransformT rotateZ(T angle);
+    static TransformT rotate(T angle, const vec3<T>& axis);
+    static TransformT LookAt(const vec3<T>& pos, const vec3<T>& look, const vec3<T>& up);
 
 private:
-    std::shared_ptr<Matrix4x4> m_mdir;
-    std::shared_ptr<Matrix4x4> m_minv;
+    friend class AffineTransform;
+
+    std::shared_ptr<Matrix4x4T<T>> m_mdir;
+    std::shared_ptr<Matrix4x4T<T>> m_minv;
 };
 
-HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const Transform& tran);
\ No newline at end of file
+template<class T>
+std::ostream& operator<<(std::ostream& os, const TransformT<T>& t)
+{
+    os << *t.getMatrix();
+    return os;
+}
+
+typedef TransformT<double> Transform;
+typedef TransformT<float> Transformf;
+
+extern template class TransformT<double>;
+extern template class TransformT<float>;
@@ -5,173 +5,196 @@
 
 #include "heliostat_tracking_export.h"
 
-struct HELIOSTAT_TRACKING_EXPORT vec2d
+// 2D vector templated on the scalar type, vec2d and vec2f are the double and float versions
+template<class T>
+struct HELIOSTAT_TRACKING_EXPORT vec2
 {
-    vec2d(double x = 0., double y = 0):
+    typedef T Scalar;
+
+    vec2(T x = 0, T y = 0):
         x(x), y(y) {}
 
+    // conversion from the other precision
+    template<class U>
+    explicit vec2(const vec2<U>& v):
+        x(T(v.x)), y(T(v.y)) {}
+
     // Constants
-    static const vec2d Zero;
-    static const vec2d One;
-    static const vec2d UnitX;
-    static const vec2d UnitY;
+    static const vec2 Zero;
+    static const vec2 One;
+    static const vec2 UnitX;
+    static const vec2 UnitY;
 
     // Arithmetic operations
-    vec2d operator+(const vec2d& v) const
+    vec2 operator+(const vec2& v) const
     {
-        return vec2d(x + v.x, y + v.y);
+        return vec2(x + v.x, y + v.y);
     }
 
-    vec2d operator-(const vec2d& v) const
+    vec2 operator-(const vec2& v) const
     {
-        return vec2d(x - v.x, y - v.y);
+        return vec2(x - v.x, y - v.y);
     }
 
-    vec2d operator-() const
+    vec2 operator-() const
     {
-        return vec2d(-x, -y);
+        return vec2(-x, -y);
     }
 
-    vec2d operator*(double s) const
+    vec2 operator*(T s) const
     {
-        return vec2d(x*s, y*s);
+        return vec2(x*s, y*s);
     }
 
-    vec2d operator*(const vec2d& v) const
+    vec2 operator*(const vec2& v) const
     {
-        return vec2d(x*v.x, y*v.y);
+        return vec2(x*v.x, y*v.y);
     }
 
-    vec2d operator/(double s) const
+    vec2 operator/(T s) const
     {
-        s = 1./s;
-        return vec2d(x*s, y*s);
+        s = T(1)/s;
+        return vec2(x*s, y*s);
     }
 
-    vec2d operator/(const vec2d& v) const
+    vec2 operator/(const vec2& v) const
     {
-        return vec2d(x/v.x, y/v.y);
+        return vec2(x/v.x, y/v.y);
     }
 
     // Arithmetic assignments
 
-    vec2d& operator+=(const vec2d& v)
+    vec2& operator+=(const vec2& v)
     {
         x += v.x;
         y += v.y;
         return *this;
     }
 
-    vec2d& operator-=(const vec2d& v)
+    vec2& operator-=(const vec2& v)
     {
         x -= v.x;
         y -= v.y;
         return *this;
     }
 
-    vec2d& operator*=(double s)
+    vec2& operator*=(T s)
     {
         x *= s;
         y *= s;
         return *this;
     }
 
-    vec2d& operator/=(double s)
+    vec2& operator/=(T s)
     {
-        s = 1./s;
+        s = T(1)/s;
         x *= s;
         y *= s;
         return *this;
     }
 
     // Comparison
-    bool operator==(const vec2d& v) const;
-    bool operator!=(const vec2d& v) const;
-    bool operator<=(const vec2d& v) const {return x <= v.x && y <= v.y;}
+    bool operator==(const vec2& v) const;
+    bool operator!=(const vec2& v) const;
+    bool operator<=(const vec2& v) const {return x <= v.x && y <= v.y;}
 
     // Element access
-    double operator[](int i) const
+    T operator[](int i) const
     {
         if (i == 0) return x;
         return y;
     }
 
-    double& operator[](int i)
+    T& operator[](int i)
     {
         if (i == 0) return x;
         return y;
     }
 
     // Normalize and norm methods
-    double norm2() const {
+    T norm2() const {
         return x*x + y*y;
     }
 
-    double norm() const {
+    T norm() const {
         return std::sqrt(norm2());
     }
 
-    vec2d normalized() const
+    vec2 normalized() const
     {
-        double s = norm2();
-        if (s > 0.)
-            return *this/sqrt(s);
+        T s = norm2();
+        if (s > 0)
+            return *this/std::sqrt(s);
         return *this;
     }
 
     bool normalize()
     {
-        double s = norm2();
-        if (s > 0.) {
-            *this /= sqrt(s);
+        T s = norm2();
+        if (s > 0) {
+            *this /= std::sqrt(s);
             return true;
         }
         return false;
     }
 
     // Utility methods
-    vec2d abs() const {return vec2d(std::abs(x), std::abs(y));}
-    double min() const {return std::min(x, y);}
-    double max() const {return std::max(x, y);}
+    vec2 abs() const {return vec2(std::abs(x), std::abs(y));}
+    T min() const {return std::min(x, y);}
+    T max() const {return std::max(x, y);}
     int maxDimension() const {return x > y ? 0 : 1;}
 
-    static vec2d min(const vec2d& a, const vec2d& b)
+    static vec2 min(const vec2& a, const vec2& b)
     {
-        return vec2d(
+        return vec2(
             std::min(a.x, b.x),
             std::min(a.y, b.y)
         );
     }
 
-    static vec2d max(const vec2d& a, const vec2d& b)
+    static vec2 max(const vec2& a, const vec2& b)
     {
-        return vec2d(
+        return vec2(
             std::max(a.x, b.x),
             std::max(a.y, b.y)
         );
     }
 
-    double x;
-    double y;
+    T x;
+    T y;
 };
 
 // Scalar multiplication from left
-inline vec2d operator*(double s, const vec2d& v)
+template<class T>
+inline vec2<T> operator*(typename vec2<T>::Scalar s, const vec2<T>& v)
 {
-    return vec2d(s*v.x, s*v.y);
+    return vec2<T>(s*v.x, s*v.y);
 }
 
 // Dot produce
-inline double dot(const vec2d& a, const vec2d& b)
+template<class T>
+inline T dot(const vec2<T>& a, const vec2<T>& b)
 {
     return a.x*b.x + a.y*b.y;
 }
 
 // Cross product
-inline double cross(const vec2d& a, const vec2d& b)
+template<class T>
+inline T cross(const vec2<T>& a, const vec2<T>& b)
 {
     return a.x*b.y - a.y*b.x;
 }
 
 // Stream output
-HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const vec2d& vector);
\ No newline at end of file
+template<class T>
+std::ostream& operator<<(std::ostream& os, const vec2<T>& v)
+{
+    os << v.x << ", " << v.y;
+    return os;
+}
+
+typedef vec2<double> vec2d;
+typedef vec2<float> vec2f;
+
+extern template struct vec2<double>;
+extern template struct vec2<float>;
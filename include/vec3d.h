@@ -5,33 +5,42 @@
 
 #include "heliostat_tracking_export.h"
 
-struct HELIOSTAT_TRACKING_EXPORT vec3d
+// 3D vector templated on the scalar type, vec3d and vec3f are the double and float versions
+template<class T>
+struct HELIOSTAT_TRACKING_EXPORT vec3
 {
-    vec3d(double x = 0., double y = 0., double z = 0.):
+    typedef T Scalar;
+
+    vec3(T x = 0, T y = 0, T z = 0):
         x(x), y(y), z(z) {}
 
-    vec3d(const vec2d& v, double z = 0.):
+    vec3(const vec2<T>& v, T z = 0):
         x(v.x), y(v.y), z(z) {}
 
-    vec3d(float* p):
-        x(*p), y(*(p + 1)), z(*(p + 2)) {}
+    // conversion from the other precision
+    template<class U>
+    explicit vec3(const vec3<U>& v):
+        x(T(v.x)), y(T(v.y)), z(T(v.z)) {}
+
+    vec3(const float* p):
+        x(T(*p)), y(T(*(p + 1))), z(T(*(p + 2))) {}
 
-    vec3d(double* p):
-        x(*p), y(*(p + 1)), z(*(p + 2)) {}
+    vec3(const double* p):
+        x(T(*p)), y(T(*(p + 1))), z(T(*(p + 2))) {}
 
     // constants
-    static const vec3d Zero;
-    static const vec3d One;
-    static const vec3d UnitX;
-    static const vec3d UnitY;
-    static const vec3d UnitZ;
+    static const vec3 Zero;
+    static const vec3 One;
+    static const vec3 UnitX;
+    static const vec3 UnitY;
+    static const vec3 UnitZ;
 
-    vec3d operator+(const vec3d& v) const
+    vec3 operator+(const vec3& v) const
     {
-        return vec3d(x + v.x, y + v.y, z + v.z);
+        return vec3(x + v.x, y + v.y, z + v.z);
     }
 
-    vec3d& operator+=(const vec3d& v)
+    vec3& operator+=(const vec3& v)
     {
         x += v.x;
         y += v.y;
@@ -39,17 +48,17 @@ struct HELIOSTAT_TRACKING_EXPORT vec3d
         return *this;
     }
 
-    vec3d operator-() const
+    vec3 operator-() const
     {
-        return vec3d(-x, -y, -z);
+        return vec3(-x, -y, -z);
     }
 
-    vec3d operator-(const vec3d& v) const
+    vec3 operator-(const vec3& v) const
     {
-        return vec3d(x - v.x, y - v.y, z - v.z);
+        return vec3(x - v.x, y - v.y, z - v.z);
     }
 
-    vec3d& operator-=(const vec3d& v)
+    vec3& operator-=(const vec3& v)
     {
         x -= v.x;
         y -= v.y;
@@ -57,17 +66,17 @@ struct HELIOSTAT_TRACKING_EXPORT vec3d
         return *this;
     }
 
-    vec3d operator*(double s) const
+    vec3 operator*(T s) const
     {
-        return vec3d(x*s, y*s, z*s);
+        return vec3(x*s, y*s, z*s);
     }
 
-    vec3d operator*(const vec3d& v) const
+    vec3 operator*(const vec3& v) const
     {
-        return vec3d(x*v.x, y*v.y, z*v.z);
+        return vec3(x*v.x, y*v.y, z*v.z);
     }
 
-    vec3d& operator*=(double s)
+    vec3& operator*=(T s)
     {
         x *= s;
         y *= s;
@@ -75,132 +84,137 @@ struct HELIOSTAT_TRACKING_EXPORT vec3d
         return *this;
     }
 
-    vec3d operator/(double s) const
+    vec3 operator/(T s) const
     {
-        s = 1./s;
-        return vec3d(x*s, y*s, z*s);
+        s = T(1)/s;
+        return vec3(x*s, y*s, z*s);
     }
 
-    vec3d operator/(const vec3d& v) const
+    vec3 operator/(const vec3& v) const
     {
-        return vec3d(x/v.x, y/v.y, z/v.z);
+        return vec3(x/v.x, y/v.y, z/v.z);
     }
 
-    vec3d& operator/=(double s)
+    vec3& operator/=(T s)
     {
-        s = 1./s;
+        s = T(1)/s;
         x *= s;
         y *= s;
         z *= s;
         return *this;
     }
 
-    bool operator==(const vec3d& v) const;
-    bool operator!=(const vec3d& v) const;
-    bool operator<=(const vec3d& v) const {return x <= v.x && y <= v.y && z < v.z;}
+    bool operator==(const vec3& v) const;
+    bool operator!=(const vec3& v) const;
+    bool operator<=(const vec3& v) const {return x <= v.x && y <= v.y && z < v.z;}
 
-    double operator[](int i) const
+    T operator[](int i) const
     {
         if (i == 0) return x;
         if (i == 1) return y;
         return z;
     }
 
-    double& operator[](int i)
+    T& operator[](int i)
     {
         if (i == 0) return x;
         if (i == 1) return y;
         return z;
     }
 
-    double norm2() const {
+    T norm2() const {
         return x*x + y*y + z*z;
     }
 
-    double norm() const {
+    T norm() const {
         return std::sqrt(norm2());
     }
 
-    vec3d normalized() const
+    vec3 normalized() const
     {
-        double s = norm2();
-        if (s > 0.)
-            return *this/sqrt(s);
+        T s = norm2();
+        if (s > 0)
+            return *this/std::sqrt(s);
         return *this;
     }
 
     bool normalize()
     {
-        double s = norm2();
-        if (s > 0.) {
-            *this /= sqrt(s);
+        T s = norm2();
+        if (s > 0) {
+            *this /= std::sqrt(s);
             return true;
         }
         return false;
     }
 
-    vec3d projected(const vec3d& n) const;
-    vec3d reflected(const vec3d& n) const;
-    vec3d reflect(const vec3d& v) const;
+    vec3 projected(const vec3& n) const;
+    vec3 reflected(const vec3& n) const;
+    vec3 reflect(const vec3& v) const;
 
-    double min() const {return std::min(std::min(x, y), z);}
-    double max() const {return std::max(std::max(x, y), z);}
-    vec3d abs() const {return vec3d(std::abs(x), std::abs(y), std::abs(z));}
+    T min() const {return std::min(std::min(x, y), z);}
+    T max() const {return std::max(std::max(x, y), z);}
+    vec3 abs() const {return vec3(std::abs(x), std::abs(y), std::abs(z));}
     int maxDimension() const;
 
-    vec3d findOrthogonal() const;
+    vec3 findOrthogonal() const;
 
-    double x;
-    double y;
-    double z;
+    T x;
+    T y;
+    T z;
 
-    static vec3d min(const vec3d& a, const vec3d& b)
+    static vec3 min(const vec3& a, const vec3& b)
     {
-        return vec3d(
+        return vec3(
             std::min(a.x, b.x),
             std::min(a.y, b.y),
             std::min(a.z, b.z)
         );
     }
 
-    static vec3d max(const vec3d& a, const vec3d& b)
+    static vec3 max(const vec3& a, const vec3& b)
     {
-        return vec3d(
+        return vec3(
             std::max(a.x, b.x),
             std::max(a.y, b.y),
             std::max(a.z, b.z)
         );
     }
 
-    static vec3d directionAE(double azimuth, double elevation);
+    static vec3 directionAE(T azimuth, T elevation);
 };
 
-inline vec3d operator*(double s, const vec3d& v)
+template<class T>
+inline vec3<T> operator*(typename vec3<T>::Scalar s, const vec3<T>& v)
 {
-    return vec3d(s*v.x, s*v.y, s*v.z);
+    return vec3<T>(s*v.x, s*v.y, s*v.z);
 }
 
-inline double dot(const vec3d& a, const vec3d& b)
+template<class T>
+inline T dot(const vec3<T>& a, const vec3<T>& b)
 {
     return a.x*b.x + a.y*b.y + a.z*b.z;
 }
 
-inline vec3d cross(const vec3d& a, const vec3d& b)
+template<class T>
+inline vec3<T> cross(const vec3<T>& a, const vec3<T>& b)
 {
-    return vec3d(
+    return vec3<T>(
         a.y*b.z - a.z*b.y,
         a.z*b.x - a.x*b.z,
         a.x*b.y - a.y*b.x
     );
 }
 
-inline double triple(const vec3d& a, const vec3d& b, const vec3d& c)
+template<class T>
+inline T triple(const vec3<T>& a, const vec3<T>& b, const vec3<T>& c)
 {
     return dot(a, cross(b, c));
 }
 
 // this != normal
-inline vec3d vec3d::projected(const vec3d& n) const
+template<class T>
+inline vec3<T> vec3<T>::projected(const vec3& n) const
 {
     // This computes the orthogonal projection of "*this" onto a plane 
     // defined by its normal vector n.
@@ -209,26 +223,41 @@ inline vec3d vec3d::projected(const vec3d& n) const
 }
 
 // this != normal
-inline vec3d vec3d::reflected(const vec3d& n) const
+template<class T>
+inline vec3<T> vec3<T>::reflected(const vec3& n) const
 {
     // This computes the the reflection of "*this" onto a plane 
     // defined by its normal vector n.
     // It is assumed that n is a unit vector.
-    return *this - n*(2.*dot(*this, n));
+    return *this - n*(2*dot(*this, n));
 }
 
 // this = normal
-inline vec3d vec3d::reflect(const vec3d& v) const
+template<class T>
+inline vec3<T> vec3<T>::reflect(const vec3& v) const
 {
-    return v - (*this)*(2.*dot(*this, v)/norm2());
+    return v - (*this)*(2*dot(*this, v)/norm2());
 }
 
-inline vec3d vec3d::findOrthogonal() const
+template<class T>
+inline vec3<T> vec3<T>::findOrthogonal() const
 {
     if (std::abs(z) > std::abs(x) && std::abs(z) > std::abs(y))
-        return vec3d(z, 0., -x);
+        return vec3(z, 0, -x);
     else
-        return vec3d(y, -x, 0.);
+        return vec3(y, -x, 0);
 }
 
-HELIOSTAT_TRACKING_EXPORT std::ostream& operator<<(std::ostream& os, const vec3d& vector);
+template<class T>
+std::ostream& operator<<(std::ostream& os, const vec3<T>& v)
+{
+    os << v.x << ", " << v.y << ", " << v.z;
+    return os;
+}
+
+typedef vec3<double> vec3d;
+typedef vec3<float> vec3f;
+
+extern template struct vec3<double>;
+extern template struct vec3<float>;
+
@@ -0,0 +1,108 @@
+#include "gtest/gtest.h"
+
+#include "gcf.h"
+#include "AffineTransform.h"
+#include "Ray.h"
+#include "Transform.h"
+
+class AffineTransformTest : public ::testing::Test {
+protected:
+    Transform reference;
+    AffineTransform affine;
+
+    AffineTransformTest() {
+        reference = Transform::translate(1., -2., 3.)*Transform::rotate(25.4*gcf::degree, vec3d(1., 1., 0.))*Transform::scale(2., 3., 4.);
+        affine = AffineTransform::translate(1., -2., 3.)*AffineTransform::rotate(25.4*gcf::degree, vec3d(1., 1., 0.))*AffineTransform::scale(2., 3., 4.);
+    }
+};
+
+static void expectNear(const vec3d& a, const vec3d& b, double tolerance = 1e-12) {
+    EXPECT_NEAR(a.x, b.x, tolerance);
+    EXPECT_NEAR(a.y, b.y, tolerance);
+    EXPECT_NEAR(a.z, b.z, tolerance);
+}
+
+TEST_F(AffineTransformTest, DefaultConstructorIsIdentity) {
+    AffineTransform t;
+    vec3d p(1., 2., 3.);
+    EXPECT_EQ(t.transformPoint(p), p);
+    EXPECT_EQ(t.inversed().transformPoint(p), p);
+}
+
+TEST_F(AffineTransformTest, ConversionFromTransform) {
+    AffineTransform t(reference);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            EXPECT_EQ(t.getMatrix()[i][j], reference.getMatrix()->m[i][j]);
+    EXPECT_TRUE(t == affine);
+}
+
+TEST_F(AffineTransformTest, ConversionFromNullTransformIsIdentity) {
+    AffineTransform t{Transform()};
+    EXPECT_TRUE(t == AffineTransform::Identity);
+}
+
+TEST_F(AffineTransformTest, ConstructorComputesInverse) {
+    AffineTransform t(affine.getMatrix());
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            EXPECT_NEAR(t.getInverseMatrix()[i][j], affine.getInverseMatrix()[i][j], 1e-14);
+}
+
+TEST_F(AffineTransformTest, ConversionToTransform) {
+    Transform t = affine.toTransform();
+    EXPECT_TRUE(t == reference);
+    vec3d p(0.5, -1.5, 2.);
+    expectNear(t.inversed().transformPoint(p), reference.inversed().transformPoint(p));
+}
+
+TEST_F(AffineTransformTest, TransformPointMatchesTransform) {
+    vec3d p(0.5, -1.5, 2.);
+    expectNear(affine.transformPoint(p), reference.transformPoint(p));
+}
+
+TEST_F(AffineTransformTest, TransformVectorMatchesTransform) {
+    vec3d v(0.5, -1.5, 2.);
+    expectNear(affine.transformVector(v), reference.transformVector(v));
+    expectNear(affine(v), reference(v));
+}
+
+TEST_F(AffineTransformTest, TransformNormalMatchesTransform) {
+    vec3d n(1., 2., 3.);
+    expectNear(affine.transformNormal(n), reference.transformNormal(n));
+    expectNear(affine.transformInverseNormal(n), reference.transformInverseNormal(n));
+}
+
+TEST_F(AffineTransformTest, InversedRoundTrip) {
+    vec3d p(0.5, -1.5, 2.);
+    expectNear(affine.inversed().transformPoint(affine.transformPoint(p)), p);
+    expectNear((affine.inversed()*affine).transformPoint(p), p);
+}
+
+TEST_F(AffineTransformTest, TransformRayMatchesTransform) {
+    Ray ray(vec3d(1., 2., 3.), vec3d(0., 0., 1.));
+    Ray a = affine.transformDirect(ray);
+    Ray b = reference.transformDirect(ray);
+    expectNear(a.origin, b.origin);
+    expectNear(a.direction(), b.direction());
+
+    a = affine.transformInverse(ray);
+    b = reference.transformInverse(ray);
+    expectNear(a.origin, b.origin);
+    expectNear(a.direction(), b.direction());
+}
+
+TEST_F(AffineTransformTest, RotationsMatchTransform) {
+    double angle = 33.*gcf::degree;
+    vec3d v(0.3, -0.7, 1.1);
+    expectNear(AffineTransform::rotateX(angle)(v), Transform::rotateX(angle)(v));
+    expectNear(AffineTransform::rotateY(angle)(v), Transform::rotateY(angle)(v));
+    expectNear(AffineTransform::rotateZ(angle)(v), Transform::rotateZ(angle)(v));
+}
+
+TEST_F(AffineTransformTest, ScalesAndHandedness) {
+    AffineTransform t = AffineTransform::scale(2., 3., -4.);
+    EXPECT_EQ(t.getScales(), vec3d(2., 3., 4.));
+    EXPECT_TRUE(t.SwapsHandedness());
+    EXPECT_FALSE(affine.SwapsHandedness());
+}
@@ -0,0 +1,212 @@
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "AnnualSimulation.h"
+#include "ElevationAngleKM.h"
+#include "HeliostatField.h"
+#include "HourAngleKM.h"
+#include "SunPositionEngine.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+#include "Bluesolar.h"
+
+class AnnualSimulationTest : public ::testing::Test {
+protected:
+    TrackerArmature2A bluesolar{bluesolarGeometry()};
+    ElevationAngleKM elevationKM = bluesolarElevationAngleKM();
+    HourAngleKM hourKM = bluesolarHourAngleKM();
+    SunPositionEngine engine = SunPositionEngine(-2.46*gcf::degree, 37.09*gcf::degree);
+
+    void addHeliostats(HeliostatField& field) {
+        TrackerTarget target;
+        target.aimingPoint = vec3d(0., 0., 20.);
+        target.warmStart = true;
+        for (int i = 0; i < 12; ++i) {
+            double phi = (-60. + 10.*i)*gcf::degree;
+            double r = 20. + 2.*i;
+            field.addHeliostat(Transform::translate(r*sin(phi), r*cos(phi), 0.), &bluesolar, target);
+        }
+    }
+};
+
+TEST_F(AnnualSimulationTest, WritesChunkedColumns) {
+    HeliostatField field(2);
+    addHeliostats(field);
+    AnnualSimulation simulation(&field, engine);
+    double timeStart = SunPositionEngine::toUnixTime(2024, 6, 21);
+    simulation.set_timeRange(timeStart, timeStart + 86400., 600.);
+    simulation.set_actuatorModels(&elevationKM, &hourKM);
+    simulation.set_chunkSteps(16);
+    EXPECT_EQ(simulation.get_steps(), 145u);
+
+    std::string fileName = ::testing::TempDir() + "annual_simulation_test.bin";
+    simulation.run(fileName);
+
+    std::ifstream file(fileName, std::ios::binary);
+    ASSERT_TRUE(file.good());
+    SimulationFileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ASSERT_TRUE(header.isValid());
+    EXPECT_EQ(header.columns, 4u);
+    EXPECT_EQ(header.heliostats, 12u);
+    EXPECT_EQ(header.steps, 145u);
+    EXPECT_EQ(header.chunks(), 10u);
+    EXPECT_EQ(header.timeStart, timeStart);
+    EXPECT_EQ(header.latitude, engine.get_latitude());
+
+    file.seekg(0, std::ios::end);
+    EXPECT_EQ(std::uint64_t(file.tellg()), sizeof(header) + 9*header.chunkBytes(16) + header.chunkBytes(1));
+
+    // the same steps run serially
+    HeliostatField reference(1);
+    addHeliostats(reference);
+    int day = 0, night = 0;
+    for (std::uint64_t k = 0; k < header.chunks(); ++k) {
+        std::uint64_t n = std::min<std::uint64_t>(16, header.steps - 16*k);
+        file.seekg(sizeof(header) + k*header.chunkBytes(16));
+        std::vector<double> times(n), sunVectors(3*n);
+        std::vector<float> values(4*n*12);
+        file.read(reinterpret_cast<char*>(times.data()), n*sizeof(double));
+        file.seekg((8*n + 7)/8*8 - 8*n, std::ios::cur);
+        file.read(reinterpret_cast<char*>(sunVectors.data()), 3*n*sizeof(double));
+        file.seekg((24*n + 7)/8*8 - 24*n, std::ios::cur);
+        for (int c = 0; c < 4; ++c) {
+            file.read(reinterpret_cast<char*>(values.data() + c*n*12), n*12*sizeof(float));
+            file.seekg((48*n + 7)/8*8 - 48*n, std::ios::cur);
+        }
+        ASSERT_TRUE(file.good());
+
+        for (std::uint64_t j = 0; j < n; ++j) {
+            EXPECT_EQ(times[j], timeStart + 600.*(16*k + j));
+            // the batch may use the AVX2 sines and cosines
+            vec3d vSun(sunVectors[3*j], sunVectors[3*j + 1], sunVectors[3*j + 2]);
+            EXPECT_NEAR(vSun.z, engine.findSunVector(times[j]).z, 1e-14);
+            if (vSun.z <= 0.) {
+                ++night;
+                for (std::size_t i = 0; i < 12; ++i)
+                    reference.get_target(i).resetTracking();
+                for (int c = 0; c < 4; ++c)
+                    EXPECT_TRUE(std::isnan(values[(c*n + j)*12 + 5]));
+                continue;
+            }
+            ++day;
+            reference.update(vSun);
+            for (std::size_t i = 0; i < 12; ++i) {
+                vec2d angles = reference.get_angles(i);
+                EXPECT_EQ(values[j*12 + i], float(angles.x));
+                EXPECT_EQ(values[(n + j)*12 + i], float(angles.y));
+                // NaN for angles out of the actuator range
+                float elevationLength = float(elevationKM.getActuatorLengthFromElevationAngle(angles.x*gcf::degree));
+                float hourLength = float(hourKM.getActuatorLengthFromHourAngle(angles.y*gcf::degree));
+                float length = values[(2*n + j)*12 + i];
+                EXPECT_TRUE(length == elevationLength || (std::isnan(length) && std::isnan(elevationLength)));
+                length = values[(3*n + j)*12 + i];
+                EXPECT_TRUE(length == hourLength || (std::isnan(length) && std::isnan(hourLength)));
+            }
+        }
+    }
+    EXPECT_GT(day, 60);
+    EXPECT_GT(night, 30);
+    // the range ends at night
+    for (std::size_t i = 0; i < 12; ++i)
+        EXPECT_FALSE(field.get_target(i).tracking);
+    file.close();
+    std::remove(fileName.c_str());
+}
+
+TEST_F(AnnualSimulationTest, AnglesOnly) {
+    HeliostatField field(1);
+    addHeliostats(field);
+    AnnualSimulation simulation(&field, engine);
+    double timeStart = SunPositionEngine::toUnixTime(2024, 3, 20, 12.);
+    simulation.set_timeRange(timeStart, timeStart + 3000., 1000.);
+    simulation.set_chunkSteps(3);
+
+    std::string fileName = ::testing::TempDir() + "annual_simulation_angles.bin";
+    simulation.run(fileName);
+    std::ifstream file(fileName, std::ios::binary);
+    SimulationFileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ASSERT_TRUE(header.isValid());
+    EXPECT_EQ(header.columns, 2u);
+    EXPECT_EQ(header.steps, 4u);
+    file.seekg(0, std::ios::end);
+    EXPECT_EQ(std::uint64_t(file.tellg()), sizeof(header) + header.chunkBytes(3) + header.chunkBytes(1));
+    file.close();
+    std::remove(fileName.c_str());
+}
+
+TEST_F(AnnualSimulationTest, ModelsPerHeliostat) {
+    HeliostatField field(1);
+    addHeliostats(field);
+    ElevationAngleKM elevationKM2 = elevationKM;
+    elevationKM2.set_offset(elevationKM.get_offset() + 0.01);
+    HourAngleKM hourKM2 = hourKM;
+    hourKM2.set_offset(hourKM.get_offset() - 0.01);
+    // runs of shared models, a heliostat without models and a single one
+    std::vector<const ElevationAngleKM*> elevations(12, &elevationKM);
+    std::vector<const HourAngleKM*> hours(12, &hourKM);
+    for (std::size_t i = 4; i < 9; ++i) {
+        elevations[i] = &elevationKM2;
+        hours[i] = &hourKM2;
+    }
+    elevations[9] = nullptr;
+    hours[9] = nullptr;
+    elevations[11] = &elevationKM2;
+    hours[11] = &hourKM2;
+
+    AnnualSimulation simulation(&field, engine);
+    double timeStart = SunPositionEngine::toUnixTime(2024, 3, 20, 12.);
+    simulation.set_timeRange(timeStart, timeStart, 600.);
+    simulation.set_actuatorModels(elevations, hours);
+    std::string fileName = ::testing::TempDir() + "annual_simulation_models.bin";
+    simulation.run(fileName);
+
+    std::ifstream file(fileName, std::ios::binary);
+    SimulationFileHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    ASSERT_TRUE(header.isValid());
+    EXPECT_EQ(header.columns, 4u);
+    file.seekg(sizeof(header) + 8 + 24); // one step, the times and sun vectors are padded to 8 bytes
+    std::vector<float> values(4*12);
+    for (int c = 0; c < 4; ++c) // 12 floats need no padding
+        file.read(reinterpret_cast<char*>(values.data() + c*12), 12*sizeof(float));
+    ASSERT_TRUE(file.good());
+    for (std::size_t i = 0; i < 12; ++i) {
+        vec2d angles = field.get_angles(i);
+        if (!elevations[i]) {
+            EXPECT_TRUE(std::isnan(values[24 + i]));
+            EXPECT_TRUE(std::isnan(values[36 + i]));
+            continue;
+        }
+        EXPECT_EQ(values[24 + i], float(elevations[i]->getActuatorLengthFromElevationAngle(angles.x*gcf::degree)));
+        EXPECT_EQ(values[36 + i], float(hours[i]->getActuatorLengthFromHourAngle(angles.y*gcf::degree)));
+    }
+    file.close();
+    std::remove(fileName.c_str());
+
+    // one pair per heliostat
+    elevations.pop_back();
+    EXPECT_THROW(simulation.set_actuatorModels(elevations, hours), std::invalid_argument);
+    hours.pop_back();
+    simulation.set_actuatorModels(elevations, hours);
+    EXPECT_THROW(simulation.run(fileName), std::invalid_argument);
+    elevations[0] = nullptr;
+    EXPECT_THROW(simulation.set_actuatorModels(elevations, hours), std::invalid_argument);
+}
+
+TEST_F(AnnualSimulationTest, InvalidSettings) {
+    HeliostatField field(1);
+    AnnualSimulation simulation(&field, engine);
+    EXPECT_THROW(simulation.set_timeRange(10., 0., 1.), std::invalid_argument);
+    EXPECT_THROW(simulation.set_timeRange(0., 10., 0.), std::invalid_argument);
+    EXPECT_THROW(simulation.set_chunkSteps(0), std::invalid_argument);
+    EXPECT_THROW(simulation.set_actuatorModels(&elevationKM, nullptr), std::invalid_argument);
+    EXPECT_THROW(simulation.run("/nonexistent/directory/simulation.bin"), std::runtime_error);
+}
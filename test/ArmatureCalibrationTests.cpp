@@ -0,0 +1,169 @@
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "ArmatureCalibration.h"
+#include "ElevationAngleKM.h"
+#include "HourAngleKM.h"
+#include "TrackerArmature2A.h"
+#include "TrackerSolver2A.h"
+#include "Bluesolar.h"
+
+static vec3d rotate(const vec3d& a, double angle, const vec3d& v) {
+    return v*std::cos(angle) + cross(a, v)*std::sin(angle) + a*(dot(a, v)*(1. - std::cos(angle)));
+}
+
+class ArmatureCalibrationTest : public ::testing::Test {
+protected:
+    TrackerArmature2A nominal;
+    TrackerArmature2A actual; // the armature as built, with small geometry errors
+    ElevationAngleKM elevationKM = bluesolarElevationAngleKM();
+    HourAngleKM hourKM = bluesolarHourAngleKM();
+    ElevationAngleKM actualElevationKM = ElevationAngleKM(1.5566945190927768, 0.3679941188052566, 0.0872,
+                                                          0.4531, 0.08155204289894769 + 0.004, 0.0421);
+    HourAngleKM actualHourKM = HourAngleKM(0.543717625543648 - 0.003, 0.3716059721933388, 0.0514,
+                                           0.3402, 0.0391);
+    std::mt19937 random = std::mt19937(7);
+
+    void SetUp() override {
+        TrackerArmature2A::Geometry g = bluesolarGeometry();
+        nominal.set_geometry(g);
+
+        g.primaryShift = vec3d(0.012, -0.008, 2.431);
+        g.primaryAxis = vec3d(-1.0, 0.006, -0.004);
+        g.secondaryShift = vec3d(0.0, -0.0791, 0.006);
+        g.secondaryAxis = vec3d(0.005, -0.007, -1.0);
+        actual.set_geometry(g);
+    }
+
+    // beam point 50 m along the ray reflected by armature at the angles in radians
+    vec3d beam(const TrackerArmature2A& armature, const vec3d& vSun, const vec2d& angles) {
+        const CompiledArmature2A& c = armature.get_compiled();
+        vec3d p = TrackerSolver2A::findFacetPoint(c, angles);
+        vec3d n = rotate(c.a, angles.x, rotate(c.b, angles.y, c.facetNormal));
+        return p + (2.*dot(n, vSun)*n - vSun)*50.;
+    }
+
+    // observations at random sun positions and commanded angles of the actual heliostat,
+    // inputs are actuator lengths if models is true and commanded angles in degrees otherwise
+    std::vector<CalibrationObservation> observe(int count, bool models, const vec2d& angleOffsets, double noise) {
+        std::uniform_real_distribution<double> unit(0., 1.);
+        std::normal_distribution<double> gauss(0., noise);
+        std::vector<CalibrationObservation> ans;
+        for (int k = 0; k < count; ++k) {
+            CalibrationObservation o;
+            o.vSun = vec3d::directionAE((60. + 240.*unit(random))*gcf::degree, (10. + 70.*unit(random))*gcf::degree);
+            vec2d angles((5. + 80.*unit(random))*gcf::degree, (-45. + 90.*unit(random))*gcf::degree);
+            if (models) {
+                o.input = vec2d(actualElevationKM.getActuatorLengthFromElevationAngle(angles.x),
+                                actualHourKM.getActuatorLengthFromHourAngle(angles.y));
+            } else {
+                o.input = angles/gcf::degree;
+                angles += angleOffsets*gcf::degree;
+            }
+            o.beam = beam(actual, o.vSun, angles);
+            if (noise > 0.)
+                o.beam += vec3d(gauss(random), gauss(random), gauss(random));
+            ans.push_back(o);
+        }
+        return ans;
+    }
+};
+
+TEST_F(ArmatureCalibrationTest, ActuatorModels) {
+    std::vector<CalibrationObservation> observations = observe(40, true, vec2d(0., 0.), 0.);
+    CalibrationProblem problem{&nominal, &elevationKM, &hourKM, observations.data(), observations.size()};
+    ArmatureCalibration calibration(1);
+    CalibrationResult result = calibration.calibrate(problem);
+
+    EXPECT_TRUE(result.converged);
+    EXPECT_EQ(result.observations, 40u);
+    EXPECT_GT(result.rmsStart, 0.1);
+    EXPECT_LT(result.rms, 1e-8);
+    ASSERT_TRUE(result.elevation.has_value());
+    ASSERT_TRUE(result.hour.has_value());
+    EXPECT_EQ(result.angleOffsets, vec2d(0., 0.));
+    EXPECT_EQ(result.geometry.secondaryAngles, nominal.get_secondaryAngles());
+
+    // the fitted heliostat reflects as the actual one at other sun positions and lengths
+    TrackerArmature2A fitted(result.geometry);
+    for (const CalibrationObservation& o : observe(20, true, vec2d(0., 0.), 0.)) {
+        vec2d angles(result.elevation->getElevationAngleFromActuatorLength(o.input.x),
+                     result.hour->getHourAngleFromActuatorLength(o.input.y));
+        EXPECT_LT((beam(fitted, o.vSun, angles) - o.beam).norm(), 1e-6);
+        EXPECT_NEAR(angles.x, actualElevationKM.getElevationAngleFromActuatorLength(o.input.x), 1e-7);
+        EXPECT_NEAR(angles.y, actualHourKM.getHourAngleFromActuatorLength(o.input.y), 1e-7);
+    }
+
+    // observations out of the actuator ranges are skipped
+    observations[3].input.x = 10.;
+    observations[5].input.y = -10.;
+    result = calibration.calibrate(problem);
+    EXPECT_EQ(result.observations, 38u);
+    EXPECT_LT(result.rms, 1e-8);
+}
+
+TEST_F(ArmatureCalibrationTest, AngleOffsets) {
+    vec2d offsets(0.4, -0.7);
+    std::vector<CalibrationObservation> observations = observe(30, false, offsets, 0.);
+    CalibrationProblem problem{&nominal, nullptr, nullptr, observations.data(), observations.size()};
+    ArmatureCalibration calibration(1);
+    CalibrationResult result = calibration.calibrate(problem);
+
+    EXPECT_TRUE(result.converged);
+    EXPECT_LT(result.rms, 1e-8);
+    EXPECT_FALSE(result.elevation.has_value());
+    EXPECT_NEAR(result.angleOffsets.x, offsets.x, 1e-6);
+    EXPECT_NEAR(result.angleOffsets.y, offsets.y, 1e-6);
+    EXPECT_NEAR(result.geometry.primaryShift.z, actual.get_primaryShift().z, 1e-6);
+    EXPECT_NEAR(dot(result.geometry.secondaryAxis, actual.get_secondaryAxis().normalized()), 1., 1e-12);
+
+    // without the axes, the fit is limited by the axis errors
+    calibration.set_parameters(ArmatureCalibration::shifts | ArmatureCalibration::angleOffsets);
+    CalibrationResult partial = calibration.calibrate(problem);
+    EXPECT_EQ(partial.geometry.primaryAxis, nominal.get_primaryAxis());
+    EXPECT_GT(partial.rms, 1e-3);
+    EXPECT_LT(partial.rms, result.rmsStart);
+}
+
+TEST_F(ArmatureCalibrationTest, ParallelMatchesSerial) {
+    // beam points measured with 5 mm errors
+    std::vector<std::vector<CalibrationObservation>> observations;
+    std::vector<CalibrationProblem> problems;
+    for (int i = 0; i < 12; ++i)
+        observations.push_back(observe(40, true, vec2d(0., 0.), 0.005));
+    for (const std::vector<CalibrationObservation>& o : observations)
+        problems.push_back(CalibrationProblem{&nominal, &elevationKM, &hourKM, o.data(), o.size()});
+
+    ArmatureCalibration calibration(4);
+    std::vector<CalibrationResult> results = calibration.calibrate(problems);
+    ASSERT_EQ(results.size(), problems.size());
+    for (std::size_t i = 0; i < problems.size(); ++i) {
+        CalibrationResult serial = calibration.calibrate(problems[i]);
+        EXPECT_TRUE(results[i].converged);
+        EXPECT_EQ(results[i].rms, serial.rms);
+        EXPECT_EQ(results[i].iterations, serial.iterations);
+        EXPECT_EQ(results[i].geometry.primaryShift, serial.geometry.primaryShift);
+        EXPECT_EQ(results[i].hour->get_offset(), serial.hour->get_offset());
+        // the residuals are the errors across the rays, about 5 mm*sqrt(2)
+        EXPECT_LT(results[i].rms, 0.0075);
+        EXPECT_GT(results[i].rms, 0.005);
+    }
+}
+
+TEST_F(ArmatureCalibrationTest, InvalidInput) {
+    ArmatureCalibration calibration(1);
+    std::vector<CalibrationObservation> observations = observe(5, true, vec2d(0., 0.), 0.);
+    EXPECT_THROW(calibration.calibrate(CalibrationProblem{nullptr, &elevationKM, &hourKM, observations.data(), 5}), std::invalid_argument);
+    EXPECT_THROW(calibration.calibrate(CalibrationProblem{&nominal, &elevationKM, nullptr, observations.data(), 5}), std::invalid_argument);
+    EXPECT_THROW(calibration.calibrate(std::vector<CalibrationProblem>(3)), std::invalid_argument);
+
+    // nothing to fit without observations
+    CalibrationResult result = calibration.calibrate(CalibrationProblem{&nominal, nullptr, nullptr, nullptr, 0});
+    EXPECT_EQ(result.observations, 0u);
+    EXPECT_EQ(result.iterations, 0);
+    EXPECT_EQ(result.geometry.primaryShift, nominal.get_primaryShift());
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "ElevationAngleKM.h"
+#include "HourAngleKM.h"
+#include "TrackerArmature2A.h"
+#include "vec2d.h"
+#include "vec3d.h"
+
+// Bluesolar heliostat shared by the tests and the benchmarks:
+// the armature geometry and the actuator models of both axes.
+
+inline TrackerArmature2A::Geometry bluesolarGeometry() {
+    TrackerArmature2A::Geometry g;
+    g.primaryShift = vec3d(0.0, 0.0, 2.415);
+    g.primaryAxis = vec3d(-1.0, 0.0, 0.0);
+    g.primaryAngles = vec2d(0.0, 90.0);
+    g.secondaryShift = vec3d(0.0, -0.0816, 0.0);
+    g.secondaryAxis = vec3d(0.0, 0.0, -1.0);
+    g.secondaryAngles = vec2d(-70.0, 55.0);
+    g.facetShift = vec3d(0., -0.105, 0.035);
+    g.facetNormal = vec3d(0.0, -1.0, 0.0);
+    g.anglesDefault = vec2d(0.0, 0.0);
+    return g;
+}
+
+inline ElevationAngleKM bluesolarElevationAngleKM() {
+    return ElevationAngleKM(1.5566945190927768, 0.3679941188052566, 0.08587871211683747,
+                            0.45469491923653677, 0.08155204289894769, 0.04037);
+}
+
+inline HourAngleKM bluesolarHourAngleKM() {
+    return HourAngleKM(0.543717625543648, 0.3716059721933388, 0.05209218963038278,
+                       0.3390154085801952, 0.04037);
+}
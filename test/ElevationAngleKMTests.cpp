@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "gcf.h"
+#include <cmath>
+#include <vector>
 #include "ElevationAngleKM.h"
 
 class ElevationAngleKMTest : public ::testing::Test {  
@@ -76,3 +78,58 @@ TEST_F(ElevationAngleKMTest, SetAlpha2) {
     EXPECT_EQ(m_pElevationAngleKM->get_alpha2(), alpha2);
 }
 
+
+TEST_F(ElevationAngleKMTest, BatchMatchesScalar) {
+    // out of range inputs give NaN, the count is not a multiple of the SIMD width
+    std::vector<double> angles, lengths;
+    for (int i = 0; i < 103; ++i) {
+        angles.push_back((-10. + i)*gcf::degree);
+        lengths.push_back(0.2 + 0.003*i);
+    }
+    lengths[7] = 1.5;
+    lengths[50] = 2.;
+
+    std::vector<double> results(angles.size());
+    m_pElevationAngleKM->getActuatorLengthsFromElevationAngles(angles.size(), angles.data(), results.data());
+    for (std::size_t i = 0; i < angles.size(); ++i) {
+        double expected = m_pElevationAngleKM->getActuatorLengthFromElevationAngle(angles[i]);
+        if (std::isnan(expected))
+            EXPECT_TRUE(std::isnan(results[i]));
+        else
+            EXPECT_NEAR(results[i], expected, 1e-14);
+    }
+
+    m_pElevationAngleKM->getElevationAnglesFromActuatorLengths(lengths.size(), lengths.data(), results.data());
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        double expected = m_pElevationAngleKM->getElevationAngleFromActuatorLength(lengths[i]);
+        if (std::isnan(expected))
+            EXPECT_TRUE(std::isnan(results[i]));
+        else
+            EXPECT_NEAR(results[i], expected, 1e-14);
+    }
+    EXPECT_TRUE(std::isnan(results[7]));
+    EXPECT_TRUE(std::isnan(results[50]));
+}
+
+TEST_F(ElevationAngleKMTest, Approximation) {
+    Interval angles(0., 90.*gcf::degree);
+    ElevationAngleKM exact = *m_pElevationAngleKM;
+    m_pElevationAngleKM->setApproximation(angles, 1e-8, 1e-8);
+    ASSERT_TRUE(m_pElevationAngleKM->hasApproximation());
+
+    for (int i = 0; i <= 1000; ++i) {
+        double angle = angles.fromNormalized(i/1000.);
+        double length = exact.getActuatorLengthFromElevationAngle(angle);
+        EXPECT_NEAR(m_pElevationAngleKM->getActuatorLengthFromElevationAngle(angle), length, 1e-8);
+        EXPECT_NEAR(m_pElevationAngleKM->getElevationAngleFromActuatorLength(length), angle, 1e-8);
+    }
+
+    // rebuilt by the setters, exact outside the range
+    m_pElevationAngleKM->set_offset(0.05);
+    exact.set_offset(0.05);
+    EXPECT_NEAR(m_pElevationAngleKM->getActuatorLengthFromElevationAngle(0.5), exact.getActuatorLengthFromElevationAngle(0.5), 1e-8);
+    EXPECT_EQ(m_pElevationAngleKM->getActuatorLengthFromElevationAngle(-0.5), exact.getActuatorLengthFromElevationAngle(-0.5));
+
+    m_pElevationAngleKM->clearApproximation();
+    EXPECT_FALSE(m_pElevationAngleKM->hasApproximation());
+}
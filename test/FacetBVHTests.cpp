@@ -0,0 +1,156 @@
+#include <random>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "Facet.h"
+#include "FacetBVH.h"
+#include "FluxTracer.h"
+#include "HeliostatField.h"
+#include "Ray.h"
+#include "RayPacket.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+
+class FacetBVHTest : public ::testing::Test {
+protected:
+    TrackerArmature2A armature; // azimuth-elevation
+    HeliostatField field = HeliostatField(1);
+    vec2d size = vec2d(2.5, 2.);
+    vec3d rAim = vec3d(0., 0., 20.);
+
+    void SetUp() override {
+        // dense grid north of the receiver
+        TrackerTarget target;
+        target.aimingPoint = rAim;
+        for (int i = 0; i < 20; ++i)
+            for (int j = 0; j < 20; ++j)
+                field.addHeliostat(Transform::translate(-30. + 3.*i, 10. + 3.*j, 0.), &armature, target);
+    }
+
+    // closest facet by testing all of them
+    std::size_t bruteForce(const Ray& ray, std::size_t ignore) const {
+        std::size_t ans = FacetBVH::npos;
+        double tMax = ray.tMax;
+        for (std::size_t i = 0; i < field.size(); ++i) {
+            Ray r(ray.origin, ray.direction(), ray.tMin, tMax);
+            double t;
+            if (i != ignore && Facet::fromField(field, i, size).intersect(r, t)) {
+                ans = i;
+                tMax = t;
+            }
+        }
+        return ans;
+    }
+
+    void expectMatchesBruteForce(const FacetBVH& bvh, std::mt19937& rng) {
+        std::uniform_real_distribution<double> uniform(-1., 1.);
+        int hits = 0;
+        for (int k = 0; k < 2000; ++k) {
+            vec3d origin(35.*uniform(rng), 40. + 35.*uniform(rng), 2. + 3.*uniform(rng));
+            vec3d direction = vec3d(uniform(rng), uniform(rng), 0.3*uniform(rng)).normalized();
+            std::size_t ignore = k % 3 == 0 ? std::size_t(k) % field.size() : FacetBVH::npos;
+            Ray ray(origin, direction);
+            std::size_t expected = bruteForce(ray, ignore);
+            EXPECT_EQ(bvh.intersect(ray, ignore), expected);
+            EXPECT_EQ(bvh.occluded(Ray(origin, direction), ignore), expected != FacetBVH::npos);
+            hits += expected != FacetBVH::npos;
+        }
+        EXPECT_GT(hits, 100);
+        EXPECT_LT(hits, 1900);
+    }
+};
+
+TEST_F(FacetBVHTest, IntersectMatchesBruteForce) {
+    field.update(vec3d::directionAE(150.*gcf::degree, 40.*gcf::degree));
+    FacetBVH bvh;
+    bvh.build(field, size);
+    EXPECT_EQ(bvh.size(), field.size());
+    EXPECT_LT(bvh.nodes(), field.size());
+    for (std::size_t i = 0; i < field.size(); i += 37)
+        EXPECT_EQ(bvh.get_facet(i).center, Facet::fromField(field, i, size).center);
+
+    std::mt19937 rng(1);
+    expectMatchesBruteForce(bvh, rng);
+}
+
+TEST_F(FacetBVHTest, RefitFollowsAngles) {
+    field.update(vec3d::directionAE(150.*gcf::degree, 40.*gcf::degree));
+    FacetBVH bvh;
+    bvh.build(field, size);
+    std::size_t nodes = bvh.nodes();
+
+    field.update(vec3d::directionAE(220.*gcf::degree, 15.*gcf::degree));
+    bvh.refit(field);
+    EXPECT_EQ(bvh.nodes(), nodes);
+    for (std::size_t i = 0; i < field.size(); i += 37)
+        EXPECT_EQ(bvh.get_facet(i).normal, Facet::fromField(field, i, size).normal);
+
+    std::mt19937 rng(2);
+    expectMatchesBruteForce(bvh, rng);
+
+    HeliostatField other(1);
+    EXPECT_THROW(bvh.refit(other), std::invalid_argument);
+}
+
+TEST_F(FacetBVHTest, PacketsMatchSingleRays) {
+    field.update(vec3d::directionAE(150.*gcf::degree, 40.*gcf::degree));
+    FacetBVH bvh;
+    bvh.build(field, size);
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    int hits = 0;
+    for (int k = 0; k < 500; ++k) {
+        // coherent rays from nearby origins, with a partial packet now and then
+        vec3d origin(35.*uniform(rng), 40. + 35.*uniform(rng), 2. + 3.*uniform(rng));
+        vec3d direction(uniform(rng), uniform(rng), 0.3*uniform(rng));
+        Ray rays[RayPacket::Width];
+        std::size_t ignore[RayPacket::Width];
+        int count = k % 5 == 0 ? 3 : RayPacket::Width;
+        for (int lane = 0; lane < RayPacket::Width; ++lane) {
+            vec3d jitter(uniform(rng), uniform(rng), 0.1*uniform(rng));
+            rays[lane] = Ray(origin + jitter, (direction + 0.1*jitter).normalized());
+            ignore[lane] = (k + lane) % 4 == 0 ? std::size_t(k) % field.size() : FacetBVH::npos;
+        }
+        // an axis-aligned direction with zero components
+        if (k % 7 == 0) rays[1] = Ray(origin, vec3d(-1., 0., 0.));
+
+        RayPacket packet(rays, count);
+        std::size_t packetHits[RayPacket::Width];
+        bvh.intersect(packet, packetHits, ignore);
+        int mask = bvh.occluded(RayPacket(rays, count), ignore);
+        for (int lane = 0; lane < count; ++lane) {
+            Ray ray = rays[lane];
+            std::size_t expected = bvh.intersect(ray, ignore[lane]);
+            EXPECT_EQ(packetHits[lane], expected);
+            EXPECT_EQ(packet.tMax[lane], ray.tMax);
+            EXPECT_EQ((mask >> lane) & 1, expected != FacetBVH::npos ? 1 : 0);
+            hits += expected != FacetBVH::npos;
+        }
+        for (int lane = count; lane < RayPacket::Width; ++lane)
+            EXPECT_EQ(packetHits[lane], FacetBVH::npos);
+        EXPECT_EQ(mask >> count, 0);
+    }
+    EXPECT_GT(hits, 100);
+}
+
+TEST_F(FacetBVHTest, ShadingAndBlockingInFluxTracer) {
+    // low sun behind a dense field
+    vec3d vSun = vec3d::directionAE(180.*gcf::degree, 10.*gcf::degree);
+    field.update(vSun);
+    FacetBVH bvh;
+    bvh.build(field, size);
+
+    FluxTracer tracer(1);
+    tracer.set_facetSize(size);
+    FluxReceiver receiver(Transform::translate(rAim)*Transform::rotateX(-90.*gcf::degree), 20., 20., 10, 10);
+    FluxMap open = tracer.trace(field, vSun, receiver, 200);
+    FluxMap shadedBlocked = tracer.trace(field, vSun, receiver, 200, &bvh);
+    EXPECT_EQ(open.shaded + open.blocked, 0u);
+    EXPECT_GT(shadedBlocked.shaded, 0u);
+    EXPECT_GT(shadedBlocked.blocked, 0u);
+    EXPECT_EQ(shadedBlocked.hits + shadedBlocked.shaded + shadedBlocked.blocked, open.hits);
+    EXPECT_LT(shadedBlocked.power, open.power);
+}
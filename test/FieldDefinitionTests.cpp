@@ -0,0 +1,129 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "ElevationAngleKM.h"
+#include "FieldDefinition.h"
+#include "HeliostatField.h"
+#include "HourAngleKM.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+#include "Bluesolar.h"
+
+class FieldDefinitionTest : public ::testing::Test {
+protected:
+    TrackerArmature2A bluesolar{bluesolarGeometry()};
+    TrackerArmature2A azimuthElevation;
+    ElevationAngleKM elevationKM = bluesolarElevationAngleKM();
+    HourAngleKM hourKM = bluesolarHourAngleKM();
+
+    void SetUp() override {
+        azimuthElevation.set_primaryShift(vec3d(0.0, 0.0, 4.0));
+    }
+
+    // heliostats alternating between the two armatures, the Bluesolar ones with actuator models
+    void addHeliostats(HeliostatField& field) {
+        for (int i = 0; i < 20; ++i) {
+            double phi = (-60. + 6.*i)*gcf::degree;
+            double r = 20. + 2.*i;
+            TrackerTarget target;
+            target.aimingPoint = vec3d(0., 0., 20. + 0.1*i);
+            target.warmStart = i % 3 == 0;
+            Transform location = Transform::translate(r*sin(phi), r*cos(phi), 0.)*Transform::rotateZ(0.01*i);
+            field.addHeliostat(location, i % 2 == 0 ? &bluesolar : &azimuthElevation, target);
+        }
+    }
+};
+
+TEST_F(FieldDefinitionTest, SaveAndLoad) {
+    HeliostatField field(1);
+    addHeliostats(field);
+    FieldDefinition definition = FieldDefinition::fromField(field);
+    EXPECT_EQ(definition.armatures(), 2u);
+    EXPECT_EQ(definition.size(), 20u);
+    std::size_t models = definition.addModels(elevationKM, hourKM);
+    definition.addHeliostat(Transform::translate(0., 60., 0.), definition.get_armatureIndex(0), TrackerTarget(), models);
+
+    std::string fileName = ::testing::TempDir() + "field_definition_test.bin";
+    definition.save(fileName);
+    FieldDefinition loaded = FieldDefinition::load(fileName);
+    std::remove(fileName.c_str());
+
+    ASSERT_EQ(loaded.size(), 21u);
+    ASSERT_EQ(loaded.armatures(), 2u);
+    ASSERT_EQ(loaded.models(), 1u);
+    EXPECT_EQ(loaded.get_modelIndex(0), FieldDefinition::npos);
+    EXPECT_EQ(loaded.get_modelIndex(20), 0u);
+    EXPECT_EQ(loaded.get_elevationModel(0).get_alpha2(), elevationKM.get_alpha2());
+    EXPECT_EQ(loaded.get_hourModel(0).get_offset(), hourKM.get_offset());
+    EXPECT_EQ(loaded.get_hourModel(0).getActuatorLengthFromHourAngle(0.2), hourKM.getActuatorLengthFromHourAngle(0.2));
+    for (std::size_t i = 0; i < definition.size(); ++i) {
+        EXPECT_EQ(loaded.get_armatureIndex(i), definition.get_armatureIndex(i));
+        EXPECT_TRUE(loaded.get_location(i) == definition.get_location(i));
+        // the inverses are stored, not recomputed
+        EXPECT_EQ(std::memcmp(loaded.get_location(i).getInverseMatrix(), definition.get_location(i).getInverseMatrix(),
+                              sizeof(double[3][4])), 0);
+        EXPECT_EQ(loaded.get_target(i).aimingPoint, definition.get_target(i).aimingPoint);
+        EXPECT_EQ(loaded.get_target(i).warmStart, definition.get_target(i).warmStart);
+    }
+    const CompiledArmature2A& c = loaded.get_armature(loaded.get_armatureIndex(0))->get_compiled();
+    EXPECT_EQ(c.facetPoint0, bluesolar.get_compiled().facetPoint0);
+    EXPECT_EQ(c.secondaryAngles.max(), bluesolar.get_compiled().secondaryAngles.max());
+
+    // a field built from the loaded definition tracks as the original one
+    HeliostatField rebuilt(1);
+    loaded.addToField(rebuilt);
+    ASSERT_EQ(rebuilt.size(), 21u);
+    vec3d vSun = vec3d::directionAE(150.*gcf::degree, 50.*gcf::degree);
+    field.update(vSun);
+    rebuilt.update(vSun);
+    for (std::size_t i = 0; i < field.size(); ++i) {
+        EXPECT_EQ(rebuilt.get_angles(i).x, field.get_angles(i).x);
+        EXPECT_EQ(rebuilt.get_angles(i).y, field.get_angles(i).y);
+    }
+
+    // the models follow the heliostats of the field
+    std::vector<const ElevationAngleKM*> elevations;
+    std::vector<const HourAngleKM*> hours;
+    loaded.addToModels(elevations, hours);
+    ASSERT_EQ(elevations.size(), rebuilt.size());
+    ASSERT_EQ(hours.size(), rebuilt.size());
+    EXPECT_EQ(elevations[0], nullptr);
+    EXPECT_EQ(hours[19], nullptr);
+    EXPECT_EQ(elevations[20], &loaded.get_elevationModel(0));
+    EXPECT_EQ(hours[20], &loaded.get_hourModel(0));
+}
+
+TEST_F(FieldDefinitionTest, InvalidInput) {
+    FieldDefinition definition;
+    EXPECT_THROW(definition.addHeliostat(Transform::Identity, 0), std::out_of_range);
+    definition.addArmature(bluesolar);
+    EXPECT_THROW(definition.addHeliostat(Transform::Identity, 0, TrackerTarget(), 0), std::out_of_range);
+    definition.addHeliostat(Transform::Identity, 0);
+
+    EXPECT_THROW(FieldDefinition::load(::testing::TempDir() + "field_definition_missing.bin"), std::runtime_error);
+    EXPECT_THROW(definition.save("/nonexistent/directory/field.bin"), std::runtime_error);
+
+    // a truncated file
+    std::string fileName = ::testing::TempDir() + "field_definition_truncated.bin";
+    definition.save(fileName);
+    std::ifstream in(fileName, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+    std::ofstream out(fileName, std::ios::binary);
+    out.write(data.data(), data.size() - 8);
+    out.close();
+    EXPECT_THROW(FieldDefinition::load(fileName), std::runtime_error);
+
+    // not a field file
+    out.open(fileName, std::ios::binary);
+    out << "HTSUNEPH";
+    out.close();
+    EXPECT_THROW(FieldDefinition::load(fileName), std::runtime_error);
+    std::remove(fileName.c_str());
+}
@@ -0,0 +1,125 @@
+#include <cmath>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "FluxTracer.h"
+#include "HeliostatField.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+
+class FluxTracerTest : public ::testing::Test {
+protected:
+    TrackerArmature2A armature; // azimuth-elevation
+    vec3d rAim = vec3d(0., 0., 20.);
+    vec3d vSun = vec3d::directionAE(160.*gcf::degree, 45.*gcf::degree);
+    // receiver at the aiming point facing north
+    FluxReceiver receiver = FluxReceiver(Transform::translate(rAim)*Transform::rotateX(-90.*gcf::degree), 4., 4., 40, 40);
+
+    void addHeliostats(HeliostatField& field, int count) {
+        TrackerTarget target;
+        target.aimingPoint = rAim;
+        for (int i = 0; i < count; ++i) {
+            double phi = count == 1 ? 0. : (-60. + 120.*i/(count - 1))*gcf::degree;
+            double r = 30. + 0.5*i;
+            field.addHeliostat(Transform::translate(r*sin(phi), r*cos(phi), 0.), &armature, target);
+        }
+        field.update(vSun);
+    }
+};
+
+TEST_F(FluxTracerTest, ConservesPower) {
+    HeliostatField field(1);
+    addHeliostats(field, 1);
+    FluxTracer tracer(1);
+    tracer.set_facetSize(vec2d(2., 1.5));
+    tracer.set_reflectivity(0.9);
+    tracer.set_dni(800.);
+    receiver.width = receiver.height = 10.;
+
+    FluxMap map = tracer.trace(field, vSun, receiver, 100000);
+    EXPECT_EQ(map.rays, 100000u);
+    EXPECT_EQ(map.hits, map.rays);
+
+    // the facet normal bisects the sun and target directions
+    vec3d vTarget = (rAim - vec3d(0., 30., 0.)).normalized();
+    double cosIncidence = std::sqrt(0.5*(1. + dot(vSun, vTarget)));
+    EXPECT_NEAR(map.power/(800.*0.9*3.*cosIncidence), 1., 1e-4);
+
+    double sum = 0.;
+    for (double f : map.flux) sum += f;
+    EXPECT_NEAR(sum*(10./40)*(10./40), map.power, 1e-9*map.power);
+}
+
+TEST_F(FluxTracerTest, ImageCenteredOnAimingPoint) {
+    HeliostatField field(1);
+    addHeliostats(field, 1);
+    FluxTracer tracer(1);
+    tracer.set_slopeError(2e-3);
+
+    FluxMap map = tracer.trace(field, vSun, receiver, 200000);
+    EXPECT_EQ(map.hits, map.rays);
+    double x = 0., y = 0., sum = 0.;
+    for (int j = 0; j < map.ny; ++j) {
+        for (int i = 0; i < map.nx; ++i) {
+            x += map(i, j)*(i + 0.5);
+            y += map(i, j)*(j + 0.5);
+            sum += map(i, j);
+        }
+    }
+    EXPECT_NEAR(x/sum, 0.5*map.nx, 0.1);
+    EXPECT_NEAR(y/sum, 0.5*map.ny, 0.1);
+    // nothing reaches the corners
+    EXPECT_EQ(map(0, 0), 0.);
+    EXPECT_EQ(map(map.nx - 1, map.ny - 1), 0.);
+}
+
+TEST_F(FluxTracerTest, DeterministicForAnyThreads) {
+    HeliostatField field(1);
+    addHeliostats(field, 150);
+    FluxTracer tracer(1);
+    tracer.set_slopeError(1e-3);
+    FluxMap serial = tracer.trace(field, vSun, receiver, 2000);
+    EXPECT_GT(serial.hits, serial.rays/2);
+
+    tracer.set_threads(3);
+    FluxMap parallel = tracer.trace(field, vSun, receiver, 2000);
+    EXPECT_EQ(parallel.flux, serial.flux);
+    EXPECT_EQ(parallel.hits, serial.hits);
+    EXPECT_EQ(parallel.power, serial.power);
+
+    tracer.set_seed(7);
+    FluxMap other = tracer.trace(field, vSun, receiver, 2000);
+    EXPECT_NE(other.flux, serial.flux);
+    EXPECT_NEAR(other.power, serial.power, 0.02*serial.power);
+}
+
+TEST_F(FluxTracerTest, LargeReceiver) {
+    // 4M bins, the heliostats are traced in fewer groups to bound the partial maps
+    HeliostatField field(1);
+    addHeliostats(field, 50);
+    FluxTracer tracer(1);
+    FluxMap coarse = tracer.trace(field, vSun, receiver, 500);
+    FluxReceiver fine = receiver;
+    fine.nx = fine.ny = 2000;
+    FluxMap serial = tracer.trace(field, vSun, fine, 500);
+    EXPECT_EQ(serial.hits, coarse.hits);
+    EXPECT_NEAR(serial.power, coarse.power, 1e-9*coarse.power);
+
+    tracer.set_threads(3);
+    FluxMap parallel = tracer.trace(field, vSun, fine, 500);
+    EXPECT_EQ(parallel.flux, serial.flux);
+    EXPECT_EQ(parallel.power, serial.power);
+}
+
+TEST_F(FluxTracerTest, InvalidReceiver) {
+    HeliostatField field(1);
+    addHeliostats(field, 1);
+    FluxTracer tracer(1);
+    receiver.nx = 0;
+    EXPECT_THROW(tracer.trace(field, vSun, receiver, 10), std::invalid_argument);
+    receiver.nx = 10;
+    receiver.width = 0.;
+    EXPECT_THROW(tracer.trace(field, vSun, receiver, 10), std::invalid_argument);
+}
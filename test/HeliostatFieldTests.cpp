@@ -0,0 +1,191 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "HeliostatField.h"
+#include "TrackerArmature2A.h"
+#include "TrackerTarget.h"
+#include "Transform.h"
+#include "Bluesolar.h"
+
+class HeliostatFieldTest : public ::testing::Test {
+protected:
+    TrackerArmature2A bluesolar{bluesolarGeometry()};
+    TrackerArmature2A azimuthElevation;
+    std::vector<Transform> locations;
+    std::vector<TrackerTarget> targets;
+
+    void SetUp() override {
+        for (int i = 0; i < 500; ++i) {
+            double phi = (-70. + 0.28*i)*gcf::degree;
+            double r = 15. + 0.1*i;
+            locations.push_back(Transform::translate(r*sin(phi), r*cos(phi), 0.));
+            TrackerTarget target;
+            target.aimingPoint = vec3d(0., 0., 20.);
+            if (i % 5 == 0) {
+                target.aimingType = TrackerTarget::local;
+                target.aimingPoint = vec3d(-r*sin(phi), -r*cos(phi), 20.);
+            }
+            target.warmStart = i % 2 == 0;
+            targets.push_back(target);
+        }
+    }
+
+    TrackerArmature2A* armature(std::size_t i) { return i % 3 == 0 ? &azimuthElevation : &bluesolar; }
+};
+
+TEST_F(HeliostatFieldTest, AddHeliostat) {
+    HeliostatField field(2);
+    EXPECT_EQ(field.size(), 0u);
+    EXPECT_EQ(field.addHeliostat(locations[0], &bluesolar, targets[0]), 0u);
+    EXPECT_EQ(field.addHeliostat(locations[1], &azimuthElevation), 1u);
+    EXPECT_EQ(field.size(), 2u);
+    EXPECT_EQ(field.get_armature(1), &azimuthElevation);
+    EXPECT_EQ(field.get_angles().size(), 4u);
+    field.clear();
+    EXPECT_EQ(field.size(), 0u);
+}
+
+TEST_F(HeliostatFieldTest, UpdateMatchesSerial) {
+    HeliostatField field(4);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.addHeliostat(locations[i], armature(i), targets[i]);
+
+    // several sun positions so that warm-started targets use their previous angles
+    for (int step = 0; step < 3; ++step) {
+        vec3d vSun = vec3d::directionAE((150. + 5.*step)*gcf::degree, (50. + 2.*step)*gcf::degree);
+        field.update(vSun);
+        for (std::size_t i = 0; i < locations.size(); ++i) {
+            armature(i)->update(locations[i], vSun, &targets[i]);
+            EXPECT_EQ(field.get_angles(i), targets[i].angles);
+            EXPECT_EQ(field.get_target(i).angles, targets[i].angles);
+            EXPECT_EQ(field.get_target(i).iterations, targets[i].iterations);
+        }
+    }
+}
+
+TEST_F(HeliostatFieldTest, SetThreads) {
+    HeliostatField field(1);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.addHeliostat(locations[i], armature(i), targets[i]);
+    vec3d vSun = vec3d::directionAE(120.*gcf::degree, 35.*gcf::degree);
+    field.update(vSun);
+    std::vector<double> serial = field.get_angles();
+
+    field.set_threads(3);
+    EXPECT_EQ(field.get_threads(), 3);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.get_target(i) = targets[i];
+    field.update(vSun);
+    EXPECT_EQ(field.get_angles(), serial);
+}
+
+// angle between the facet normals in the field frame for two sets of angles in degrees
+static double normalAngle(TrackerArmature2A* armature, const Transform& location, const vec2d& a, const vec2d& b)
+{
+    auto normal = [&](const vec2d& angles) {
+        Transform rotation = armature->get_primary().getTransform(angles.x*gcf::degree)*armature->get_secondary().getTransform(angles.y*gcf::degree);
+        return location.transformVector(rotation.transformVector(armature->get_facet().normal));
+    };
+    vec3d na = normal(a);
+    vec3d nb = normal(b);
+    return std::atan2(cross(na, nb).norm(), dot(na, nb));
+}
+
+TEST_F(HeliostatFieldTest, IncrementalUpdateSkipsWithinTolerance) {
+    HeliostatField field(2);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.addHeliostat(locations[i], armature(i), targets[i]);
+
+    // nothing solved yet
+    vec3d vSun0 = vec3d::directionAE(150.*gcf::degree, 50.*gcf::degree);
+    EXPECT_EQ(field.update(vSun0, 1e-3), 0u);
+    EXPECT_EQ(field.get_skipped(), 0u);
+
+    // the sun moves in small steps, the skipped heliostats stay within the tolerance
+    // up to the first order estimate and the solver tolerance
+    const double tolerance = 1e-3;
+    std::size_t skippedTotal = 0;
+    for (int step = 1; step <= 20; ++step) {
+        vec3d vSun = vec3d::directionAE((150. + 0.02*step)*gcf::degree, (50. + 0.01*step)*gcf::degree);
+        std::size_t skipped = field.update(vSun, tolerance);
+        EXPECT_EQ(field.get_skipped(), skipped);
+        skippedTotal += skipped;
+        for (std::size_t i = 0; i < locations.size(); ++i) {
+            TrackerTarget target = field.get_target(i);
+            armature(i)->update(locations[i], vSun, &target);
+            EXPECT_LT(normalAngle(armature(i), locations[i], field.get_angles(i), target.angles), 1.1*tolerance);
+        }
+    }
+    // most steps skip most heliostats, but the drift forces them to be solved again
+    EXPECT_GT(skippedTotal, 10*locations.size());
+    EXPECT_LT(skippedTotal, 20*locations.size());
+
+    field.update(vSun0);
+    EXPECT_EQ(field.get_skipped(), 0u);
+}
+
+TEST_F(HeliostatFieldTest, IncrementalUpdateFollowsTargets) {
+    HeliostatField field(2);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.addHeliostat(locations[i], armature(i), targets[i]);
+    vec3d vSun = vec3d::directionAE(120.*gcf::degree, 35.*gcf::degree);
+    field.update(vSun);
+    std::size_t tracking = 0;
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        tracking += field.get_target(i).tracking;
+
+    // same sun and targets, only heliostats without a solution are solved again
+    EXPECT_EQ(field.update(vSun, 0.), tracking);
+
+    // a moved target is solved again
+    ASSERT_TRUE(field.get_target(1).tracking);
+    field.get_target(1).aimingPoint += vec3d(0., 0., 5.);
+    EXPECT_EQ(field.update(vSun, 1e-3), tracking - 1);
+    TrackerTarget target = targets[1];
+    target.aimingPoint += vec3d(0., 0., 5.);
+    armature(1)->update(locations[1], vSun, &target);
+    EXPECT_EQ(field.get_angles(1), target.angles);
+}
+
+TEST_F(HeliostatFieldTest, IncrementalUpdateFollowsGeometry) {
+    HeliostatField field(2);
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        field.addHeliostat(locations[i], armature(i), targets[i]);
+    vec3d vSun = vec3d::directionAE(120.*gcf::degree, 35.*gcf::degree);
+    field.update(vSun);
+    std::size_t tracking = 0;
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        tracking += field.get_target(i).tracking;
+    EXPECT_EQ(field.update(vSun, 1e-3), tracking);
+
+    // a new geometry of the shared armature, e.g. from a calibration, solves its heliostats again
+    TrackerArmature2A::Geometry geometry = bluesolar.get_geometry();
+    geometry.facetShift += vec3d(0., 0.1, 0.2);
+    bluesolar.set_geometry(geometry);
+    std::size_t skipped = 0;
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        skipped += armature(i) != &bluesolar && field.get_target(i).tracking;
+    EXPECT_EQ(field.update(vSun, 1e-3), skipped);
+    for (std::size_t i = 0; i < locations.size(); ++i) {
+        TrackerTarget target = targets[i];
+        armature(i)->update(locations[i], vSun, &target);
+        if (target.tracking)
+            EXPECT_LT(normalAngle(armature(i), locations[i], field.get_angles(i), target.angles), 1e-4); // stale angles are about 1e-2 off
+    }
+
+    // a single setter as well
+    bluesolar.set_anglesDefault(vec2d(1., 1.));
+    EXPECT_EQ(field.update(vSun, 1e-3), skipped);
+
+    // a moved heliostat is solved again
+    tracking = 0;
+    for (std::size_t i = 0; i < locations.size(); ++i)
+        tracking += field.get_target(i).tracking;
+    ASSERT_TRUE(field.get_target(1).tracking);
+    field.set_location(1, Transform::translate(0., 10., 0.)*locations[1]);
+    EXPECT_EQ(field.update(vSun, 1e-3), tracking - 1);
+    TrackerTarget target = targets[1];
+    armature(1)->update(Transform::translate(0., 10., 0.)*locations[1], vSun, &target);
+    EXPECT_EQ(field.get_angles(1), target.angles);
+}
@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "gcf.h"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
 #include "HourAngleKM.h"
 
 class HourAngleKMTests : public ::testing::Test {  
@@ -67,3 +70,56 @@ TEST_F(HourAngleKMTests, SetRad) {
     m_pHourAngleKM->set_rad(rad);
     EXPECT_EQ(m_pHourAngleKM->get_rad(), rad);
 }
+
+TEST_F(HourAngleKMTests, BatchMatchesScalar) {
+    // out of range inputs give NaN, the count is not a multiple of the SIMD width
+    std::vector<double> angles, lengths;
+    for (int i = 0; i < 103; ++i) {
+        angles.push_back((-60. + 1.2*i)*gcf::degree);
+        lengths.push_back(0.2 + 0.003*i);
+    }
+    lengths[7] = 1.5;
+    lengths[50] = 2.;
+
+    std::vector<double> results(angles.size());
+    m_pHourAngleKM->getActuatorLengthsFromHourAngles(angles.size(), angles.data(), results.data());
+    for (std::size_t i = 0; i < angles.size(); ++i) {
+        double expected = m_pHourAngleKM->getActuatorLengthFromHourAngle(angles[i]);
+        if (std::isnan(expected))
+            EXPECT_TRUE(std::isnan(results[i]));
+        else
+            EXPECT_NEAR(results[i], expected, 1e-14);
+    }
+
+    m_pHourAngleKM->getHourAnglesFromActuatorLengths(lengths.size(), lengths.data(), results.data());
+    for (std::size_t i = 0; i < lengths.size(); ++i) {
+        double expected = m_pHourAngleKM->getHourAngleFromActuatorLength(lengths[i]);
+        if (std::isnan(expected))
+            EXPECT_TRUE(std::isnan(results[i]));
+        else
+            EXPECT_NEAR(results[i], expected, 1e-14);
+    }
+    EXPECT_TRUE(std::isnan(results[7]));
+    EXPECT_TRUE(std::isnan(results[50]));
+}
+
+TEST_F(HourAngleKMTests, Approximation) {
+    Interval angles(-30.*gcf::degree, 55.*gcf::degree);
+    HourAngleKM exact = *m_pHourAngleKM;
+    m_pHourAngleKM->setApproximation(angles, 1e-8, 1e-8);
+    ASSERT_TRUE(m_pHourAngleKM->hasApproximation());
+
+    std::vector<double> input, results(1001);
+    for (int i = 0; i <= 1000; ++i)
+        input.push_back(angles.fromNormalized(i/1000.));
+    m_pHourAngleKM->getActuatorLengthsFromHourAngles(input.size(), input.data(), results.data());
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        double length = exact.getActuatorLengthFromHourAngle(input[i]);
+        EXPECT_NEAR(results[i], length, 1e-8);
+        EXPECT_NEAR(m_pHourAngleKM->getHourAngleFromActuatorLength(length), input[i], 1e-8);
+    }
+
+    // the length has a minimum at -70 degrees, so the inverse is singular
+    EXPECT_THROW(m_pHourAngleKM->setApproximation(Interval(-70.*gcf::degree, 55.*gcf::degree)), std::exception);
+    EXPECT_FALSE(m_pHourAngleKM->hasApproximation());
+}
@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "gcf.h"
+#include "PiecewiseChebyshev.h"
+
+TEST(PiecewiseChebyshevTest, DefaultIsEmpty) {
+    PiecewiseChebyshev p;
+    EXPECT_TRUE(p.isEmpty());
+    EXPECT_FALSE(p.isInside(0.));
+}
+
+TEST(PiecewiseChebyshevTest, MeetsTolerance) {
+    auto f = [](double x) { return std::sin(x)*std::exp(-x); };
+    PiecewiseChebyshev p(f, Interval(0., gcf::Pi), 1e-10);
+    EXPECT_FALSE(p.isEmpty());
+    EXPECT_LE(p.get_error(), 0.5e-10); // margin at the test points
+
+    // check points other than the ones used in the constructor
+    double error = 0.;
+    for (int i = 0; i <= 9973; ++i) {
+        double x = gcf::Pi*i/9973;
+        error = std::max(error, std::abs(p(x) - f(x)));
+    }
+    EXPECT_LE(error, 1e-10);
+}
+
+TEST(PiecewiseChebyshevTest, ExactForPolynomials) {
+    auto f = [](double x) { return 1. - 2.*x + 3.*x*x*x; };
+    PiecewiseChebyshev p(f, Interval(-2., 3.), 1e-12, 3);
+    EXPECT_EQ(p.get_segments(), 1);
+    EXPECT_NEAR(p(0.5), f(0.5), 1e-12);
+    EXPECT_NEAR(p(3.), f(3.), 1e-12);
+}
+
+TEST(PiecewiseChebyshevTest, InvalidInput) {
+    auto f = [](double x) { return std::sqrt(x); };
+    EXPECT_THROW(PiecewiseChebyshev(f, Interval(0., 1.), 1e-12), std::runtime_error); // singular derivative
+    EXPECT_THROW(PiecewiseChebyshev(f, Interval(-1., 1.), 1e-6), std::invalid_argument); // NaN
+    EXPECT_THROW(PiecewiseChebyshev(f, Interval(), 1e-6), std::invalid_argument);
+}
+
+TEST(PiecewiseChebyshevTest, Pair) {
+    PiecewiseChebyshevPair pair;
+    EXPECT_TRUE(pair.isEmpty());
+    pair.refit([](double x) { return x; }, [](double x) { return x; }); // nothing to refit
+    EXPECT_TRUE(pair.isEmpty());
+
+    pair.fit([](double x) { return std::exp(x); }, [](double y) { return std::log(y); },
+             Interval(0., 2.), 1e-10, 1e-9);
+    EXPECT_FALSE(pair.isEmpty());
+    EXPECT_NEAR(pair.get_function().get_interval().min(), 0., 1e-15);
+    EXPECT_NEAR(pair.get_inverse().get_interval().min(), 1., 1e-12);
+    EXPECT_NEAR(pair.get_inverse().get_interval().max(), std::exp(2.), 1e-12);
+    EXPECT_NEAR(pair.get_inverse()(3.), std::log(3.), 1e-9);
+
+    // same interval and tolerances for new functions
+    pair.refit([](double x) { return 2.*std::exp(x); }, [](double y) { return std::log(y/2.); });
+    EXPECT_NEAR(pair.get_function()(1.), 2.*std::exp(1.), 1e-9);
+    EXPECT_NEAR(pair.get_inverse().get_interval().max(), 2.*std::exp(2.), 1e-12);
+
+    // a failed fit leaves the pair empty
+    EXPECT_THROW(pair.fit([](double x) { return std::sqrt(x); }, [](double y) { return y*y; },
+                          Interval(0., 1.), 1e-12, 1e-12), std::runtime_error);
+    EXPECT_TRUE(pair.isEmpty());
+
+    pair.fit([](double x) { return x; }, [](double y) { return y; }, Interval(0., 1.), 1e-12, 1e-12);
+    pair.clear();
+    EXPECT_TRUE(pair.isEmpty());
+}
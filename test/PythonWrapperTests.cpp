@@ -1,8 +1,13 @@
+#include <cstdio>
+#include <cstring>
+
 #include "gtest/gtest.h"
 #include "pybind11/embed.h"
+#include "pybind11/numpy.h"
 #include "pybind11/pybind11.h"
 #include "pybind11/stl.h"
 #include "gcf.h"
+#include "ResultStore.h"
 #include "vec3d.h"
 #include "vec2d.h"
 
@@ -162,4 +167,148 @@ TEST_F(PythonWrapperTest, HourAngleKMTest) {
 
     auto length = hour_angle_km.attr("get_actuator_length_from_hour_angle")(30.2 * gcf::degree);
     EXPECT_NEAR(length.cast<double>(), 0.455544478465155, 0.001);
-}
\ No newline at end of file
+}
+
+// Test the NumPy batch update against per-heliostat updates
+TEST_F(PythonWrapperTest, TrackerArmature2AUpdateBatchTest) {
+    auto vec3d_class = heliostat_tracking_module.attr("vec3d");
+    auto vec2d_class = heliostat_tracking_module.attr("vec2d");
+    auto transform_class = heliostat_tracking_module.attr("Transform");
+    auto armature_class = heliostat_tracking_module.attr("TrackerArmature2A");
+    auto target_class = heliostat_tracking_module.attr("TrackerTarget");
+    py::module np = py::module::import("numpy");
+
+    auto armature = armature_class();
+    armature.attr("set_primary_shift")(vec3d_class(0.0, 0.0, 2.415));
+    armature.attr("set_primary_axis")(vec3d_class(-1.0, 0.0, 0.0));
+    armature.attr("set_primary_angles")(vec2d_class(0.0, 90.0));
+    armature.attr("set_secondary_shift")(vec3d_class(0.0, -0.0816, 0.0));
+    armature.attr("set_secondary_axis")(vec3d_class(0.0, 0.0, -1.0));
+    armature.attr("set_secondary_angles")(vec2d_class(-70.0, 55.0));
+    armature.attr("set_facet_shift")(vec3d_class(0.0, -0.105, 0.035));
+    armature.attr("set_facet_normal")(vec3d_class(0.0, -1.0, 0.0));
+
+    const py::ssize_t n = 5;
+    py::array_t<double> transforms({n, py::ssize_t(4), py::ssize_t(4)});
+    auto t = transforms.mutable_unchecked<3>();
+    for (py::ssize_t i = 0; i < n; ++i) {
+        for (py::ssize_t r = 0; r < 4; ++r)
+            for (py::ssize_t c = 0; c < 4; ++c)
+                t(i, r, c) = r == c ? 1.0 : 0.0;
+        t(i, 0, 3) = -10.0 + 5.0*i;
+        t(i, 1, 3) = 50.0 + 3.0*i;
+    }
+
+    double sun_azimuth = 160.0 * gcf::degree;
+    double sun_elevation = 55.0 * gcf::degree;
+    vec3d sun_vector = vec3d(cos(sun_elevation) * sin(sun_azimuth), cos(sun_elevation) * cos(sun_azimuth), sin(sun_elevation));
+    auto sun = np.attr("array")(vec3d_to_tuple(sun_vector));
+    auto aiming_point = np.attr("array")(py::make_tuple(0.0, 0.0, 20.0));
+
+    auto angles = armature.attr("update_batch")(sun, aiming_point, "transforms"_a = transforms).cast<py::array_t<double>>();
+    ASSERT_EQ(angles.ndim(), 2);
+    ASSERT_EQ(angles.shape(0), n);
+    ASSERT_EQ(angles.shape(1), 2);
+
+    for (py::ssize_t i = 0; i < n; ++i) {
+        auto target = target_class();
+        target.attr("aiming_point") = vec3d_class(0.0, 0.0, 20.0);
+        auto location = transform_class(
+            1.0, 0.0, 0.0, t(i, 0, 3),
+            0.0, 1.0, 0.0, t(i, 1, 3),
+            0.0, 0.0, 1.0, 0.0,
+            0.0, 0.0, 0.0, 1.0
+        );
+        armature.attr("update")(location, sun_vector, target);
+        EXPECT_NEAR(angles.at(i, 0), target.attr("angles").attr("x").cast<double>(), 1e-9);
+        EXPECT_NEAR(angles.at(i, 1), target.attr("angles").attr("y").cast<double>(), 1e-9);
+    }
+
+    // sun vectors and aiming points already in the heliostat frames, one row per heliostat
+    auto translations = transforms[py::make_tuple(py::slice(0, n, 1), py::slice(0, 3, 1), 3)];
+    auto local_aiming_points = aiming_point - translations;
+    auto sun_vectors = np.attr("tile")(sun, py::make_tuple(n, 1));
+    auto angles_local = armature.attr("update_batch")(sun_vectors, local_aiming_points).cast<py::array_t<double>>();
+    EXPECT_TRUE(np.attr("allclose")(angles_local, angles, "rtol"_a = 0.0, "atol"_a = 1e-9).cast<bool>());
+
+    EXPECT_THROW(armature.attr("update_batch")(np.attr("zeros")(py::make_tuple(n, 2)), aiming_point), py::error_already_set);
+    EXPECT_THROW(armature.attr("update_batch")(sun, aiming_point, "aiming_type"_a = "polar"), py::error_already_set);
+}
+
+// Test the thread count setting and the NumPy kinematic model conversions
+TEST_F(PythonWrapperTest, KinematicModelBatchTest) {
+    heliostat_tracking_module.attr("set_thread_count")(3);
+    EXPECT_EQ(heliostat_tracking_module.attr("get_thread_count")().cast<int>(), 3);
+
+    py::module np = py::module::import("numpy");
+    auto elevation_angle_km = heliostat_tracking_module.attr("ElevationAngleKM")(
+        1.5566945190927768, 0.3679941188052566, 0.08587871211683747, 0.45469491923653677, 0.08155204289894769, 0.04037);
+    auto hour_angle_km = heliostat_tracking_module.attr("HourAngleKM")(
+        0.543717625543648, 0.3716059721933388, 0.05209218963038278, 0.3390154085801952, 0.04037);
+
+    auto angles = np.attr("linspace")(5.0 * gcf::degree, 85.0 * gcf::degree, 10000).attr("reshape")(100, 100);
+    auto lengths = elevation_angle_km.attr("get_actuator_lengths_from_elevation_angles")(angles).cast<py::array_t<double>>();
+    ASSERT_EQ(lengths.ndim(), 2);
+    ASSERT_EQ(lengths.shape(0), 100);
+    auto angles_back = elevation_angle_km.attr("get_elevation_angles_from_actuator_lengths")(lengths);
+    EXPECT_TRUE(np.attr("allclose")(angles_back, angles, "rtol"_a = 0.0, "atol"_a = 1e-9).cast<bool>());
+    EXPECT_EQ(lengths.at(12, 34), elevation_angle_km.attr("get_actuator_length_from_elevation_angle")(
+        angles[py::make_tuple(12, 34)]).cast<double>());
+
+    auto hour_angles = np.attr("linspace")(-40.0 * gcf::degree, 40.0 * gcf::degree, 1001);
+    auto hour_lengths = hour_angle_km.attr("get_actuator_lengths_from_hour_angles")(hour_angles).cast<py::array_t<double>>();
+    EXPECT_EQ(hour_lengths.at(500), hour_angle_km.attr("get_actuator_length_from_hour_angle")(0.0).cast<double>());
+    auto hour_angles_back = hour_angle_km.attr("get_hour_angles_from_actuator_lengths")(hour_lengths);
+    EXPECT_TRUE(np.attr("allclose")(hour_angles_back, hour_angles, "rtol"_a = 0.0, "atol"_a = 1e-9).cast<bool>());
+
+    heliostat_tracking_module.attr("set_thread_count")(0);
+}
+
+// Test the zero-copy NumPy views of a result file
+TEST_F(PythonWrapperTest, ResultStoreTest) {
+    SimulationFileHeader header;
+    std::memcpy(header.magic, SimulationFileHeader::Magic, sizeof(header.magic));
+    header.version = SimulationFileHeader::Version;
+    header.columns = 2;
+    header.heliostats = 3;
+    header.steps = 5;
+    header.chunkSteps = 5;
+    header.timeStart = 1.7e9;
+    header.step = 60.;
+    header.longitude = 0.;
+    header.latitude = 0.;
+    std::string fileName = ::testing::TempDir() + "python_result_store.bin";
+    {
+        ResultStore store;
+        store.create(fileName, header);
+        for (std::uint64_t j = 0; j < header.steps; ++j) {
+            store.times(0)[j] = header.timeStart + header.step*j;
+            for (std::size_t i = 0; i < header.heliostats; ++i)
+                store.values(j, SimulationFileHeader::secondaryAngle)[i] = float(10*j + i);
+        }
+    }
+
+    py::module np = py::module::import("numpy");
+    auto column = heliostat_tracking_module.attr("Column");
+    auto store = heliostat_tracking_module.attr("ResultStore")(fileName);
+    EXPECT_EQ(store.attr("steps").cast<int>(), 5);
+    EXPECT_EQ(store.attr("find_step")(header.timeStart + 130.).cast<int>(), 2);
+    EXPECT_TRUE(store.attr("find_step")(header.timeStart - 60.).is_none());
+
+    auto angles = store.attr("chunk")(0, column.attr("secondary_angle")).cast<py::array_t<float>>();
+    ASSERT_EQ(angles.ndim(), 2);
+    EXPECT_EQ(angles.shape(0), 5);
+    EXPECT_EQ(angles.shape(1), 3);
+    EXPECT_EQ(angles.at(4, 2), 42.f);
+    EXPECT_FALSE(angles.writeable());
+    auto values = store.attr("values")(3, column.attr("secondary_angle")).cast<py::array_t<float>>();
+    EXPECT_EQ(values.data(), angles.data() + 9);
+    EXPECT_EQ(store.attr("times")().cast<py::array_t<double>>().at(4), header.timeStart + 240.);
+    EXPECT_THROW(store.attr("chunk")(0, column.attr("hour_length")), py::error_already_set);
+
+    // the array keeps the file mapped
+    store = py::none();
+    EXPECT_EQ(angles.at(1, 0), 10.f);
+    angles = py::array_t<float>();
+    std::remove(fileName.c_str());
+}
@@ -0,0 +1,169 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "ResultStore.h"
+#include "TrackerArmature2A.h"
+#include "TrackerSolver2A.h"
+#include "Bluesolar.h"
+
+class ResultStoreTest : public ::testing::Test {
+protected:
+    SimulationFileHeader header;
+
+    void SetUp() override {
+        std::memcpy(header.magic, SimulationFileHeader::Magic, sizeof(header.magic));
+        header.version = SimulationFileHeader::Version;
+        header.columns = 4;
+        header.heliostats = 5;
+        header.steps = 10;
+        header.chunkSteps = 4;
+        header.timeStart = 1.7e9;
+        header.step = 900.;
+        header.longitude = -2.46*gcf::degree;
+        header.latitude = 37.09*gcf::degree;
+    }
+};
+
+TEST_F(ResultStoreTest, CreateAndOpen) {
+    std::string fileName = ::testing::TempDir() + "result_store_test.bin";
+    {
+        ResultStore store;
+        store.create(fileName, header);
+        EXPECT_TRUE(store.isWritable());
+        EXPECT_EQ(store.chunks(), 3u);
+        for (std::uint64_t j = 0; j < header.steps; ++j) {
+            store.times(j/4)[j%4] = header.timeStart + header.step*j;
+            store.sunVectors(j/4)[3*(j%4) + 2] = 0.1*j;
+            vec2fArrayView angles = store.angles(j);
+            for (std::size_t i = 0; i < header.heliostats; ++i) {
+                angles.set(i, vec2f(float(j), float(i)));
+                store.values(j, SimulationFileHeader::hourLength)[i] = float(10*j + i);
+            }
+        }
+        store.flush();
+    }
+
+    std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+    EXPECT_EQ(std::uint64_t(file.tellg()), sizeof(header) + 2*header.chunkBytes(4) + header.chunkBytes(2));
+    file.close();
+
+    ResultStore store;
+    store.open(fileName);
+    EXPECT_FALSE(store.isWritable());
+    // a read-only store gives no writable pointers
+    EXPECT_THROW(store.values(0, SimulationFileHeader::hourLength), std::logic_error);
+    EXPECT_THROW(store.angles(0), std::logic_error);
+    EXPECT_THROW(store.times(0), std::logic_error);
+    const ResultStore& reader = store;
+    EXPECT_EQ(store.heliostats(), 5u);
+    EXPECT_EQ(store.steps(), 10u);
+    EXPECT_EQ(store.get_header().latitude, header.latitude);
+    for (std::uint64_t j = 0; j < header.steps; ++j) {
+        EXPECT_EQ(store.get_time(j), header.timeStart + header.step*j);
+        EXPECT_EQ(store.get_sunVector(j).z, 0.1*j);
+        vec2ArrayView<const float> angles = reader.angles(j);
+        for (std::size_t i = 0; i < header.heliostats; ++i) {
+            EXPECT_EQ(angles[i].x, float(j));
+            EXPECT_EQ(angles[i].y, float(i));
+            EXPECT_EQ(reader.values(j, SimulationFileHeader::hourLength)[i], float(10*j + i));
+            EXPECT_EQ(reader.values(j, SimulationFileHeader::elevationLength)[i], 0.f);
+        }
+    }
+    // a column of a chunk holds its steps one after the other
+    EXPECT_EQ(reader.column(2, SimulationFileHeader::primaryAngle) + 5, reader.values(9, SimulationFileHeader::primaryAngle));
+
+    EXPECT_EQ(store.findStep(header.timeStart + 3.4*header.step), 3u);
+    EXPECT_EQ(store.findStep(header.timeStart + 9.*header.step), 9u);
+    EXPECT_EQ(store.findStep(header.timeStart - header.step), ResultStore::npos);
+    EXPECT_EQ(store.findStep(header.timeStart + 10.*header.step), ResultStore::npos);
+    EXPECT_THROW(reader.values(10, SimulationFileHeader::primaryAngle), std::out_of_range);
+    EXPECT_THROW(reader.column(3, SimulationFileHeader::primaryAngle), std::out_of_range);
+
+    // the store can be moved, the mapping stays valid
+    const float* values = reader.values(7, SimulationFileHeader::hourLength);
+    ResultStore moved(std::move(store));
+    EXPECT_FALSE(store.isOpen());
+    EXPECT_EQ(std::as_const(moved).values(7, SimulationFileHeader::hourLength), values);
+    EXPECT_EQ(values[3], 73.f);
+    moved.close();
+    std::remove(fileName.c_str());
+}
+
+TEST_F(ResultStoreTest, BatchSolverWritesInPlace) {
+    TrackerArmature2A bluesolar(bluesolarGeometry());
+    TrackerSolver2Af solver(&bluesolar);
+
+    header.columns = 2;
+    header.heliostats = 100;
+    header.steps = 3;
+    header.chunkSteps = 2;
+    std::vector<float> sun(3*header.heliostats), aim(3*header.heliostats);
+    for (std::size_t i = 0; i < header.heliostats; ++i) {
+        double phi = (-60. + 1.2*i)*gcf::degree;
+        double r = 20. + 0.5*i;
+        aim[3*i] = float(-r*sin(phi));
+        aim[3*i + 1] = float(-r*cos(phi));
+        aim[3*i + 2] = 20.f;
+    }
+
+    std::string fileName = ::testing::TempDir() + "result_store_solver.bin";
+    std::vector<float> expected(2*header.heliostats*header.steps);
+    {
+        ResultStore store;
+        store.create(fileName, header);
+        for (std::uint64_t j = 0; j < header.steps; ++j) {
+            double elevation = (30. + 15.*j)*gcf::degree, azimuth = (120. + 30.*j)*gcf::degree;
+            for (std::size_t i = 0; i < header.heliostats; ++i) {
+                sun[3*i] = float(cos(elevation)*sin(azimuth));
+                sun[3*i + 1] = float(cos(elevation)*cos(azimuth));
+                sun[3*i + 2] = float(sin(elevation));
+            }
+            vec3fArrayView vSun = vec3fArrayView::interleaved(sun.data());
+            vec3fArrayView rAim = vec3fArrayView::interleaved(aim.data());
+            solver.solveBatch(header.heliostats, vSun, rAim, TrackerTarget::local, store.angles(j));
+            float* e = expected.data() + 2*header.heliostats*j;
+            solver.solveBatch(header.heliostats, vSun, rAim, TrackerTarget::local, vec2fArrayView::interleaved(e));
+        }
+    }
+
+    ResultStore store;
+    store.open(fileName);
+    for (std::uint64_t j = 0; j < header.steps; ++j) {
+        vec2ArrayView<const float> angles = std::as_const(store).angles(j);
+        for (std::size_t i = 0; i < header.heliostats; ++i) {
+            EXPECT_EQ(angles[i].x, expected[2*(header.heliostats*j + i)]);
+            EXPECT_EQ(angles[i].y, expected[2*(header.heliostats*j + i) + 1]);
+        }
+    }
+    store.close();
+    std::remove(fileName.c_str());
+}
+
+TEST_F(ResultStoreTest, RejectsInvalidFiles) {
+    ResultStore store;
+    EXPECT_THROW(store.open(::testing::TempDir() + "result_store_missing.bin"), std::runtime_error);
+    EXPECT_THROW(store.create("/nonexistent/directory/results.bin", header), std::runtime_error);
+
+    SimulationFileHeader invalid = header;
+    invalid.columns = 3;
+    std::string fileName = ::testing::TempDir() + "result_store_invalid.bin";
+    EXPECT_THROW(store.create(fileName, invalid), std::invalid_argument);
+
+    // a truncated file
+    store.create(fileName, header);
+    store.close();
+    {
+        std::ofstream file(fileName, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    EXPECT_THROW(store.open(fileName), std::runtime_error);
+    EXPECT_FALSE(store.isOpen());
+    std::remove(fileName.c_str());
+}
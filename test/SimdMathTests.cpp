@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <cmath>
+
+#include "gtest/gtest.h"
+
+#include "gcf.h"
+#include "SimdMath.h"
+
+#if HELIOSTAT_TRACKING_SIMD_X86
+
+HELIOSTAT_TRACKING_TARGET_AVX2
+static void atan2x4(const double* y, const double* x, double* ans)
+{
+    _mm256_storeu_pd(ans, simd::atan2(_mm256_loadu_pd(y), _mm256_loadu_pd(x)));
+}
+
+TEST(SimdMathTest, Atan2MatchesStd) {
+    if (!simd::hasAVX2()) GTEST_SKIP() << "AVX2 not supported";
+
+    double y[4], x[4], ans[4];
+    for (int i = 0; i < 1000; ++i) {
+        for (int n = 0; n < 4; ++n) {
+            double phi = (i*4 + n)*0.0031 - 2.*gcf::TwoPi;
+            double r = 1e-3 + 0.01*i;
+            y[n] = r*sin(phi);
+            x[n] = r*cos(phi);
+        }
+        atan2x4(y, x, ans);
+        for (int n = 0; n < 4; ++n)
+            EXPECT_NEAR(ans[n], std::atan2(y[n], x[n]), 1e-15);
+    }
+}
+
+TEST(SimdMathTest, Atan2SpecialValues) {
+    if (!simd::hasAVX2()) GTEST_SKIP() << "AVX2 not supported";
+
+    double y[4] = {0., 0., 1., -1.};
+    double x[4] = {0., -1., 0., 0.};
+    double ans[4];
+    atan2x4(y, x, ans);
+    EXPECT_EQ(ans[0], 0.);
+    EXPECT_DOUBLE_EQ(ans[1], gcf::Pi);
+    EXPECT_DOUBLE_EQ(ans[2], gcf::Pi/2.);
+    EXPECT_DOUBLE_EQ(ans[3], -gcf::Pi/2.);
+}
+
+// vector functions under test, load, compute and store are in one AVX2 function
+struct SimdSin { HELIOSTAT_TRACKING_TARGET_AVX2 __m256d operator()(__m256d x) const {return simd::sin(x);} };
+struct SimdCos { HELIOSTAT_TRACKING_TARGET_AVX2 __m256d operator()(__m256d x) const {return simd::cos(x);} };
+struct SimdAsin { HELIOSTAT_TRACKING_TARGET_AVX2 __m256d operator()(__m256d x) const {return simd::asin(x);} };
+struct SimdAcos { HELIOSTAT_TRACKING_TARGET_AVX2 __m256d operator()(__m256d x) const {return simd::acos(x);} };
+
+template<class Function>
+HELIOSTAT_TRACKING_TARGET_AVX2
+static void apply(const double* x, double* ans)
+{
+    _mm256_storeu_pd(ans, Function()(_mm256_loadu_pd(x)));
+}
+
+// largest difference to the std function over n points in [a, b]
+template<class Function>
+static double maxError(double (*g)(double), double a, double b, int n = 100000)
+{
+    double x[4], y[4];
+    double ans = 0.;
+    for (int i = 0; i < n; i += 4) {
+        for (int k = 0; k < 4; ++k)
+            x[k] = a + (b - a)*(i + k)/(n - 1);
+        apply<Function>(x, y);
+        for (int k = 0; k < 4; ++k)
+            ans = std::max(ans, std::abs(y[k] - g(x[k])));
+    }
+    return ans;
+}
+
+static double stdSin(double x) {return std::sin(x);}
+static double stdCos(double x) {return std::cos(x);}
+static double stdAsin(double x) {return std::asin(x);}
+static double stdAcos(double x) {return std::acos(x);}
+
+TEST(SimdMathTest, SinCosMatchStd) {
+    if (!simd::hasAVX2()) GTEST_SKIP() << "AVX2 not supported";
+
+    EXPECT_LT(maxError<SimdSin>(stdSin, -20., 20.), 2e-16);
+    EXPECT_LT(maxError<SimdCos>(stdCos, -20., 20.), 2e-16);
+}
+
+TEST(SimdMathTest, AsinAcosMatchStd) {
+    if (!simd::hasAVX2()) GTEST_SKIP() << "AVX2 not supported";
+
+    EXPECT_LT(maxError<SimdAsin>(stdAsin, -1., 1.), 5e-16);
+    EXPECT_LT(maxError<SimdAcos>(stdAcos, -1., 1.), 5e-16);
+
+    double x[4] = {1.5, -1.0000001, std::nan(""), 1.};
+    double y[4];
+    apply<SimdAsin>(x, y);
+    EXPECT_TRUE(std::isnan(y[0]));
+    EXPECT_TRUE(std::isnan(y[1]));
+    EXPECT_TRUE(std::isnan(y[2]));
+    EXPECT_DOUBLE_EQ(y[3], gcf::Pi/2.);
+    apply<SimdAcos>(x, y);
+    EXPECT_TRUE(std::isnan(y[0]));
+    EXPECT_TRUE(std::isnan(y[1]));
+    EXPECT_TRUE(std::isnan(y[2]));
+    EXPECT_EQ(y[3], 0.);
+}
+
+#endif
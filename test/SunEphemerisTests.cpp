@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "SunEphemeris.h"
+#include "SunPositionEngine.h"
+
+class SunEphemerisTest : public ::testing::Test {
+protected:
+    SunPositionEngine engine;
+    double start;
+
+    SunEphemerisTest(): engine(-2.358*gcf::degree, 37.094*gcf::degree) {
+        start = SunPositionEngine::toUnixTime(2024, 6, 1);
+    }
+};
+
+TEST_F(SunEphemerisTest, Range) {
+    SunEphemeris ephemeris(engine, start, start + 86400., 60.);
+    EXPECT_EQ(ephemeris.get_samples(), 1440u + 3u);
+    EXPECT_TRUE(ephemeris.contains(start));
+    EXPECT_TRUE(ephemeris.contains(start + 86400.));
+    EXPECT_FALSE(ephemeris.contains(start - 1.));
+    EXPECT_THROW(ephemeris.findSunVector(start + 86401.), std::out_of_range);
+    EXPECT_FALSE(SunEphemeris().contains(0.));
+    EXPECT_THROW(SunEphemeris(engine, start, start + 60., 0.), std::invalid_argument);
+}
+
+TEST_F(SunEphemerisTest, ErrorBounds) {
+    SunEphemeris minute(engine, start, start + 7.*86400., 60.);
+    EXPECT_LT(minute.findMaxError(engine), 1e-7);
+
+    SunEphemeris tenMinutes(engine, start, start + 7.*86400., 600.);
+    EXPECT_LT(tenMinutes.findMaxError(engine), 2e-6);
+}
+
+TEST_F(SunEphemerisTest, MatchesEngineAtSamples) {
+    SunEphemeris ephemeris(engine, start, start + 86400., 60.);
+    for (int i = 0; i <= 1440; i += 37) {
+        double time = start + 60.*i;
+        vec3d v = ephemeris.findSunVector(time);
+        vec3d expected = engine.findSunVector(time);
+        EXPECT_NEAR(v.x, expected.x, 1e-7);
+        EXPECT_NEAR(v.y, expected.y, 1e-7);
+        EXPECT_NEAR(v.z, expected.z, 1e-7);
+    }
+}
+
+TEST_F(SunEphemerisTest, ForYear) {
+    SunEphemeris ephemeris = SunEphemeris::forYear(engine, 2023, 3600.);
+    EXPECT_EQ(ephemeris.get_timeStart(), SunPositionEngine::toUnixTime(2023, 1, 1));
+    EXPECT_EQ(ephemeris.get_timeEnd(), SunPositionEngine::toUnixTime(2024, 1, 1));
+    EXPECT_EQ(ephemeris.get_samples(), 8760u + 3u);
+}
+
+TEST_F(SunEphemerisTest, SaveLoad) {
+    SunEphemeris ephemeris(engine, start, start + 86400., 300.);
+    std::string fileName = ::testing::TempDir() + "sun_ephemeris_test.bin";
+    ephemeris.save(fileName);
+    SunEphemeris loaded = SunEphemeris::load(fileName);
+    std::remove(fileName.c_str());
+
+    EXPECT_EQ(loaded.get_longitude(), ephemeris.get_longitude());
+    EXPECT_EQ(loaded.get_latitude(), ephemeris.get_latitude());
+    EXPECT_EQ(loaded.get_timeStart(), ephemeris.get_timeStart());
+    EXPECT_EQ(loaded.get_timeEnd(), ephemeris.get_timeEnd());
+    EXPECT_EQ(loaded.get_step(), ephemeris.get_step());
+    EXPECT_EQ(loaded.get_samples(), ephemeris.get_samples());
+    for (double time = start; time <= start + 86400.; time += 1234.)
+        EXPECT_EQ(loaded.findSunVector(time), ephemeris.findSunVector(time));
+
+    EXPECT_THROW(SunEphemeris::load(fileName), std::runtime_error);
+}
+
+TEST_F(SunEphemerisTest, BatchMatchesScalar) {
+    SunEphemeris ephemeris(engine, start, start + 86400., 60.);
+    std::vector<double> times;
+    for (int i = 0; i < 1001; ++i)
+        times.push_back(start + 86.4*i);
+    std::vector<double> vectors(3*times.size());
+    ephemeris.findSunVectors(times.size(), times.data(), vectors.data());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        vec3d v = ephemeris.findSunVector(times[i]);
+        EXPECT_EQ(vectors[3*i], v.x);
+        EXPECT_EQ(vectors[3*i + 1], v.y);
+        EXPECT_EQ(vectors[3*i + 2], v.z);
+    }
+    times[500] = start + 86401.;
+    EXPECT_THROW(ephemeris.findSunVectors(times.size(), times.data(), vectors.data()), std::out_of_range);
+}
+
+TEST_F(SunEphemerisTest, LoadCorruptedHeader) {
+    SunEphemeris ephemeris(engine, start, start + 3600., 60.);
+    std::string fileName = ::testing::TempDir() + "sun_ephemeris_corrupted.bin";
+    ephemeris.save(fileName);
+    std::ifstream in(fileName, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    // header: magic, version, longitude, latitude, timeStart, timeEnd, step and count
+    const std::size_t timeEndOffset = 8 + 4 + 3*8;
+    const std::size_t countOffset = timeEndOffset + 2*8;
+    auto loadModified = [&](std::size_t offset, const void* value, std::size_t size) {
+        std::string modified = data;
+        std::memcpy(&modified[offset], value, size);
+        std::ofstream out(fileName, std::ios::binary);
+        out.write(modified.data(), modified.size());
+        out.close();
+        return SunEphemeris::load(fileName);
+    };
+
+    // a count far beyond the file size
+    std::uint64_t count = std::uint64_t(1) << 60;
+    EXPECT_THROW(loadModified(countOffset, &count, sizeof(count)), std::runtime_error);
+    // a time range longer than the samples
+    double timeEnd = start + 7200.;
+    EXPECT_THROW(loadModified(timeEndOffset, &timeEnd, sizeof(timeEnd)), std::runtime_error);
+    timeEnd = start + 3600.;
+    EXPECT_NO_THROW(loadModified(timeEndOffset, &timeEnd, sizeof(timeEnd)));
+    std::remove(fileName.c_str());
+}
@@ -0,0 +1,76 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "gcf.h"
+#include "SimdMath.h"
+#include "SunPositionEngine.h"
+
+// Azimuth and zenith angles from the reference implementation of the PSA algorithm
+struct SunPositionCase {
+    int year, month, day;
+    double hours, minutes, seconds;
+    double longitude, latitude; // degrees
+    double azimuth, zenith; // radians
+};
+
+static const SunPositionCase cases[] = {
+    {2024, 6, 20, 12., 0., 0., -2.358, 37.094, 2.9545352202967758, 0.24198409145316921},
+    {2023, 12, 21, 9., 30., 15., -2.358, 37.094, 2.4799530299168855, 1.2379857216970038},
+    {2025, 3, 1, 15., 45., 0., 151.2, -33.87, 2.5496640648981543, 2.3171794568349218},
+    {2030, 9, 23, 6., 10., 0., 10., 60., 1.7903893997654401, 1.4478956855030936},
+    {2001, 1, 1, 0., 0., 0., 0., 0., 3.1766417973027798, 2.7397069636104949},
+};
+
+TEST(SunPositionEngineTest, ToUnixTime) {
+    EXPECT_EQ(SunPositionEngine::toUnixTime(1970, 1, 1), 0.);
+    EXPECT_EQ(SunPositionEngine::toUnixTime(2000, 1, 1, 12.), 946728000.);
+    EXPECT_EQ(SunPositionEngine::toUnixTime(2024, 2, 29, 23., 59., 59.5), 1709251199.5);
+    EXPECT_EQ(SunPositionEngine::toUnixTime(1969, 12, 31), -86400.);
+}
+
+TEST(SunPositionEngineTest, MatchesReferenceAlgorithm) {
+    for (const SunPositionCase& c : cases) {
+        SunPositionEngine engine(c.longitude*gcf::degree, c.latitude*gcf::degree);
+        double time = SunPositionEngine::toUnixTime(c.year, c.month, c.day, c.hours, c.minutes, c.seconds);
+        vec3d v = engine.findSunVector(time);
+        vec3d expected = vec3d::directionAE(c.azimuth, gcf::Pi/2. - c.zenith);
+        EXPECT_NEAR(v.x, expected.x, 1e-11);
+        EXPECT_NEAR(v.y, expected.y, 1e-11);
+        EXPECT_NEAR(v.z, expected.z, 1e-11);
+        EXPECT_NEAR(v.norm(), 1., 1e-15);
+    }
+}
+
+TEST(SunPositionEngineTest, BatchMatchesScalar) {
+    SunPositionEngine engine(-2.358*gcf::degree, 37.094*gcf::degree);
+    std::vector<double> times;
+    for (int i = 0; i < 1003; ++i)
+        times.push_back(SunPositionEngine::toUnixTime(2024, 1, 1) + 3217.3*i);
+    std::vector<double> vectors(3*times.size());
+
+    // AVX2 kernel where available, its sines and cosines differ from std::sin and std::cos in the last bits,
+    // the last 3 times go through the scalar tail
+    engine.findSunVectors(times.size(), times.data(), vectors.data());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        vec3d expected = engine.findSunVector(times[i]);
+        EXPECT_NEAR(vectors[3*i], expected.x, 1e-14);
+        EXPECT_NEAR(vectors[3*i + 1], expected.y, 1e-14);
+        EXPECT_NEAR(vectors[3*i + 2], expected.z, 1e-14);
+    }
+
+    // scalar path
+    simd::enableAVX2(false);
+    engine.findSunVectors(times.size(), times.data(), vectors.data());
+    simd::enableAVX2(true);
+    for (std::size_t i = 0; i < times.size(); ++i)
+        EXPECT_EQ(vec3d(vectors[3*i], vectors[3*i + 1], vectors[3*i + 2]), engine.findSunVector(times[i]));
+}
+
+TEST(SunPositionEngineTest, NoonSunIsSouthInTheNorth) {
+    // Almeria, around solar noon on the June solstice
+    SunPositionEngine engine(-2.358*gcf::degree, 37.094*gcf::degree);
+    vec3d v = engine.findSunVector(SunPositionEngine::toUnixTime(2024, 6, 20, 12., 10.));
+    EXPECT_LT(v.y, 0.);
+    EXPECT_NEAR(v.x, 0., 0.01);
+    EXPECT_NEAR(asin(v.z)/gcf::degree, 90. - 37.094 + 23.44, 0.2);
+}
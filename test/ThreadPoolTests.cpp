@@ -0,0 +1,72 @@
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "ThreadPool.h"
+
+TEST(ThreadPoolTest, ThreadCount) {
+    ThreadPool single(1);
+    EXPECT_EQ(single.get_threads(), 1);
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.get_threads(), 4);
+    ThreadPool hardware;
+    EXPECT_GE(hardware.get_threads(), 1);
+}
+
+TEST(ThreadPoolTest, ParallelForCoversEachIndexOnce) {
+    ThreadPool pool(4);
+    for (std::size_t count : {0, 1, 7, 100, 10007}) {
+        std::vector<std::atomic<int>> hits(count);
+        pool.parallelFor(count, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                ++hits[i];
+        });
+        for (std::size_t i = 0; i < count; ++i)
+            EXPECT_EQ(hits[i], 1);
+    }
+}
+
+TEST(ThreadPoolTest, ParallelForRespectsGrain) {
+    ThreadPool pool(4);
+    std::atomic<std::size_t> smallest(1000);
+    pool.parallelFor(1000, [&](std::size_t begin, std::size_t end) {
+        if (end < 1000 && end - begin < smallest) smallest = end - begin;
+    }, 300);
+    EXPECT_GE(smallest, 300u);
+}
+
+TEST(ThreadPoolTest, ParallelForRethrows) {
+    ThreadPool pool(4);
+    EXPECT_THROW(pool.parallelFor(1000, [](std::size_t begin, std::size_t end) {
+        if (begin <= 500 && 500 < end) throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
+
+    // the pool remains usable
+    std::atomic<std::size_t> total(0);
+    pool.parallelFor(1000, [&](std::size_t begin, std::size_t end) {total += end - begin;});
+    EXPECT_EQ(total, 1000u);
+}
+
+TEST(ThreadPoolTest, ConcurrentAndNestedCalls) {
+    ThreadPool pool(4);
+    std::vector<std::atomic<int>> hits(4000);
+    auto loop = [&](std::size_t offset) {
+        pool.parallelFor(1000, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i)
+                ++hits[offset + i];
+        });
+    };
+
+    std::thread other([&] {loop(0);});
+    loop(1000);
+    other.join();
+
+    pool.parallelFor(2, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i)
+            loop(2000 + 1000*i);
+    }, 1);
+
+    for (std::size_t i = 0; i < hits.size(); ++i)
+        EXPECT_EQ(hits[i], 1);
+}
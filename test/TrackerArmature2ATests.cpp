@@ -1,8 +1,13 @@
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 #include "TrackerArmature2A.h"
 #include "TrackerSolver2A.h"
 #include "TrackerTarget.h"
+#include "Transform.h"
+#include "Bluesolar.h"
 
 class TrackerArmature2ATest : public ::testing::Test {  
  
@@ -105,3 +110,197 @@ TEST_F(TrackerArmature2ATest, SetAnglesDefault) {
     m_pArmature->set_anglesDefault(newValue);
     EXPECT_EQ(m_pArmature->get_anglesDefault(), newValue);
 }
+
+TEST_F(TrackerArmature2ATest, UpdateBatchMatchesUpdate) {
+    m_pArmature->set_geometry(bluesolarGeometry());
+
+    double sunElevation = 70.0*gcf::degree;
+    double sunAzimuth = 150.0*gcf::degree;
+    vec3d vSun(cos(sunElevation)*sin(sunAzimuth), cos(sunElevation)*cos(sunAzimuth), sin(sunElevation));
+    vec3d rAim(0.0, 0.0, 20.0);
+
+    const std::size_t n = 6;
+    double sx[n], sy[n], sz[n], ax[n], ay[n], az[n], angles[2*n];
+    std::vector<vec2d> expected;
+    for (std::size_t i = 0; i < n; ++i) {
+        Transform location = Transform::translate(-15.0 + 6.0*i, 40.0 + 5.0*i, 0.0);
+        TrackerTarget target;
+        target.aimingPoint = rAim;
+        m_pArmature->update(location, vSun, &target);
+        expected.push_back(target.angles);
+
+        Transform toLocal = location.inversed();
+        vec3d vSunL = toLocal.transformVector(vSun);
+        vec3d rAimL = toLocal.transformPoint(rAim);
+        sx[i] = vSunL.x; sy[i] = vSunL.y; sz[i] = vSunL.z;
+        ax[i] = rAimL.x; ay[i] = rAimL.y; az[i] = rAimL.z;
+    }
+
+    m_pArmature->updateBatch(n, vec3dArrayView(sx, sy, sz), vec3dArrayView(ax, ay, az),
+                             TrackerTarget::global, vec2dArrayView::interleaved(angles));
+
+    for (std::size_t i = 0; i < n; ++i) {
+        EXPECT_DOUBLE_EQ(angles[2*i], expected[i].x);
+        EXPECT_DOUBLE_EQ(angles[2*i + 1], expected[i].y);
+    }
+}
+
+TEST_F(TrackerArmature2ATest, CompiledArmatureFollowsSetters) {
+    m_pArmature->set_primaryAxis(vec3d(-2.0, 0.0, 0.0));
+    m_pArmature->set_secondaryAxis(vec3d(0.0, 0.0, -1.0));
+    m_pArmature->set_secondaryAngles(vec2d(-70.0, 55.0));
+    m_pArmature->set_facetShift(vec3d(0., -0.105, 0.035));
+
+    const CompiledArmature2A& c = m_pArmature->get_compiled();
+    EXPECT_EQ(c.a, vec3d(-1.0, 0.0, 0.0));
+    EXPECT_EQ(c.b, vec3d(0.0, 0.0, -1.0));
+    EXPECT_EQ(c.k, cross(c.a, c.b));
+    EXPECT_DOUBLE_EQ(c.ab, 0.0);
+    EXPECT_DOUBLE_EQ(c.k2Inv, 1.0);
+    EXPECT_DOUBLE_EQ(c.detInv, 1.0);
+    EXPECT_FALSE(c.degenerate);
+    EXPECT_DOUBLE_EQ(c.secondaryAngles.min(), -70.0*gcf::degree);
+    EXPECT_DOUBLE_EQ(c.secondaryAngles.max(), 55.0*gcf::degree);
+    EXPECT_EQ(c.facetPoint0, m_pArmature->get_solver()->findFacetPoint(c.angles0));
+
+    m_pArmature->set_secondaryAxis(vec3d(1.0, 0.0, 0.0));
+    EXPECT_TRUE(m_pArmature->get_compiled().degenerate);
+}
+
+TEST_F(TrackerArmature2ATest, ConstructorMatchesSetters) {
+    TrackerArmature2A::Geometry g = bluesolarGeometry();
+    m_pArmature->set_geometry(g);
+    m_pArmature->set_anglesDefault(vec2d(45.0, 0.0));
+    TrackerArmature2A armature(g.primaryShift, g.primaryAxis, g.primaryAngles,
+                               g.secondaryShift, g.secondaryAxis, g.secondaryAngles,
+                               g.facetShift, g.facetNormal, vec2d(45.0, 0.0));
+
+    const CompiledArmature2A& c = armature.get_compiled();
+    const CompiledArmature2A& expected = m_pArmature->get_compiled();
+    EXPECT_EQ(c.a, expected.a);
+    EXPECT_EQ(c.b, expected.b);
+    EXPECT_EQ(c.primaryShift, expected.primaryShift);
+    EXPECT_EQ(c.secondaryShift, expected.secondaryShift);
+    EXPECT_EQ(c.facetShift, expected.facetShift);
+    EXPECT_EQ(c.facetNormal, expected.facetNormal);
+    EXPECT_EQ(c.secondaryAngles.min(), expected.secondaryAngles.min());
+    EXPECT_EQ(c.angles0, expected.angles0);
+    EXPECT_EQ(c.facetPoint0, expected.facetPoint0);
+    EXPECT_EQ(armature.get_anglesDefault(), vec2d(45.0, 0.0));
+}
+
+TEST_F(TrackerArmature2ATest, SettersRebuildLazily) {
+    EXPECT_FALSE(m_pArmature->isModified());
+    m_pArmature->set_geometry(bluesolarGeometry());
+    EXPECT_TRUE(m_pArmature->isModified());
+    EXPECT_EQ(m_pArmature->get_secondaryAxis(), vec3d(0.0, 0.0, -1.0));
+
+    // the first use rebuilds the derived state once
+    const CompiledArmature2A& c = m_pArmature->get_compiled();
+    EXPECT_FALSE(m_pArmature->isModified());
+    EXPECT_EQ(c.b, vec3d(0.0, 0.0, -1.0));
+    EXPECT_EQ(m_pArmature->get_primary().shift, vec3d(0.0, 0.0, 2.415));
+    EXPECT_EQ(c.facetPoint0, m_pArmature->get_solver()->findFacetPoint(c.angles0));
+
+    // the solvers rebuild before solving
+    m_pArmature->set_facetShift(vec3d(0., -0.2, 0.035));
+    EXPECT_TRUE(m_pArmature->isModified());
+    EXPECT_EQ(m_pArmature->get_solver()->findFacetPoint(vec2d(0., 0.)), vec3d(0.0, -0.2816, 2.45));
+    EXPECT_FALSE(m_pArmature->isModified());
+}
+
+TEST_F(TrackerArmature2ATest, SetGeometry) {
+    m_pArmature->set_geometry(bluesolarGeometry());
+    TrackerArmature2A::Geometry g = m_pArmature->get_geometry();
+    EXPECT_EQ(g.primaryShift, vec3d(0.0, 0.0, 2.415));
+    EXPECT_EQ(g.secondaryAngles, vec2d(-70.0, 55.0));
+    EXPECT_EQ(g.facetNormal, vec3d(0.0, -1.0, 0.0));
+
+    TrackerArmature2A armature(g);
+    EXPECT_EQ(armature.get_compiled().facetPoint0, m_pArmature->get_compiled().facetPoint0);
+
+    g.primaryShift.z = 3.0;
+    g.anglesDefault = vec2d(30.0, 0.0);
+    armature.set_geometry(g);
+    EXPECT_TRUE(armature.isModified());
+    EXPECT_EQ(armature.get_primaryShift(), vec3d(0.0, 0.0, 3.0));
+    EXPECT_EQ(armature.get_angles0(), vec2d(30.0, 0.0)*gcf::degree);
+    EXPECT_EQ(armature.get_compiled().primaryShift, vec3d(0.0, 0.0, 3.0));
+}
+
+TEST_F(TrackerArmature2ATest, ConcurrentRebuild) {
+    m_pArmature->set_geometry(bluesolarGeometry());
+    TrackerArmature2A reference(m_pArmature->get_geometry());
+    vec3d expected = reference.get_compiled().facetPoint0;
+
+    // the threads using a modified armature rebuild it once and all see the new state
+    std::vector<vec3d> points(8);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < points.size(); ++t)
+        threads.emplace_back([&, t] { points[t] = m_pArmature->get_compiled().facetPoint0; });
+    for (std::thread& thread : threads)
+        thread.join();
+    for (const vec3d& point : points)
+        EXPECT_EQ(point, expected);
+}
+
+TEST_F(TrackerArmature2ATest, WarmStartTracking) {
+    m_pArmature->set_geometry(bluesolarGeometry());
+    Transform location = Transform::translate(12.0, 45.0, 0.0);
+
+    TrackerTarget cold;
+    cold.aimingPoint = vec3d(0.0, 0.0, 20.0);
+    TrackerTarget warm = cold;
+    warm.warmStart = true;
+    warm.measureIterations = true;
+
+    int iterationsCold = 0;
+    int iterationsWarm = 0;
+    double rate = 7.27e-5; // sun angular speed in rad/s
+    for (int t = 0; t < 60; ++t) {
+        double sunAzimuth = 150.0*gcf::degree + 2.*rate*t;
+        double sunElevation = 60.0*gcf::degree + rate*t;
+        vec3d vSun = vec3d::directionAE(sunAzimuth, sunElevation);
+
+        m_pArmature->update(location, vSun, &cold);
+        m_pArmature->update(location, vSun, &warm);
+        EXPECT_NEAR(warm.angles.x, cold.angles.x, 1e-3);
+        EXPECT_NEAR(warm.angles.y, cold.angles.y, 1e-3);
+        EXPECT_TRUE(warm.tracking);
+
+        iterationsCold += cold.iterations;
+        iterationsWarm += warm.iterations;
+        if (t > 0) {
+            EXPECT_LE(warm.iterations, warm.iterationsCold);
+            EXPECT_EQ(warm.iterationsSaved(), warm.iterationsCold - warm.iterations);
+        }
+    }
+    EXPECT_LT(iterationsWarm, iterationsCold);
+
+    // the cold count of a warm update is for the same inputs
+    vec3d vSun = vec3d::directionAE(151.0*gcf::degree, 60.5*gcf::degree);
+    m_pArmature->update(location, vSun, &cold);
+    m_pArmature->update(location, vSun, &warm);
+    EXPECT_EQ(warm.iterationsCold, cold.iterations);
+
+    // not measured
+    warm.measureIterations = false;
+    m_pArmature->update(location, vSun, &warm);
+    EXPECT_EQ(warm.iterationsCold, -1);
+    EXPECT_EQ(warm.iterationsSaved(), 0);
+
+    // a new aiming point starts cold
+    warm.aimingPoint = vec3d(0.0, 5.0, 25.0);
+    cold.aimingPoint = warm.aimingPoint;
+    m_pArmature->update(location, vSun, &warm);
+    m_pArmature->update(location, vSun, &cold);
+    EXPECT_EQ(warm.iterations, cold.iterations);
+    EXPECT_EQ(warm.iterationsCold, warm.iterations);
+    EXPECT_EQ(warm.iterationsSaved(), 0);
+    EXPECT_TRUE(warm.tracking);
+    EXPECT_EQ(warm.trackedAimingPoint, warm.aimingPoint);
+
+    warm.aimingType = TrackerTarget::local;
+    m_pArmature->update(location, vSun, &warm);
+    EXPECT_EQ(warm.trackedAimingType, TrackerTarget::local);
+}
@@ -1,6 +1,12 @@
+#include <cmath>
+
 #include <gtest/gtest.h>
+#include "gcf.h"
+#include "SimdMath.h"
 #include "TrackerSolver2A.h"
+#include "Transform.h"
 #include "vec3d.h"
+#include "Bluesolar.h"
 #include <memory>
 
 class TrackerSolver2ATest : public ::testing::Test {
@@ -60,3 +66,299 @@ TEST_F(TrackerSolver2ATest, SelectSolution) {
     EXPECT_NE(result.x, 0);
     EXPECT_NE(result.y, 0);
 }
+
+// rotation of v by the angles of the default armature: secondary axis x, then primary axis -z
+static vec3d rotateDefault(const Angles& angles, const vec3d& v) {
+    auto rotate = [](const vec3d& a, double angle, const vec3d& v) {
+        return v*cos(angle) + cross(a, v)*sin(angle) + a*(dot(a, v)*(1. - cos(angle)));
+    };
+    return rotate(vec3d(0., 0., -1.), angles.x, rotate(vec3d(1., 0., 0.), angles.y, v));
+}
+
+// true if one of the solutions is angles, up to full turns
+static bool hasSolution(const Solutions2A& solutions, const Angles& angles) {
+    for (const Angles& s : solutions)
+        if (std::abs(std::remainder(s.x - angles.x, gcf::TwoPi)) < 1e-9 &&
+            std::abs(std::remainder(s.y - angles.y, gcf::TwoPi)) < 1e-9)
+            return true;
+    return false;
+}
+
+// known angles inside the joint ranges of the default armature
+static const Angles knownAngles[] = {
+    Angles(-150.*gcf::degree, -60.*gcf::degree),
+    Angles(-40.*gcf::degree, 25.*gcf::degree),
+    Angles(10.*gcf::degree, 5.*gcf::degree),
+    Angles(95.*gcf::degree, 80.*gcf::degree)
+};
+
+TEST_F(TrackerSolver2ATest, SolveRotationFixedFindsKnownAngles) {
+    vec3d v0 = vec3d(0.2, 1., 0.3).normalized();
+    for (const Angles& angles : knownAngles) {
+        vec3d v = rotateDefault(angles, v0);
+        Solutions2A results;
+        solver->solveRotation(v0, v, results);
+        EXPECT_TRUE(hasSolution(results, angles));
+        for (const Angles& s : results)
+            EXPECT_LT((rotateDefault(s, v0) - v).norm(), 1e-12);
+        EXPECT_TRUE(hasSolution(results, solver->selectSolution(results)));
+    }
+}
+
+TEST_F(TrackerSolver2ATest, SolveFacetNormalFixedFindsKnownAngles) {
+    vec3d n0 = armature.get_facetNormal();
+    for (const Angles& angles : knownAngles) {
+        vec3d n = rotateDefault(angles, n0);
+        Solutions2A results;
+        solver->solveFacetNormal(n, results);
+        EXPECT_TRUE(hasSolution(results, angles));
+        for (const Angles& s : results)
+            EXPECT_LT((rotateDefault(s, n0) - n).norm(), 1e-12);
+    }
+}
+
+TEST_F(TrackerSolver2ATest, SolveReflectionGlobalFixedFindsKnownAngles) {
+    // the facet is at the origin for every angle, the aiming point is along the reflected ray
+    for (const Angles& angles : knownAngles) {
+        vec3d n = rotateDefault(angles, armature.get_facetNormal());
+        vec3d vSun = (n + rotateDefault(angles, vec3d(0.3, 0., 0.4))).normalized();
+        vec3d rAim = (2.*dot(n, vSun)*n - vSun)*50.;
+        Solutions2A results;
+        SolverStatus2A status = solver->solveReflectionGlobal(vSun, rAim, results);
+        EXPECT_EQ(status.convergence, SolverStatus2A::converged);
+        EXPECT_TRUE(hasSolution(results, angles));
+    }
+}
+
+TEST_F(TrackerSolver2ATest, SolveReflectionSecondaryFixedFindsKnownAngles) {
+    // the aiming point is given in the frame of the facet at zero angles
+    vec3d n0 = armature.get_facetNormal();
+    vec3d vSun0 = (n0 + vec3d(0.3, 0., 0.4)).normalized();
+    vec3d rAim = (2.*dot(n0, vSun0)*n0 - vSun0)*50.;
+    for (const Angles& angles : knownAngles) {
+        Solutions2A results;
+        solver->solveReflectionSecondary(rotateDefault(angles, vSun0), rAim, results);
+        EXPECT_TRUE(hasSolution(results, angles));
+    }
+}
+
+class TrackerSolver2ANewtonTest : public ::testing::Test {
+protected:
+    // Bluesolar heliostat armature, with non-zero secondary and facet shifts
+    TrackerArmature2A armature{bluesolarGeometry()};
+    TrackerSolver2A* solver;
+
+    void SetUp() override {
+        solver = armature.get_solver();
+        solver->set_tolerance(1e-9);
+        solver->set_iterationsMax(50);
+    }
+};
+
+TEST_F(TrackerSolver2ANewtonTest, MatchesFixedPoint) {
+    vec3d vSun = vec3d::directionAE(150.*gcf::degree, 50.*gcf::degree);
+    vec3d rAim(-4.0, -15.0, 18.0);
+
+    Solutions2A fixedPoint;
+    SolverStatus2A statusFixedPoint = solver->solveReflectionGlobal(vSun, rAim, fixedPoint);
+    solver->set_method(TrackerSolver2A::newton);
+    Solutions2A newton;
+    SolverStatus2A statusNewton = solver->solveReflectionGlobal(vSun, rAim, newton);
+
+    EXPECT_EQ(statusFixedPoint.convergence, SolverStatus2A::converged);
+    EXPECT_EQ(statusNewton.convergence, SolverStatus2A::converged);
+    EXPECT_LT(statusNewton.iterations, statusFixedPoint.iterations);
+    ASSERT_EQ(newton.size(), fixedPoint.size());
+    for (int i = 0; i < newton.size(); ++i) {
+        EXPECT_NEAR(gcf::normalizeAngle(newton[i].x - fixedPoint[i].x, -gcf::Pi), 0., 1e-7);
+        EXPECT_NEAR(gcf::normalizeAngle(newton[i].y - fixedPoint[i].y, -gcf::Pi), 0., 1e-7);
+    }
+}
+
+TEST_F(TrackerSolver2ANewtonTest, ReflectsOntoAimingPoint) {
+    solver->set_method(TrackerSolver2A::newton);
+    vec3d vSun = vec3d::directionAE(100.*gcf::degree, 20.*gcf::degree);
+    vec3d rAim(3.0, -8.0, 12.0);
+
+    Solutions2A solutions;
+    SolverStatus2A status = solver->solveReflectionGlobal(vSun, rAim, solutions);
+    ASSERT_EQ(status.convergence, SolverStatus2A::converged);
+    ASSERT_FALSE(solutions.empty());
+
+    for (const Angles& angles : solutions) {
+        vec3d rFacet = solver->findFacetPoint(angles);
+        Transform rotation = armature.get_primary().getTransform(angles.x)*armature.get_secondary().getTransform(angles.y);
+        vec3d normal = rotation.transformVector(armature.get_facet().normal);
+        vec3d reflected = -vSun.reflected(normal);
+        EXPECT_LT(cross(rAim - rFacet, reflected).norm(), 1e-9);
+    }
+}
+
+TEST_F(TrackerSolver2ANewtonTest, ReportsNonConvergence) {
+    vec3d vSun = vec3d::directionAE(150.*gcf::degree, 50.*gcf::degree);
+    vec3d rAim(-4.0, -15.0, 18.0);
+    solver->set_tolerance(1e-12);
+    solver->set_iterationsMax(1);
+
+    Solutions2A solutions;
+    SolverStatus2A status = solver->solveReflectionGlobal(vSun, rAim, solutions);
+    EXPECT_EQ(status.convergence, SolverStatus2A::notConverged);
+    EXPECT_TRUE(solutions.empty());
+
+    solver->set_method(TrackerSolver2A::newton);
+    status = solver->solveReflectionGlobal(vSun, rAim, solutions);
+    EXPECT_EQ(status.convergence, SolverStatus2A::notConverged);
+    EXPECT_EQ(status.iterations, 2);
+}
+
+class TrackerSolver2ABatchTest : public ::testing::Test {
+protected:
+    TrackerArmature2A armature{bluesolarGeometry()};
+    std::vector<double> v0, v;
+
+    void SetUp() override {
+        // directions over the sphere, some of them are not reachable by the armature
+        const std::size_t n = 103;
+        for (std::size_t i = 0; i < n; ++i) {
+            vec3d a = vec3d::directionAE(37.*i*gcf::degree, (-80. + 1.6*i)*gcf::degree);
+            vec3d b = vec3d::directionAE(-11.*i*gcf::degree, (85. - 1.3*i)*gcf::degree);
+            v0.insert(v0.end(), {a.x, a.y, a.z});
+            v.insert(v.end(), {b.x, b.y, b.z});
+        }
+    }
+
+    void TearDown() override {
+        simd::enableAVX2(true);
+    }
+
+    // solves the rotations with solveRotationBatch and checks them against solveRotation
+    void expectBatchMatchesScalar() {
+        const TrackerSolver2A& solver = *armature.get_solver();
+        const std::size_t n = v.size()/3;
+        std::vector<Solutions2A> results(n);
+        solver.solveRotationBatch(n, vec3dArrayView::interleaved(v0.data()), vec3dArrayView::interleaved(v.data()), results.data());
+
+        int reachable = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            Solutions2A expected;
+            solver.solveRotation(vec3d(v0[3*i], v0[3*i + 1], v0[3*i + 2]), vec3d(v[3*i], v[3*i + 1], v[3*i + 2]), expected);
+            ASSERT_EQ(results[i].size(), expected.size());
+            for (int s = 0; s < expected.size(); ++s) {
+                EXPECT_NEAR(results[i][s].x, expected[s].x, 1e-12);
+                EXPECT_NEAR(results[i][s].y, expected[s].y, 1e-12);
+            }
+            reachable += !expected.empty();
+        }
+        EXPECT_GT(reachable, 0);
+        EXPECT_LT(reachable, static_cast<int>(n));
+    }
+};
+
+TEST_F(TrackerSolver2ABatchTest, SolveRotationBatchMatchesScalar) {
+    // AVX2 kernel where available, the last 3 directions go through the scalar tail
+    expectBatchMatchesScalar();
+}
+
+TEST_F(TrackerSolver2ABatchTest, SolveRotationBatchScalarFallback) {
+    simd::enableAVX2(false);
+    EXPECT_FALSE(simd::hasAVX2());
+    expectBatchMatchesScalar();
+}
+
+class TrackerSolver2AfTest : public ::testing::Test {
+protected:
+    TrackerArmature2A bluesolar{bluesolarGeometry()};
+    TrackerArmature2A azimuthElevation;
+
+    // Largest pointing error in radians over a grid of sun positions,
+    // the angles found by the solver are evaluated with the double model.
+    template<class T>
+    static double pointingErrorMax(TrackerArmature2A& armature, const TrackerSolver2AT<T>& solver, const vec3d& rAim, int& solved)
+    {
+        const TrackerSolver2A& exact = *armature.get_solver();
+        double errorMax = 0.;
+        solved = 0;
+        for (int i = 0; i < 12; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                vec3d vSun = vec3d::directionAE((60. + 20.*i)*gcf::degree, (10. + 10.*j)*gcf::degree);
+                Solutions2AT<T> solutions;
+                SolverStatus2A status = solver.solveReflectionGlobal(vec3<T>(vSun), vec3<T>(rAim), solutions);
+                if (status.convergence != SolverStatus2A::converged) continue;
+                for (const vec2<T>& anglesT : solutions) {
+                    vec2d angles(anglesT);
+                    vec3d rFacet = exact.findFacetPoint(angles);
+                    Transform rotation = armature.get_primary().getTransform(angles.x)*armature.get_secondary().getTransform(angles.y);
+                    vec3d normal = rotation.transformVector(armature.get_facet().normal);
+                    vec3d reflected = -vSun.reflected(normal);
+                    errorMax = std::max(errorMax, cross((rAim - rFacet).normalized(), reflected).norm());
+                }
+                ++solved;
+            }
+        }
+        return errorMax;
+    }
+};
+
+TEST_F(TrackerSolver2AfTest, PointingErrorBluesolar) {
+    vec3d rAim(-4.0, -15.0, 18.0);
+    TrackerSolver2A solver(&bluesolar);
+    solver.set_tolerance(1e-9);
+    solver.set_iterationsMax(50);
+    TrackerSolver2Af solverFloat(&bluesolar);
+    solverFloat.set_tolerance(1e-5);
+    solverFloat.set_iterationsMax(50);
+
+    int solved, solvedFloat;
+    double error = pointingErrorMax(bluesolar, solver, rAim, solved);
+    double errorFloat = pointingErrorMax(bluesolar, solverFloat, rAim, solvedFloat);
+    EXPECT_GT(solved, 0);
+    EXPECT_EQ(solvedFloat, solved);
+    EXPECT_LT(error, 1e-9);
+    // float keeps the pointing error below a microradian or so, double at rounding level
+    EXPECT_LT(errorFloat, 2e-6);
+}
+
+TEST_F(TrackerSolver2AfTest, PointingErrorAzimuthElevation) {
+    vec3d rAim(10.0, 40.0, 25.0);
+    TrackerSolver2A solver(&azimuthElevation);
+    solver.set_tolerance(1e-9);
+    TrackerSolver2Af solverFloat(&azimuthElevation);
+    solverFloat.set_tolerance(1e-5);
+
+    int solved, solvedFloat;
+    double error = pointingErrorMax(azimuthElevation, solver, rAim, solved);
+    double errorFloat = pointingErrorMax(azimuthElevation, solverFloat, rAim, solvedFloat);
+    EXPECT_GT(solved, 0);
+    EXPECT_EQ(solvedFloat, solved);
+    EXPECT_LT(error, 1e-9);
+    EXPECT_LT(errorFloat, 2e-6);
+}
+
+TEST_F(TrackerSolver2AfTest, SolveRotationBatchMatchesScalar) {
+    TrackerSolver2Af solver(&bluesolar);
+    const std::size_t n = 103;
+    std::vector<float> v0(3*n), v(3*n);
+    for (std::size_t i = 0; i < n; ++i) {
+        vec3f a(vec3d::directionAE(37.*i*gcf::degree, (-80. + 1.6*i)*gcf::degree));
+        vec3f b(vec3d::directionAE(-11.*i*gcf::degree, (85. - 1.3*i)*gcf::degree));
+        v0[3*i] = a.x; v0[3*i + 1] = a.y; v0[3*i + 2] = a.z;
+        v[3*i] = b.x; v[3*i + 1] = b.y; v[3*i + 2] = b.z;
+    }
+
+    std::vector<Solutions2Af> results(n);
+    solver.solveRotationBatch(n, vec3fArrayView::interleaved(v0.data()), vec3fArrayView::interleaved(v.data()), results.data());
+
+    int reachable = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Solutions2Af expected;
+        solver.solveRotation(vec3f(v0[3*i], v0[3*i + 1], v0[3*i + 2]), vec3f(v[3*i], v[3*i + 1], v[3*i + 2]), expected);
+        ASSERT_EQ(results[i].size(), expected.size());
+        for (int s = 0; s < expected.size(); ++s) {
+            EXPECT_NEAR(results[i][s].x, expected[s].x, 1e-5);
+            EXPECT_NEAR(results[i][s].y, expected[s].y, 1e-5);
+        }
+        reachable += !expected.empty();
+    }
+    EXPECT_GT(reachable, 0);
+    EXPECT_LT(reachable, static_cast<int>(n));
+}
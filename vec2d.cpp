@@ -2,25 +2,28 @@
 
 #include "gcf.h"
 
-const vec2d vec2d::Zero(0., 0.);
-const vec2d vec2d::One(1., 1.);
-const vec2d vec2d::UnitX(1., 0.);
-const vec2d vec2d::UnitY(0., 1.);
+template<class T>
+const vec2<T> vec2<T>::Zero(0, 0);
+template<class T>
+const vec2<T> vec2<T>::One(1, 1);
+template<class T>
+const vec2<T> vec2<T>::UnitX(1, 0);
+template<class T>
+const vec2<T> vec2<T>::UnitY(0, 1);
 
-bool vec2d::operator==(const vec2d& v) const
+template<class T>
+bool vec2<T>::operator==(const vec2& v) const
 {
     if (this == &v) return true;
 
     return gcf::equals(x, v.x) && gcf::equals(y, v.y);
 }
 
-bool vec2d::operator!=(const vec2d& v) const
+template<class T>
+bool vec2<T>::operator!=(const vec2& v) const
 {
     return !(*this == v);
 }
 
-std::ostream& operator<<(std::ostream& os, const vec2d& v)
-{
-    os << v.x << ", " << v.y;
-    return os;
-}
+template struct vec2<double>;
+template struct vec2<float>;
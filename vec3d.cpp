@@ -2,25 +2,33 @@
 
 #include "gcf.h"
 
-const vec3d vec3d::Zero(0., 0., 0.);
-const vec3d vec3d::One(1., 1., 1.);
-const vec3d vec3d::UnitX(1., 0., 0.);
-const vec3d vec3d::UnitY(0., 1., 0.);
-const vec3d vec3d::UnitZ(0., 0., 1.);
+template<class T>
+const vec3<T> vec3<T>::Zero(0, 0, 0);
+template<class T>
+const vec3<T> vec3<T>::One(1, 1, 1);
+template<class T>
+const vec3<T> vec3<T>::UnitX(1, 0, 0);
+template<class T>
+const vec3<T> vec3<T>::UnitY(0, 1, 0);
+template<class T>
+const vec3<T> vec3<T>::UnitZ(0, 0, 1);
 
-bool vec3d::operator==(const vec3d& v) const
+template<class T>
+bool vec3<T>::operator==(const vec3& v) const
 {
     return gcf::equals(x, v.x) &&
            gcf::equals(y, v.y) &&
            gcf::equals(z, v.z);
 }
 
-bool vec3d::operator!=(const vec3d& v) const
+template<class T>
+bool vec3<T>::operator!=(const vec3& v) const
 {
     return !(*this == v);
 }
 
-int vec3d::maxDimension() const
+template<class T>
+int vec3<T>::maxDimension() const
 {
     if (x > y && x > z)
         return 0;
@@ -29,18 +37,16 @@ int vec3d::maxDimension() const
     return 2;
 }
 
-vec3d vec3d::directionAE(double azimuth, double elevation)// in radians
+template<class T>
+vec3<T> vec3<T>::directionAE(T azimuth, T elevation)// in radians
 {
-    double cosAlpha = cos(elevation);
-    return vec3d(
-        cosAlpha*sin(azimuth),
-        cosAlpha*cos(azimuth),
-        sin(elevation)
+    T cosAlpha = std::cos(elevation);
+    return vec3(
+        cosAlpha*std::sin(azimuth),
+        cosAlpha*std::cos(azimuth),
+        std::sin(elevation)
     );
 }
 
-std::ostream& operator<<(std::ostream& os, const vec3d& v)
-{
-    os << v.x << ", " << v.y << ", " << v.z;
-    return os;
-}
+template struct vec3<double>;
+template struct vec3<float>;